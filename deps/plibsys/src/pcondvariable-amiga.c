@@ -24,6 +24,7 @@
  */
 
 #include "pcondvariable.h"
+#include "puthread.h"
 #include "patomic.h"
 #include "pmem.h"
 #include "pspinlock.h"
@@ -138,6 +139,33 @@ p_cond_variable_wait (PCondVariable	*cond,
 	return TRUE;
 }
 
+P_LIB_API pboolean
+p_cond_variable_wait_for (PCondVariable	*cond,
+			  PMutex	*mutex,
+			  puint64	usecs)
+{
+	puint64 msecs;
+
+	if (P_UNLIKELY (cond == NULL || mutex == NULL))
+		return FALSE;
+
+	/* There is no native timed wait: sleep for the whole timeout with the
+	 * mutex released, the caller checks the condition again anyway */
+	if (P_UNLIKELY (p_mutex_unlock (mutex) != TRUE)) {
+		P_ERROR ("PCondVariable::p_cond_variable_wait_for: failed to unlock mutex");
+		return FALSE;
+	}
+
+	msecs = (usecs + 999) / 1000;
+
+	p_uthread_sleep (msecs > P_MAXUINT32 ? P_MAXUINT32 : (puint32) msecs);
+
+	if (P_UNLIKELY (p_mutex_lock (mutex) != TRUE))
+		P_ERROR ("PCondVariable::p_cond_variable_wait_for: failed to lock mutex");
+
+	return FALSE;
+}
+
 P_LIB_API pboolean
 p_cond_variable_signal (PCondVariable *cond)
 {
@@ -53,6 +53,19 @@ p_cond_variable_wait (PCondVariable	*cond,
 	return FALSE;
 }
 
+P_LIB_API pboolean
+p_cond_variable_wait_for (PCondVariable	*cond,
+			  PMutex	*mutex,
+			  puint64	usecs)
+{
+	P_UNUSED (cond);
+	P_UNUSED (mutex);
+	P_UNUSED (usecs);
+
+	/* There is no condition variable to wait on, p_cond_variable_new() fails */
+	return FALSE;
+}
+
 P_LIB_API pboolean
 p_cond_variable_signal (PCondVariable *cond)
 {
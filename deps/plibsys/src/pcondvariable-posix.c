@@ -28,9 +28,14 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <time.h>
 #include <pthread.h>
 
+#ifndef PLIBSYS_HAS_POSIX_CONDATTR_SETCLOCK
+#  include <sys/time.h>
+#endif
+
 struct PCondVariable_ {
 	pthread_cond_t hdl;
 };
@@ -38,14 +43,36 @@ struct PCondVariable_ {
 P_LIB_API PCondVariable *
 p_cond_variable_new (void)
 {
-	PCondVariable *ret;
+	PCondVariable		*ret;
+#ifdef PLIBSYS_HAS_POSIX_CONDATTR_SETCLOCK
+	pthread_condattr_t	attr;
+	pint			res;
+#endif
 
 	if (P_UNLIKELY ((ret = p_malloc0 (sizeof (PCondVariable))) == NULL)) {
 		P_ERROR ("PCondVariable::p_cond_variable_new: failed to allocate memory");
 		return NULL;
 	}
 
+#ifdef PLIBSYS_HAS_POSIX_CONDATTR_SETCLOCK
+	/* Timed waits use the monotonic clock to be immune to system time changes */
+	if (P_UNLIKELY (pthread_condattr_init (&attr) != 0)) {
+		P_ERROR ("PCondVariable::p_cond_variable_new: failed to initialize attributes");
+		p_free (ret);
+		return NULL;
+	}
+
+	if (P_UNLIKELY (pthread_condattr_setclock (&attr, CLOCK_MONOTONIC) != 0))
+		P_WARNING ("PCondVariable::p_cond_variable_new: pthread_condattr_setclock() failed");
+
+	res = pthread_cond_init (&ret->hdl, &attr);
+
+	pthread_condattr_destroy (&attr);
+
+	if (P_UNLIKELY (res != 0)) {
+#else
 	if (P_UNLIKELY (pthread_cond_init (&ret->hdl, NULL) != 0)) {
+#endif
 		P_ERROR ("PCondVariable::p_cond_variable_new: failed to initialize");
 		p_free (ret);
 		return NULL;
@@ -82,6 +109,57 @@ p_cond_variable_wait (PCondVariable	*cond,
 	return TRUE;
 }
 
+P_LIB_API pboolean
+p_cond_variable_wait_for (PCondVariable	*cond,
+			  PMutex	*mutex,
+			  puint64	usecs)
+{
+	struct timespec	deadline;
+#ifndef PLIBSYS_HAS_POSIX_CONDATTR_SETCLOCK
+	struct timeval	now;
+#endif
+	pint		res;
+
+	if (P_UNLIKELY (cond == NULL || mutex == NULL))
+		return FALSE;
+
+#ifdef PLIBSYS_HAS_POSIX_CONDATTR_SETCLOCK
+	if (P_UNLIKELY (clock_gettime (CLOCK_MONOTONIC, &deadline) != 0)) {
+		P_ERROR ("PCondVariable::p_cond_variable_wait_for: clock_gettime() failed");
+		return FALSE;
+	}
+#else
+	if (P_UNLIKELY (gettimeofday (&now, NULL) != 0)) {
+		P_ERROR ("PCondVariable::p_cond_variable_wait_for: gettimeofday() failed");
+		return FALSE;
+	}
+
+	deadline.tv_sec  = now.tv_sec;
+	deadline.tv_nsec = now.tv_usec * 1000;
+#endif
+
+	deadline.tv_sec  += (time_t) (usecs / 1000000);
+	deadline.tv_nsec += (long) (usecs % 1000000) * 1000;
+
+	if (deadline.tv_nsec >= 1000000000L) {
+		++deadline.tv_sec;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	/* Cast is eligible since there is only one field in the PMutex structure */
+	res = pthread_cond_timedwait (&cond->hdl, (pthread_mutex_t *) mutex, &deadline);
+
+	if (res == ETIMEDOUT)
+		return FALSE;
+
+	if (P_UNLIKELY (res != 0)) {
+		P_ERROR ("PCondVariable::p_cond_variable_wait_for: pthread_cond_timedwait() failed");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 P_LIB_API pboolean
 p_cond_variable_signal (PCondVariable *cond)
 {
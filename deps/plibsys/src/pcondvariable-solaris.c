@@ -27,6 +27,7 @@
 #include "pcondvariable.h"
 
 #include <stdlib.h>
+#include <errno.h>
 #include <time.h>
 #include <string.h>
 #include <thread.h>
@@ -83,6 +84,34 @@ p_cond_variable_wait (PCondVariable	*cond,
 	return TRUE;
 }
 
+P_LIB_API pboolean
+p_cond_variable_wait_for (PCondVariable	*cond,
+			  PMutex	*mutex,
+			  puint64	usecs)
+{
+	timestruc_t	reltime;
+	pint		res;
+
+	if (P_UNLIKELY (cond == NULL || mutex == NULL))
+		return FALSE;
+
+	reltime.tv_sec  = (time_t) (usecs / 1000000);
+	reltime.tv_nsec = (long) (usecs % 1000000) * 1000;
+
+	/* Cast is eligible since there is only one field in the PMutex structure */
+	res = cond_reltimedwait (&cond->hdl, (mutex_t *) mutex, &reltime);
+
+	if (res == ETIME)
+		return FALSE;
+
+	if (P_UNLIKELY (res != 0)) {
+		P_ERROR ("PCondVariable::p_cond_variable_wait_for: cond_reltimedwait() failed");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 P_LIB_API pboolean
 p_cond_variable_signal (PCondVariable *cond)
 {
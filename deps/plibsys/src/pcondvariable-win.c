@@ -42,7 +42,7 @@ typedef VOID (WINAPI * WakeAllConditionVariableFunc)    (ppointer cv);
 
 typedef pboolean (* PWin32CondInit)    (PCondVariable *cond);
 typedef void     (* PWin32CondClose)   (PCondVariable *cond);
-typedef pboolean (* PWin32CondWait)    (PCondVariable *cond, PMutex *mutex);
+typedef pboolean (* PWin32CondWait)    (PCondVariable *cond, PMutex *mutex, DWORD ms);
 typedef pboolean (* PWin32CondSignal)  (PCondVariable *cond);
 typedef pboolean (* PWin32CondBrdcast) (PCondVariable *cond);
 
@@ -73,14 +73,14 @@ static PCondVariableVistaTable pp_cond_variable_vista_table = {NULL, NULL, NULL,
 /* CONDITION_VARIABLE routines */
 static pboolean pp_cond_variable_init_vista (PCondVariable *cond);
 static void pp_cond_variable_close_vista (PCondVariable *cond);
-static pboolean pp_cond_variable_wait_vista (PCondVariable *cond, PMutex *mutex);
+static pboolean pp_cond_variable_wait_vista (PCondVariable *cond, PMutex *mutex, DWORD ms);
 static pboolean pp_cond_variable_signal_vista (PCondVariable *cond);
 static pboolean pp_cond_variable_broadcast_vista (PCondVariable *cond);
 
 /* Windows XP emulation routines */
 static pboolean pp_cond_variable_init_xp (PCondVariable *cond);
 static void pp_cond_variable_close_xp (PCondVariable *cond);
-static pboolean pp_cond_variable_wait_xp (PCondVariable *cond, PMutex *mutex);
+static pboolean pp_cond_variable_wait_xp (PCondVariable *cond, PMutex *mutex, DWORD ms);
 static pboolean pp_cond_variable_signal_xp (PCondVariable *cond);
 static pboolean pp_cond_variable_broadcast_xp (PCondVariable *cond);
 
@@ -101,11 +101,11 @@ pp_cond_variable_close_vista (PCondVariable *cond)
 }
 
 static pboolean
-pp_cond_variable_wait_vista (PCondVariable *cond, PMutex *mutex)
+pp_cond_variable_wait_vista (PCondVariable *cond, PMutex *mutex, DWORD ms)
 {
 	return pp_cond_variable_vista_table.cv_wait (cond,
 						     (PCRITICAL_SECTION) mutex,
-						     INFINITE) != 0 ? TRUE : FALSE;
+						     ms) != 0 ? TRUE : FALSE;
 }
 
 static pboolean
@@ -159,7 +159,7 @@ pp_cond_variable_close_xp (PCondVariable *cond)
 }
 
 static pboolean
-pp_cond_variable_wait_xp (PCondVariable *cond, PMutex *mutex)
+pp_cond_variable_wait_xp (PCondVariable *cond, PMutex *mutex, DWORD ms)
 {
 	PCondVariableXP	*cv_xp = ((PCondVariableXP *) cond->cv);
 	DWORD		wait;
@@ -167,7 +167,7 @@ pp_cond_variable_wait_xp (PCondVariable *cond, PMutex *mutex)
 	p_atomic_int_inc (&cv_xp->waiters_count);
 
 	p_mutex_unlock (mutex);
-	wait = WaitForSingleObjectEx (cv_xp->waiters_sema, INFINITE, FALSE);
+	wait = WaitForSingleObjectEx (cv_xp->waiters_sema, ms, FALSE);
 	p_mutex_lock (mutex);
 
 	if (wait != WAIT_OBJECT_0)
@@ -241,7 +241,26 @@ p_cond_variable_wait (PCondVariable	*cond,
 	if (P_UNLIKELY (cond == NULL || mutex == NULL))
 		return FALSE;
 
-	return pp_cond_variable_wait_func (cond, mutex);
+	return pp_cond_variable_wait_func (cond, mutex, INFINITE);
+}
+
+P_LIB_API pboolean
+p_cond_variable_wait_for (PCondVariable	*cond,
+			  PMutex	*mutex,
+			  puint64	usecs)
+{
+	puint64 ms;
+
+	if (P_UNLIKELY (cond == NULL || mutex == NULL))
+		return FALSE;
+
+	/* Round up so a short timeout still waits, keep clear of INFINITE */
+	ms = (usecs + 999) / 1000;
+
+	if (ms >= (puint64) INFINITE)
+		ms = (puint64) INFINITE - 1;
+
+	return pp_cond_variable_wait_func (cond, mutex, (DWORD) ms);
 }
 
 P_LIB_API pboolean
@@ -0,0 +1,44 @@
+/*
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "pcondvariable.h"
+#include "ptimeprofiler.h"
+
+P_LIB_API pboolean
+p_cond_variable_wait_until (PCondVariable		*cond,
+			    PMutex			*mutex,
+			    const PTimeProfiler		*origin,
+			    puint64			usecs)
+{
+	puint64 elapsed;
+
+	if (P_UNLIKELY (cond == NULL || mutex == NULL || origin == NULL))
+		return FALSE;
+
+	elapsed = p_time_profiler_elapsed_usecs (origin);
+
+	if (elapsed >= usecs)
+		return FALSE;
+
+	return p_cond_variable_wait_for (cond, mutex, usecs - elapsed);
+}
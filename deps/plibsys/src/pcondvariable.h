@@ -53,6 +53,12 @@
  * wait for a signal from another thread on this condition variable
  * using p_cond_variable_wait().
  *
+ * A waiting thread which must not block forever, e.g. to notice a shutdown
+ * request or to meet a deadline, can use p_cond_variable_wait_for() with a
+ * relative timeout or p_cond_variable_wait_until() with a deadline measured
+ * from a #PTimeProfiler. Both return FALSE if the time has passed without a
+ * signal, the condition should be checked again in either case.
+ *
  * The signaling thread behavior: upon reaching event time emit a signal with
  * p_cond_variable_signal() to wake up a single waiting thread or
  * p_cond_variable_broadcast() to wake up all the waiting threads.
@@ -75,6 +81,7 @@
 #include <pmacros.h>
 #include <ptypes.h>
 #include <pmutex.h>
+#include <ptimeprofiler.h>
 
 P_BEGIN_DECLS
 
@@ -108,6 +115,55 @@ P_LIB_API void			p_cond_variable_free		(PCondVariable	*cond);
 P_LIB_API pboolean		p_cond_variable_wait		(PCondVariable	*cond,
 								 PMutex		*mutex);
 
+/**
+ * @brief Waits for a signal on a given condition variable for a limited time.
+ * @param cond Condition variable to wait on.
+ * @param mutex Locked mutex which will remain locked after waiting.
+ * @param usecs Longest time to wait, in microseconds.
+ * @return TRUE if the signal arrived, FALSE if the time is out or in case of
+ * an error.
+ * @since 0.0.5
+ *
+ * The calling thread will sleep until the signal on @a cond arrived or @a usecs
+ * microseconds elapsed. The timeout is measured against a monotonic clock where
+ * available, so it is not affected by system time changes.
+ *
+ * On platforms without a native timed wait the thread sleeps for the whole
+ * timeout with @a mutex unlocked and FALSE is returned. Without thread support
+ * there are no condition variables to wait on, p_cond_variable_new() returns
+ * NULL and FALSE is returned at once.
+ */
+P_LIB_API pboolean		p_cond_variable_wait_for	(PCondVariable	*cond,
+								 PMutex		*mutex,
+								 puint64	usecs);
+
+/**
+ * @brief Waits for a signal on a given condition variable until a deadline.
+ * @param cond Condition variable to wait on.
+ * @param mutex Locked mutex which will remain locked after waiting.
+ * @param origin Time profiler the deadline is measured from.
+ * @param usecs Deadline, in microseconds elapsed on @a origin.
+ * @return TRUE if the signal arrived, FALSE if the deadline has passed or in
+ * case of an error.
+ * @since 0.0.5
+ *
+ * Unlike p_cond_variable_wait_for(), repeated calls after spurious wakeups keep
+ * the same deadline, e.g. when waiting for a condition with a total timeout:
+ * @code
+ * p_time_profiler_reset (profiler);
+ *
+ * while (!condition && p_cond_variable_wait_until (cond, mutex, profiler, 100000))
+ *	;
+ * @endcode
+ *
+ * Without a native timed wait or thread support it behaves like
+ * p_cond_variable_wait_for().
+ */
+P_LIB_API pboolean		p_cond_variable_wait_until	(PCondVariable		*cond,
+								 PMutex			*mutex,
+								 const PTimeProfiler	*origin,
+								 puint64		usecs);
+
 /**
  * @brief Emitts a signal on a given condition variable for one waiting thread.
  * @param cond Condition variable to emit the signal on.
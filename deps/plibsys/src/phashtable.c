@@ -23,8 +23,15 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
-/* Hash table organized like this: table[hash key]->[list with values]
- * Note: this implementation is not intended to use on huge loads */
+/* Hash table organized like this: table[hash key] -> {key, value, distance}
+ *
+ * Open addressing with linear probing and Robin Hood displacement: an entry
+ * which is further from its home slot than the entry occupying a slot takes
+ * that slot over, which keeps probe sequences short and lets a lookup stop as
+ * soon as it meets an entry closer to its home than the key would be. Removal
+ * shifts the following entries back instead of leaving tombstones. All the
+ * entries live in one array, which is doubled when the load factor exceeds
+ * 3/4 and halved when it drops below 1/8. */
 
 #include "pmem.h"
 #include "phashtable.h"
@@ -34,42 +41,121 @@
 typedef struct PHashTableNode_ PHashTableNode;
 
 struct PHashTableNode_ {
-	PHashTableNode	*next;
 	ppointer	key;
 	ppointer	value;
+	psize		dist;	/* Distance from the home slot plus one, 0 if empty */
 };
 
 struct PHashTable_ {
-	PHashTableNode	**table;
-	psize		size;
+	PHashTableNode	*table;
+	psize		size;	/* Number of slots, a power of two */
+	psize		count;	/* Number of stored pairs */
 };
 
-/* Size of unique hash keys in hash table */
-#define P_HASH_TABLE_SIZE 101
+/* Initial and minimal number of slots in hash table */
+#define P_HASH_TABLE_SIZE 16
 
-static puint pp_hash_table_calc_hash (pconstpointer pointer, psize modulo);
+static psize pp_hash_table_calc_hash (pconstpointer pointer, psize size);
 static PHashTableNode * pp_hash_table_find_node (const PHashTable *table, pconstpointer key);
+static void pp_hash_table_put (PHashTableNode *nodes, psize size, ppointer key, ppointer value);
+static pboolean pp_hash_table_resize (PHashTable *table, psize new_size);
 
-static puint
-pp_hash_table_calc_hash (pconstpointer pointer, psize modulo)
+static psize
+pp_hash_table_calc_hash (pconstpointer pointer, psize size)
 {
-	/* As simple as we can :) */
-	return (puint) (((psize) (P_POINTER_TO_INT (pointer) + 37)) % modulo);
+	/* Pointers and small integers have poor low bits, mix all of them in
+	 * (the MurmurHash3 finalizer) */
+#if PLIBSYS_SIZEOF_VOID_P == 8
+	puint64 h = (puint64) PPOINTER_TO_PSIZE (pointer);
+
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	h *= 0xC4CEB9FE1A85EC53ULL;
+	h ^= h >> 33;
+#else
+	puint32 h = (puint32) PPOINTER_TO_PSIZE (pointer);
+
+	h ^= h >> 16;
+	h *= 0x85EBCA6BU;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35U;
+	h ^= h >> 16;
+#endif
+
+	return (psize) h & (size - 1);
 }
 
 static PHashTableNode *
 pp_hash_table_find_node (const PHashTable *table, pconstpointer key)
 {
-	puint		hash;
-	PHashTableNode	*ret;
+	PHashTableNode	*node;
+	psize		index;
+	psize		dist;
+
+	index = pp_hash_table_calc_hash (key, table->size);
+
+	for (dist = 1; ; ++dist) {
+		node = &table->table[index];
+
+		/* Any entry of the key would have displaced this one */
+		if (node->dist < dist)
+			return NULL;
+
+		if (node->key == key)
+			return node;
+
+		index = (index + 1) & (table->size - 1);
+	}
+}
+
+static void
+pp_hash_table_put (PHashTableNode *nodes, psize size, ppointer key, ppointer value)
+{
+	PHashTableNode	entry;
+	PHashTableNode	tmp;
+	psize		index;
+
+	entry.key   = key;
+	entry.value = value;
+	entry.dist  = 1;
+
+	index = pp_hash_table_calc_hash (key, size);
+
+	while (nodes[index].dist != 0) {
+		/* Rob the richer entry of its slot and carry on with it */
+		if (nodes[index].dist < entry.dist) {
+			tmp          = nodes[index];
+			nodes[index] = entry;
+			entry        = tmp;
+		}
+
+		index = (index + 1) & (size - 1);
+		++entry.dist;
+	}
+
+	nodes[index] = entry;
+}
+
+static pboolean
+pp_hash_table_resize (PHashTable *table, psize new_size)
+{
+	PHashTableNode	*nodes;
+	psize		i;
+
+	if (P_UNLIKELY ((nodes = p_malloc0 (new_size * sizeof (PHashTableNode))) == NULL))
+		return FALSE;
 
-	hash = pp_hash_table_calc_hash (key, table->size);
+	for (i = 0; i < table->size; ++i)
+		if (table->table[i].dist != 0)
+			pp_hash_table_put (nodes, new_size, table->table[i].key, table->table[i].value);
+
+	p_free (table->table);
 
-	for (ret = table->table[hash]; ret != NULL; ret = ret->next)
-		if (ret->key == key)
-			return ret;
+	table->table = nodes;
+	table->size  = new_size;
 
-	return NULL;
+	return TRUE;
 }
 
 P_LIB_API PHashTable *
@@ -82,7 +168,7 @@ p_hash_table_new (void)
 		return NULL;
 	}
 
-	if (P_UNLIKELY ((ret->table = p_malloc0 (P_HASH_TABLE_SIZE * sizeof (PHashTableNode *))) == NULL)) {
+	if (P_UNLIKELY ((ret->table = p_malloc0 (P_HASH_TABLE_SIZE * sizeof (PHashTableNode))) == NULL)) {
 		P_ERROR ("PHashTable::p_hash_table_new: failed(2) to allocate memory");
 		p_free (ret);
 		return NULL;
@@ -96,28 +182,27 @@ p_hash_table_new (void)
 P_LIB_API void
 p_hash_table_insert (PHashTable *table, ppointer key, ppointer value)
 {
-	PHashTableNode	*node;
-	puint		hash;
+	PHashTableNode *node;
 
 	if (P_UNLIKELY (table == NULL))
 		return;
 
-	if ((node = pp_hash_table_find_node (table, key)) == NULL) {
-		if (P_UNLIKELY ((node = p_malloc0 (sizeof (PHashTableNode))) == NULL)) {
-			P_ERROR ("PHashTable::p_hash_table_insert: failed to allocate memory");
-			return;
-		}
-
-		hash = pp_hash_table_calc_hash (key, table->size);
-
-		/* Insert a new node in front of others */
-		node->key   = key;
+	if ((node = pp_hash_table_find_node (table, key)) != NULL) {
 		node->value = value;
-		node->next  = table->table[hash];
+		return;
+	}
 
-		table->table[hash] = node;
-	} else
-		node->value = value;
+	/* Keep the load factor below 3/4, a full table still accepts pairs
+	 * while the growth fails as long as a slot is free */
+	if ((table->count + 1) * 4 > table->size * 3 &&
+	    pp_hash_table_resize (table, table->size * 2) == FALSE &&
+	    table->count + 1 >= table->size) {
+		P_ERROR ("PHashTable::p_hash_table_insert: failed to allocate memory");
+		return;
+	}
+
+	pp_hash_table_put (table->table, table->size, key, value);
+	++table->count;
 }
 
 P_LIB_API ppointer
@@ -134,53 +219,45 @@ p_hash_table_lookup (const PHashTable *table, pconstpointer key)
 P_LIB_API PList *
 p_hash_table_keys (const PHashTable *table)
 {
-	PList		*ret = NULL;
-	PHashTableNode	*node;
-	puint		i;
+	PListHead	ret;
+	psize		i;
 
 	if (P_UNLIKELY (table == NULL))
 		return NULL;
 
+	p_list_head_init (&ret, NULL);
+
 	for (i = 0; i < table->size; ++i)
-		for (node = table->table[i]; node != NULL; node = node->next)
-			ret = p_list_append (ret, node->key);
+		if (table->table[i].dist != 0)
+			(void) p_list_head_append (&ret, table->table[i].key);
 
-	return ret;
+	return ret.first;
 }
 
 P_LIB_API PList *
 p_hash_table_values (const PHashTable *table)
 {
-	PList		*ret = NULL;
-	PHashTableNode	*node;
-	puint		i;
+	PListHead	ret;
+	psize		i;
 
 	if (P_UNLIKELY (table == NULL))
 		return NULL;
 
+	p_list_head_init (&ret, NULL);
+
 	for (i = 0; i < table->size; ++i)
-		for (node = table->table[i]; node != NULL; node = node->next)
-			ret = p_list_append (ret, node->value);
+		if (table->table[i].dist != 0)
+			(void) p_list_head_append (&ret, table->table[i].value);
 
-	return ret;
+	return ret.first;
 }
 
 P_LIB_API void
 p_hash_table_free (PHashTable *table)
 {
-	PHashTableNode	*node, *next_node;
-	puint		i;
-
 	if (P_UNLIKELY (table == NULL))
 		return;
 
-	for (i = 0; i < table->size; ++i)
-		for (node = table->table[i]; node != NULL; ) {
-			next_node = node->next;
-			p_free (node);
-			node = next_node;
-		}
-
 	p_free (table->table);
 	p_free (table);
 }
@@ -188,55 +265,63 @@ p_hash_table_free (PHashTable *table)
 P_LIB_API void
 p_hash_table_remove (PHashTable *table, pconstpointer key)
 {
-	PHashTableNode	*node, *prev_node;
-	puint		hash;
+	PHashTableNode	*node;
+	psize		index;
+	psize		next;
 
 	if (P_UNLIKELY (table == NULL))
 		return;
 
-	if (pp_hash_table_find_node (table, key) != NULL) {
-		hash = pp_hash_table_calc_hash (key, table->size);
-		node = table->table[hash];
-		prev_node = NULL;
-
-		while (node != NULL) {
-			if (node->key == key) {
-				if (prev_node == NULL)
-					table->table[hash] = node->next;
-				else
-					prev_node->next = node->next;
-
-				p_free (node);
-				break;
-			} else {
-				prev_node = node;
-				node = node->next;
-			}
-		}
+	if ((node = pp_hash_table_find_node (table, key)) == NULL)
+		return;
+
+	/* Shift the following displaced entries one slot back */
+	index = (psize) (node - table->table);
+	next  = (index + 1) & (table->size - 1);
+
+	while (table->table[next].dist > 1) {
+		table->table[index] = table->table[next];
+		--table->table[index].dist;
+
+		index = next;
+		next  = (next + 1) & (table->size - 1);
 	}
+
+	table->table[index].dist = 0;
+	--table->count;
+
+	/* Shrinking is only an optimization, keep the table if it fails */
+	if (table->size > P_HASH_TABLE_SIZE && table->count * 8 < table->size)
+		(void) pp_hash_table_resize (table, table->size / 2);
 }
 
 P_LIB_API PList *
 p_hash_table_lookup_by_value (const PHashTable *table, pconstpointer val, PCompareFunc func)
 {
-	PList		*ret = NULL;
+	PListHead	ret;
 	PHashTableNode	*node;
-	puint		i;
+	psize		i;
 	pboolean	res;
 
 	if (P_UNLIKELY (table == NULL))
 		return NULL;
 
-	for (i = 0; i < table->size; ++i)
-		for (node = table->table[i]; node != NULL; node = node->next) {
-			if (func == NULL)
-				res = (node->value == val);
-			else
-				res = (func (node->value, val) == 0);
-
-			if (res)
-				ret = p_list_append (ret, node->key);
-		}
+	p_list_head_init (&ret, NULL);
 
-	return ret;
+	for (i = 0; i < table->size; ++i) {
+		node = &table->table[i];
+
+		if (node->dist == 0)
+			continue;
+
+		if (func == NULL)
+			res = (node->value == val);
+		else
+			res = (func (node->value, val) == 0);
+
+		if (res)
+			(void) p_list_head_append (&ret, node->key);
+	}
+
+	return ret.first;
 }
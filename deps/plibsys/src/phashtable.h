@@ -28,24 +28,19 @@
  * @brief Hash table
  * @author Alexander Saprykin
  *
- * A hash table is a data structure used to map keys to values. The hash table
- * consists of several internal slots which hold a list of values. A hash
- * function is used to compute an index in the array of the slots from a given
- * key. The hash function itself is fast and it takes a constant time to compute
- * the internal slot index.
+ * A hash table is a data structure used to map keys to values. A hash
+ * function is used to compute an index in the array of the internal slots from
+ * a given key, the hash function itself is fast and it takes a constant time to
+ * compute the slot index.
  *
- * When the number of pairs in the hash table is small the lookup and insert
- * (remove) operations are very fast and have average complexity O(1), because
- * every slot holds almost the only one pair. As the number of internal slots is
- * fixed, the increasing number of pairs will lead to degraded performance and
- * the average complexity of the operations can drop to O(N) in the worst case.
- * This is because the more pairs are inserted the more longer the list of
- * values is placed in every slot.
- *
- * This is a simple hash table implementation which is not intended for heavy
- * usage (several thousands), see #PTree if you need the best performance on
- * large data sets. This implementation doesn't support multi-inserts when
- * several values belong to the same key.
+ * This implementation uses open addressing: all the pairs are stored in the
+ * slot array itself, and a key colliding with another one is placed in one of
+ * the next slots. Entries are kept close to their home slots (Robin Hood
+ * hashing), and the slot array grows or shrinks with the number of pairs, so
+ * the lookup and insert (remove) operations have average complexity O(1) even
+ * on large data sets. The keys are mixed by an integer hash function, thus
+ * pointers and sequential integers spread well. This implementation doesn't
+ * support multi-inserts when several values belong to the same key.
  *
  * Note that #PHashTable stores keys and values only as pointers, so you need
  * to free used memory manually, p_hash_table_free() will not do it in any way.
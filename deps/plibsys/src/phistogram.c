@@ -0,0 +1,448 @@
+/*
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "patomic.h"
+#include "pmem.h"
+#include "phistogram.h"
+
+#include <string.h>
+
+#ifdef P_CC_MSVC
+#  include <intrin.h>
+#endif
+
+#define PP_HISTOGRAM_MIN_BITS		1
+#define PP_HISTOGRAM_MAX_BITS		16
+#define PP_HISTOGRAM_FORMAT_VERSION	1
+/* Longest LEB128 encoding of a 64-bit integer */
+#define PP_HISTOGRAM_MAX_VARINT_SIZE	10
+
+static const puint8 pp_histogram_magic[4] = {'P', 'H', 'S', 'T'};
+
+struct PHistogram_ {
+	pint		bits;		/* Significant bits, exact range is [0, 2^bits) */
+	psize		counts_len;
+	volatile psize	*counts;
+};
+
+static pint pp_histogram_msb (puint64 value);
+static psize pp_histogram_index (const PHistogram *hist, puint64 value);
+static puint64 pp_histogram_lowest (const PHistogram *hist, psize index);
+static puint64 pp_histogram_width (const PHistogram *hist, psize index);
+static psize pp_histogram_put_varint (puint8 *buf, puint64 value);
+static pboolean pp_histogram_get_varint (const puint8 **data, const puint8 *end, puint64 *value);
+
+/* Position of the highest set bit, value must be non-zero */
+static pint
+pp_histogram_msb (puint64 value)
+{
+#if defined (P_CC_GNU)
+	return 63 - __builtin_clzll (value);
+#elif defined (P_CC_MSVC) && defined (P_CPU_X86_64)
+	unsigned long pos;
+
+	_BitScanReverse64 (&pos, value);
+
+	return (pint) pos;
+#else
+	pint pos = 0;
+
+	while (value >>= 1)
+		++pos;
+
+	return pos;
+#endif
+}
+
+/* Values of [2^e, 2^(e+1)) for e >= bits are split into 2^(bits-1) sub-buckets
+ * of the 2^(e-bits+1) width, right after the 2^bits exact buckets */
+static psize
+pp_histogram_index (const PHistogram *hist, puint64 value)
+{
+	pint	shift;
+	psize	half;
+
+	if (value < (1ULL << hist->bits))
+		return (psize) value;
+
+	half  = (psize) 1 << (hist->bits - 1);
+	shift = pp_histogram_msb (value) - hist->bits + 1;
+
+	return ((psize) 1 << hist->bits) + (psize) (shift - 1) * half + (psize) (value >> shift) - half;
+}
+
+static puint64
+pp_histogram_lowest (const PHistogram *hist, psize index)
+{
+	psize	half;
+	psize	sub_index;
+
+	if (index < ((psize) 1 << hist->bits))
+		return (puint64) index;
+
+	half      = (psize) 1 << (hist->bits - 1);
+	sub_index = index - ((psize) 1 << hist->bits);
+
+	return ((puint64) (sub_index % half + half)) << (sub_index / half + 1);
+}
+
+static puint64
+pp_histogram_width (const PHistogram *hist, psize index)
+{
+	if (index < ((psize) 1 << hist->bits))
+		return 1;
+
+	return 1ULL << ((index - ((psize) 1 << hist->bits)) / ((psize) 1 << (hist->bits - 1)) + 1);
+}
+
+static psize
+pp_histogram_put_varint (puint8 *buf, puint64 value)
+{
+	psize len = 0;
+
+	while (value >= 0x80) {
+		buf[len++] = (puint8) (value | 0x80);
+		value >>= 7;
+	}
+
+	buf[len++] = (puint8) value;
+
+	return len;
+}
+
+static pboolean
+pp_histogram_get_varint (const puint8 **data, const puint8 *end, puint64 *value)
+{
+	const puint8	*ptr   = *data;
+	pint		shift  = 0;
+	puint64		result = 0;
+
+	while (ptr < end && shift < 64) {
+		result |= ((puint64) (*ptr & 0x7F)) << shift;
+
+		if ((*ptr++ & 0x80) == 0) {
+			*data  = ptr;
+			*value = result;
+			return TRUE;
+		}
+
+		shift += 7;
+	}
+
+	return FALSE;
+}
+
+P_LIB_API PHistogram *
+p_histogram_new (pint significant_bits)
+{
+	PHistogram *ret;
+
+	if (P_UNLIKELY (significant_bits < PP_HISTOGRAM_MIN_BITS ||
+			significant_bits > PP_HISTOGRAM_MAX_BITS))
+		return NULL;
+
+	if (P_UNLIKELY ((ret = p_malloc0 (sizeof (PHistogram))) == NULL)) {
+		P_ERROR ("PHistogram::p_histogram_new: failed(1) to allocate memory");
+		return NULL;
+	}
+
+	ret->bits       = significant_bits;
+	ret->counts_len = ((psize) 1 << significant_bits) +
+			  (psize) (64 - significant_bits) * ((psize) 1 << (significant_bits - 1));
+
+	if (P_UNLIKELY ((ret->counts = p_malloc0 (ret->counts_len * sizeof (psize))) == NULL)) {
+		P_ERROR ("PHistogram::p_histogram_new: failed(2) to allocate memory");
+		p_free (ret);
+		return NULL;
+	}
+
+	return ret;
+}
+
+P_LIB_API void
+p_histogram_free (PHistogram *hist)
+{
+	if (P_UNLIKELY (hist == NULL))
+		return;
+
+	p_free ((ppointer) hist->counts);
+	p_free (hist);
+}
+
+P_LIB_API void
+p_histogram_record (PHistogram	*hist,
+		    puint64	value)
+{
+	if (P_UNLIKELY (hist == NULL))
+		return;
+
+	++hist->counts[pp_histogram_index (hist, value)];
+}
+
+P_LIB_API void
+p_histogram_record_atomic (PHistogram	*hist,
+			   puint64	value)
+{
+	if (P_UNLIKELY (hist == NULL))
+		return;
+
+	(void) p_atomic_pointer_add (&hist->counts[pp_histogram_index (hist, value)], 1);
+}
+
+P_LIB_API pboolean
+p_histogram_merge (PHistogram		*dst,
+		   const PHistogram	*src)
+{
+	psize	i;
+	psize	count;
+
+	if (P_UNLIKELY (dst == NULL || src == NULL))
+		return FALSE;
+
+	if (P_UNLIKELY (dst->bits != src->bits))
+		return FALSE;
+
+	for (i = 0; i < src->counts_len; ++i) {
+		count = (psize) p_atomic_pointer_get (&src->counts[i]);
+
+		/* Most of the buckets are empty, don't touch their cache lines in dst */
+		if (count != 0)
+			(void) p_atomic_pointer_add (&dst->counts[i], (pssize) count);
+	}
+
+	return TRUE;
+}
+
+P_LIB_API void
+p_histogram_reset (PHistogram *hist)
+{
+	if (P_UNLIKELY (hist == NULL))
+		return;
+
+	memset ((ppointer) hist->counts, 0, hist->counts_len * sizeof (psize));
+}
+
+P_LIB_API puint64
+p_histogram_count (const PHistogram *hist)
+{
+	psize	i;
+	puint64	total = 0;
+
+	if (P_UNLIKELY (hist == NULL))
+		return 0;
+
+	for (i = 0; i < hist->counts_len; ++i)
+		total += hist->counts[i];
+
+	return total;
+}
+
+P_LIB_API puint64
+p_histogram_min (const PHistogram *hist)
+{
+	psize i;
+
+	if (P_UNLIKELY (hist == NULL))
+		return 0;
+
+	for (i = 0; i < hist->counts_len; ++i) {
+		if (hist->counts[i] != 0)
+			return pp_histogram_lowest (hist, i);
+	}
+
+	return 0;
+}
+
+P_LIB_API puint64
+p_histogram_max (const PHistogram *hist)
+{
+	psize i;
+
+	if (P_UNLIKELY (hist == NULL))
+		return 0;
+
+	for (i = hist->counts_len; i > 0; --i) {
+		if (hist->counts[i - 1] != 0)
+			return pp_histogram_lowest (hist, i - 1) + pp_histogram_width (hist, i - 1) - 1;
+	}
+
+	return 0;
+}
+
+P_LIB_API pdouble
+p_histogram_mean (const PHistogram *hist)
+{
+	psize	i;
+	psize	count;
+	puint64	total = 0;
+	pdouble	sum   = 0.0;
+
+	if (P_UNLIKELY (hist == NULL))
+		return 0.0;
+
+	for (i = 0; i < hist->counts_len; ++i) {
+		if ((count = hist->counts[i]) == 0)
+			continue;
+
+		sum   += (pdouble) count * ((pdouble) pp_histogram_lowest (hist, i) +
+					    (pdouble) (pp_histogram_width (hist, i) - 1) / 2.0);
+		total += count;
+	}
+
+	return total == 0 ? 0.0 : sum / (pdouble) total;
+}
+
+P_LIB_API puint64
+p_histogram_value_at_percentile (const PHistogram	*hist,
+				 pdouble		percentile)
+{
+	psize	i;
+	puint64	total;
+	puint64	target;
+	puint64	seen = 0;
+	pdouble	exact;
+
+	if (P_UNLIKELY (hist == NULL))
+		return 0;
+
+	if ((total = p_histogram_count (hist)) == 0)
+		return 0;
+
+	if (percentile < 0.0)
+		percentile = 0.0;
+	else if (percentile > 100.0)
+		percentile = 100.0;
+
+	/* Rank of the value, rounded up so that the percentile is covered */
+	exact  = percentile / 100.0 * (pdouble) total;
+	target = (puint64) exact;
+
+	if ((pdouble) target < exact)
+		++target;
+
+	if (target == 0)
+		target = 1;
+	else if (target > total)
+		target = total;
+
+	for (i = 0; i < hist->counts_len; ++i) {
+		seen += hist->counts[i];
+
+		if (seen >= target)
+			return pp_histogram_lowest (hist, i) + pp_histogram_width (hist, i) - 1;
+	}
+
+	/* Values recorded concurrently with the query may not be seen at all */
+	return p_histogram_max (hist);
+}
+
+P_LIB_API puint8 *
+p_histogram_serialize (const PHistogram	*hist,
+		       psize			*size)
+{
+	psize	i;
+	psize	len;
+	psize	prev     = 0;
+	psize	nonempty = 0;
+	psize	count;
+	puint8	*ret;
+
+	if (P_UNLIKELY (hist == NULL || size == NULL))
+		return NULL;
+
+	for (i = 0; i < hist->counts_len; ++i) {
+		if (hist->counts[i] != 0)
+			++nonempty;
+	}
+
+	/* More buckets may be filled meanwhile, they are skipped if out of space */
+	if (P_UNLIKELY ((ret = p_malloc (sizeof (pp_histogram_magic) + 2 +
+					 nonempty * 2 * PP_HISTOGRAM_MAX_VARINT_SIZE)) == NULL)) {
+		P_ERROR ("PHistogram::p_histogram_serialize: failed to allocate memory");
+		return NULL;
+	}
+
+	memcpy (ret, pp_histogram_magic, sizeof (pp_histogram_magic));
+
+	len        = sizeof (pp_histogram_magic);
+	ret[len++] = PP_HISTOGRAM_FORMAT_VERSION;
+	ret[len++] = (puint8) hist->bits;
+
+	/* Pairs of the distance to the previous non-empty bucket and the count */
+	for (i = 0; i < hist->counts_len && nonempty > 0; ++i) {
+		if ((count = hist->counts[i]) == 0)
+			continue;
+
+		len += pp_histogram_put_varint (ret + len, (puint64) (i - prev));
+		len += pp_histogram_put_varint (ret + len, (puint64) count);
+
+		prev = i;
+		--nonempty;
+	}
+
+	*size = len;
+
+	return ret;
+}
+
+P_LIB_API PHistogram *
+p_histogram_deserialize (const puint8	*data,
+			 psize		size)
+{
+	PHistogram	*ret;
+	const puint8	*end;
+	puint64		delta;
+	puint64		count;
+	psize		index = 0;
+	pboolean	first = TRUE;
+
+	if (P_UNLIKELY (data == NULL || size < sizeof (pp_histogram_magic) + 2))
+		return NULL;
+
+	if (memcmp (data, pp_histogram_magic, sizeof (pp_histogram_magic)) != 0 ||
+	    data[sizeof (pp_histogram_magic)] != PP_HISTOGRAM_FORMAT_VERSION)
+		return NULL;
+
+	if (P_UNLIKELY ((ret = p_histogram_new ((pint) data[sizeof (pp_histogram_magic) + 1])) == NULL))
+		return NULL;
+
+	end   = data + size;
+	data += sizeof (pp_histogram_magic) + 2;
+
+	while (data < end) {
+		if (!pp_histogram_get_varint (&data, end, &delta) ||
+		    !pp_histogram_get_varint (&data, end, &count) ||
+		    delta >= (puint64) (ret->counts_len - index) ||
+		    (delta == 0 && !first) ||
+		    count == 0 || count > (puint64) P_MAXSIZE) {
+			p_histogram_free (ret);
+			return NULL;
+		}
+
+		index += (psize) delta;
+		ret->counts[index] = (psize) count;
+		first              = FALSE;
+	}
+
+	return ret;
+}
@@ -0,0 +1,210 @@
+/*
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file phistogram.h
+ * @brief Latency histogram
+ *
+ * #PHistogram counts recorded values, such as latencies in nanoseconds, in
+ * logarithmic buckets with a fixed relative precision, i.e. HDR (high dynamic
+ * range) histogram. Values below 2^N, where N is the number of significant bits
+ * given to p_histogram_new(), are counted exactly. Larger values are split by
+ * their power of two magnitude into 2^(N-1) linear sub-buckets each, so a value
+ * and the bucket it is reported with differ by less than 1/2^(N-1) of the value
+ * over the whole 64-bit range. With 7 significant bits, which is enough for two
+ * decimal digits, a histogram takes about 30 KB.
+ *
+ * Recording is a shift and an increment without locks or allocations. Use
+ * p_histogram_record() when a histogram has a single writer, typically one
+ * histogram per thread, and p_histogram_record_atomic() when several threads
+ * record into the same histogram. Per-thread histograms can be merged into a
+ * shared one with p_histogram_merge() at any moment: it reads and adds the
+ * counters atomically, so neither the recording threads nor the other merging
+ * threads are blocked.
+ *
+ * Query the total count with p_histogram_count(), the recorded range with
+ * p_histogram_min() and p_histogram_max(), the mean with p_histogram_mean() and
+ * percentiles with p_histogram_value_at_percentile(). All of them report values
+ * with the precision of the bucket they fall into.
+ *
+ * A histogram can be written into a compact binary form with
+ * p_histogram_serialize() to be stored or sent to another process, and read back
+ * with p_histogram_deserialize(). The form doesn't depend on the byte order or
+ * the word size of a platform.
+ */
+
+#if !defined (PLIBSYS_H_INSIDE) && !defined (PLIBSYS_COMPILATION)
+#  error "Header files shouldn't be included directly, consider using <plibsys.h> instead."
+#endif
+
+#ifndef PLIBSYS_HEADER_PHISTOGRAM_H
+#define PLIBSYS_HEADER_PHISTOGRAM_H
+
+#include <pmacros.h>
+#include <ptypes.h>
+
+P_BEGIN_DECLS
+
+/** Opaque data structure for a histogram. */
+typedef struct PHistogram_ PHistogram;
+
+/**
+ * @brief Creates a new histogram.
+ * @param significant_bits Number of significant bits of the recorded values to
+ * keep, from 1 to 16.
+ * @return Pointer to a newly created #PHistogram structure in case of success,
+ * NULL otherwise.
+ * @since 0.0.5
+ * @note Free with p_histogram_free() after usage.
+ */
+P_LIB_API PHistogram *	p_histogram_new			(pint			significant_bits);
+
+/**
+ * @brief Frees a histogram.
+ * @param hist #PHistogram to free.
+ * @since 0.0.5
+ */
+P_LIB_API void		p_histogram_free		(PHistogram		*hist);
+
+/**
+ * @brief Records a value into a histogram with a single writer.
+ * @param hist #PHistogram to record into.
+ * @param value Value to record.
+ * @since 0.0.5
+ *
+ * Only one thread at a time may record into @a hist with this call, use
+ * p_histogram_record_atomic() otherwise. Other threads still may merge @a hist
+ * concurrently.
+ */
+P_LIB_API void		p_histogram_record		(PHistogram		*hist,
+							 puint64		value);
+
+/**
+ * @brief Records a value into a histogram shared by several writers.
+ * @param hist #PHistogram to record into.
+ * @param value Value to record.
+ * @since 0.0.5
+ */
+P_LIB_API void		p_histogram_record_atomic	(PHistogram		*hist,
+							 puint64		value);
+
+/**
+ * @brief Adds the counts of one histogram to another.
+ * @param dst #PHistogram to add to.
+ * @param src #PHistogram to add from.
+ * @return TRUE in case of success, FALSE if the histograms have different
+ * numbers of significant bits.
+ * @since 0.0.5
+ *
+ * The call is lock-free: values may be recorded into @a src, and other
+ * histograms merged into @a dst, at the same time.
+ */
+P_LIB_API pboolean	p_histogram_merge		(PHistogram		*dst,
+							 const PHistogram	*src);
+
+/**
+ * @brief Clears all the counts of a histogram.
+ * @param hist #PHistogram to reset.
+ * @since 0.0.5
+ */
+P_LIB_API void		p_histogram_reset		(PHistogram		*hist);
+
+/**
+ * @brief Gets the number of values recorded into a histogram.
+ * @param hist #PHistogram to query.
+ * @return Number of recorded values.
+ * @since 0.0.5
+ */
+P_LIB_API puint64	p_histogram_count		(const PHistogram	*hist);
+
+/**
+ * @brief Gets the smallest value recorded into a histogram.
+ * @param hist #PHistogram to query.
+ * @return Lowest value of the first non-empty bucket, 0 if the histogram is
+ * empty.
+ * @since 0.0.5
+ */
+P_LIB_API puint64	p_histogram_min			(const PHistogram	*hist);
+
+/**
+ * @brief Gets the largest value recorded into a histogram.
+ * @param hist #PHistogram to query.
+ * @return Highest value of the last non-empty bucket, 0 if the histogram is
+ * empty.
+ * @since 0.0.5
+ */
+P_LIB_API puint64	p_histogram_max			(const PHistogram	*hist);
+
+/**
+ * @brief Gets the mean of the values recorded into a histogram.
+ * @param hist #PHistogram to query.
+ * @return Mean of the bucket middles weighted by their counts, 0 if the
+ * histogram is empty.
+ * @since 0.0.5
+ */
+P_LIB_API pdouble	p_histogram_mean		(const PHistogram	*hist);
+
+/**
+ * @brief Gets a percentile of the values recorded into a histogram.
+ * @param hist #PHistogram to query.
+ * @param percentile Percentile to get, from 0.0 to 100.0.
+ * @return Highest value of the bucket which holds the given percentile, 0 if
+ * the histogram is empty.
+ * @since 0.0.5
+ *
+ * At least @a percentile percents of the recorded values are less or equal to
+ * the returned value.
+ */
+P_LIB_API puint64	p_histogram_value_at_percentile	(const PHistogram	*hist,
+							 pdouble		percentile);
+
+/**
+ * @brief Writes a histogram into a binary form.
+ * @param hist #PHistogram to write.
+ * @param[out] size Size of the written data in bytes.
+ * @return Newly allocated buffer with the written data in case of success, NULL
+ * otherwise.
+ * @since 0.0.5
+ * @note Free with p_free() after usage.
+ *
+ * Only non-empty buckets are written, so the size depends on the spread of the
+ * recorded values rather than on the number of them.
+ */
+P_LIB_API puint8 *	p_histogram_serialize		(const PHistogram	*hist,
+							 psize			*size);
+
+/**
+ * @brief Reads a histogram from the binary form.
+ * @param data Data written by p_histogram_serialize().
+ * @param size Size of @a data in bytes.
+ * @return Pointer to a newly created #PHistogram structure in case of success,
+ * NULL if @a data is malformed or there is not enough memory.
+ * @since 0.0.5
+ * @note Free with p_histogram_free() after usage.
+ */
+P_LIB_API PHistogram *	p_histogram_deserialize		(const puint8		*data,
+							 psize			size);
+
+P_END_DECLS
+
+#endif /* PLIBSYS_HEADER_PHISTOGRAM_H */
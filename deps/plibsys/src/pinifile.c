@@ -457,10 +457,10 @@ p_ini_file_parameter_list (const PIniFile	*file,
 			   const pchar		*section,
 			   const pchar		*key)
 {
-	PList	*ret = NULL;
-	pchar	*val, *str;
-	pchar	buf[P_INI_FILE_MAX_LINE + 1];
-	psize	len, buf_cnt;
+	PListHead	ret;
+	pchar		*val, *str;
+	pchar		buf[P_INI_FILE_MAX_LINE + 1];
+	psize		len, buf_cnt;
 
 	if ((val = pp_ini_file_find_parameter (file, section, key)) == NULL)
 		return NULL;
@@ -472,6 +472,8 @@ p_ini_file_parameter_list (const PIniFile	*file,
 		return NULL;
 	}
 
+	p_list_head_init (&ret, NULL);
+
 	/* Skip first brace '{' symbol */
 	str = val + 1;
 	buf[0] = '\0';
@@ -484,7 +486,7 @@ p_ini_file_parameter_list (const PIniFile	*file,
 			buf[buf_cnt] = '\0';
 
 			if (buf_cnt > 0)
-				ret = p_list_append (ret, p_strdup (buf));
+				(void) p_list_head_append (&ret, p_strdup (buf));
 
 			buf_cnt = 0;
 		}
@@ -494,10 +496,10 @@ p_ini_file_parameter_list (const PIniFile	*file,
 
 	if (buf_cnt > 0) {
 		buf[buf_cnt] = '\0';
-		ret = p_list_append (ret, p_strdup (buf));
+		(void) p_list_head_append (&ret, p_strdup (buf));
 	}
 
 	p_free (val);
 
-	return ret;
+	return ret.first;
 }
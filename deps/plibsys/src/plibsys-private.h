@@ -35,6 +35,18 @@
 
 P_BEGIN_DECLS
 
+/* Tells the CPU that the calling thread is busy-waiting */
+#if defined (P_CC_GNU) && defined (P_CPU_X86)
+#  define P_CPU_RELAX() __builtin_ia32_pause ()
+#elif defined (P_CC_GNU) && defined (P_CPU_ARM) && (P_CPU_ARM >= 7)
+#  define P_CPU_RELAX() __asm__ __volatile__ ("yield" ::: "memory")
+#elif defined (P_CC_MSVC) && defined (P_CPU_X86)
+#  include <intrin.h>
+#  define P_CPU_RELAX() _mm_pause ()
+#else
+#  define P_CPU_RELAX()
+#endif
+
 #ifndef PLIBSYS_HAS_SOCKLEN_T
 #  ifdef P_OS_VMS
 typedef unsigned int socklen_t;
@@ -36,6 +36,7 @@
 #include "perror.h"
 #include "pfile.h"
 #include "phashtable.h"
+#include "phistogram.h"
 #include "pinifile.h"
 #include "plibraryloader.h"
 #include "plist.h"
@@ -28,6 +28,73 @@
 
 #include <stdlib.h>
 
+#define PP_LIST_POOL_BLOCK_NODES	256
+
+/* A block starts with a pointer to the previously allocated one, the nodes follow */
+typedef struct PListPoolBlock_ {
+	struct PListPoolBlock_	*prev;
+	PList			nodes[1];
+} PListPoolBlock;
+
+struct PListPool_ {
+	psize		block_nodes;
+	PListPoolBlock	*blocks;	/* Last allocated block */
+	psize		block_used;	/* Nodes taken from the last block */
+	PList		*free_nodes;	/* Released nodes, linked by next */
+};
+
+static PList * pp_list_node_new (PListPool *pool);
+static void pp_list_nodes_release (PListPool *pool, PList *first, PList *last);
+
+static PList *
+pp_list_node_new (PListPool *pool)
+{
+	PListPoolBlock	*block;
+	PList		*node;
+
+	if (pool == NULL)
+		return p_malloc0 (sizeof (PList));
+
+	if (pool->free_nodes != NULL) {
+		node             = pool->free_nodes;
+		pool->free_nodes = node->next;
+		node->next       = NULL;
+
+		return node;
+	}
+
+	if (pool->blocks == NULL || pool->block_used == pool->block_nodes) {
+		if (P_UNLIKELY ((block = p_malloc (sizeof (PListPoolBlock) +
+						   (pool->block_nodes - 1) * sizeof (PList))) == NULL))
+			return NULL;
+
+		block->prev      = pool->blocks;
+		pool->blocks     = block;
+		pool->block_used = 0;
+	}
+
+	node       = &pool->blocks->nodes[pool->block_used++];
+	node->next = NULL;
+
+	return node;
+}
+
+/* Releases a chain of nodes from first to last, which must be linked */
+static void
+pp_list_nodes_release (PListPool *pool, PList *first, PList *last)
+{
+	if (first == NULL)
+		return;
+
+	if (pool == NULL) {
+		p_list_free (first);
+		return;
+	}
+
+	last->next       = pool->free_nodes;
+	pool->free_nodes = first;
+}
+
 P_LIB_API PList *
 p_list_append (PList *list, ppointer data)
 {
@@ -172,3 +239,153 @@ p_list_reverse	(PList *list)
 
 	return prev;
 }
+
+P_LIB_API PListPool *
+p_list_pool_new (psize block_nodes)
+{
+	PListPool *ret;
+
+	if (P_UNLIKELY ((ret = p_malloc0 (sizeof (PListPool))) == NULL)) {
+		P_ERROR ("PList::p_list_pool_new: failed to allocate memory");
+		return NULL;
+	}
+
+	ret->block_nodes = block_nodes > 0 ? block_nodes : PP_LIST_POOL_BLOCK_NODES;
+
+	return ret;
+}
+
+P_LIB_API void
+p_list_pool_free (PListPool *pool)
+{
+	PListPoolBlock *block;
+
+	if (P_UNLIKELY (pool == NULL))
+		return;
+
+	while ((block = pool->blocks) != NULL) {
+		pool->blocks = block->prev;
+		p_free (block);
+	}
+
+	p_free (pool);
+}
+
+P_LIB_API void
+p_list_head_init (PListHead *head, PListPool *pool)
+{
+	if (P_UNLIKELY (head == NULL))
+		return;
+
+	head->first  = NULL;
+	head->last   = NULL;
+	head->length = 0;
+	head->pool   = pool;
+}
+
+P_LIB_API pboolean
+p_list_head_append (PListHead *head, ppointer data)
+{
+	PList *item;
+
+	if (P_UNLIKELY (head == NULL))
+		return FALSE;
+
+	if (P_UNLIKELY ((item = pp_list_node_new (head->pool)) == NULL)) {
+		P_ERROR ("PList::p_list_head_append: failed to allocate memory");
+		return FALSE;
+	}
+
+	item->data = data;
+
+	if (head->last == NULL)
+		head->first = item;
+	else
+		head->last->next = item;
+
+	head->last = item;
+	++head->length;
+
+	return TRUE;
+}
+
+P_LIB_API pboolean
+p_list_head_append_bulk (PListHead *head, ppointer const *data, psize count)
+{
+	PList	*first = NULL;
+	PList	*last  = NULL;
+	PList	*item;
+	psize	i;
+
+	if (P_UNLIKELY (head == NULL || (data == NULL && count > 0)))
+		return FALSE;
+
+	if (count == 0)
+		return TRUE;
+
+	/* Build the chain aside, so that the list is untouched on failure */
+	for (i = 0; i < count; ++i) {
+		if (P_UNLIKELY ((item = pp_list_node_new (head->pool)) == NULL)) {
+			P_ERROR ("PList::p_list_head_append_bulk: failed to allocate memory");
+			pp_list_nodes_release (head->pool, first, last);
+			return FALSE;
+		}
+
+		item->data = data[i];
+
+		if (last == NULL)
+			first = item;
+		else
+			last->next = item;
+
+		last = item;
+	}
+
+	if (head->last == NULL)
+		head->first = first;
+	else
+		head->last->next = first;
+
+	head->last    = last;
+	head->length += count;
+
+	return TRUE;
+}
+
+P_LIB_API pboolean
+p_list_head_prepend (PListHead *head, ppointer data)
+{
+	PList *item;
+
+	if (P_UNLIKELY (head == NULL))
+		return FALSE;
+
+	if (P_UNLIKELY ((item = pp_list_node_new (head->pool)) == NULL)) {
+		P_ERROR ("PList::p_list_head_prepend: failed to allocate memory");
+		return FALSE;
+	}
+
+	item->data  = data;
+	item->next  = head->first;
+	head->first = item;
+
+	if (head->last == NULL)
+		head->last = item;
+
+	++head->length;
+
+	return TRUE;
+}
+
+P_LIB_API void
+p_list_head_clear (PListHead *head)
+{
+	if (P_UNLIKELY (head == NULL))
+		return;
+
+	pp_list_nodes_release (head->pool, head->first, head->last);
+
+	head->first  = NULL;
+	head->last   = NULL;
+	head->length = 0;
+}
@@ -74,7 +74,28 @@
  * p_list_remove() will remove only the first matching node.
  *
  * If you need to add large amount of nodes at once it is better to prepend them
- * and then reverse the list.
+ * and then reverse the list, or to build the list with a #PListHead.
+ *
+ * #PListHead keeps track of the first and the last nodes and of the length of a
+ * list, so p_list_head_append() and p_list_head_prepend() take O(1) constant
+ * time, and p_list_head_append_bulk() adds a whole array of data at once. The
+ * list being built is always available as the @a first field of the head:
+ * @code
+ * PListHead    head;
+ *
+ * p_list_head_init (&head, NULL);
+ *
+ * for (i = 0; i < count; ++i)
+ *         p_list_head_append (&head, items[i]);
+ *
+ * return head.first;
+ * @endcode
+ * By default the nodes are allocated one by one as with p_list_append(), and the
+ * list can be freed with p_list_free(). A #PListPool instead allocates the nodes
+ * in blocks and recycles the nodes released with p_list_head_clear(), which
+ * saves an allocation per node for lists which are built and thrown away often.
+ * The nodes of a pooled list must not be released with p_list_free() or
+ * p_list_remove(), they live until p_list_head_clear() or p_list_pool_free().
  */
 
 #if !defined (PLIBSYS_H_INSIDE) && !defined (PLIBSYS_COMPILATION)
@@ -98,6 +119,17 @@ struct PList_ {
 	PList		*next;	/**< Next list node.		*/
 };
 
+/** Opaque data structure for a pool of list nodes. */
+typedef struct PListPool_ PListPool;
+
+/** Head of a list being built, tracking its last node. */
+typedef struct PListHead_ {
+	PList		*first;		/**< First node, NULL if the list is empty.	*/
+	PList		*last;		/**< Last node, NULL if the list is empty.	*/
+	psize		length;		/**< Number of nodes.				*/
+	PListPool	*pool;		/**< Pool of the nodes, NULL for the heap.	*/
+} PListHead;
+
 /**
  * @brief Appends data to a list.
  * @param list #PList for appending the data.
@@ -194,6 +226,84 @@ P_LIB_API PList *	p_list_prepend	(PList		*list,
  */
 P_LIB_API PList *	p_list_reverse	(PList		*list) P_GNUC_WARN_UNUSED_RESULT;
 
+/**
+ * @brief Creates a new pool of list nodes.
+ * @param block_nodes Number of nodes to allocate at once, 0 to use the default.
+ * @return Pointer to a newly created #PListPool structure in case of success,
+ * NULL otherwise.
+ * @since 0.0.5
+ * @note Free with p_list_pool_free() after usage.
+ *
+ * A pool is not thread-safe, so all the lists using it must be built by the same
+ * thread or under a lock.
+ */
+P_LIB_API PListPool *	p_list_pool_new		(psize		block_nodes);
+
+/**
+ * @brief Frees a pool of list nodes.
+ * @param pool #PListPool to free.
+ * @since 0.0.5
+ *
+ * All the nodes allocated from the @a pool are freed as well, including those
+ * which are still in a list.
+ */
+P_LIB_API void		p_list_pool_free	(PListPool	*pool);
+
+/**
+ * @brief Initializes a list head for an empty list.
+ * @param head #PListHead to initialize.
+ * @param pool #PListPool to allocate the nodes from, NULL to allocate them from
+ * the heap.
+ * @since 0.0.5
+ */
+P_LIB_API void		p_list_head_init	(PListHead	*head,
+						 PListPool	*pool);
+
+/**
+ * @brief Appends data to a list in O(1) constant time.
+ * @param head #PListHead of the list.
+ * @param data Data to append.
+ * @return TRUE in case of success, FALSE otherwise.
+ * @since 0.0.5
+ */
+P_LIB_API pboolean	p_list_head_append	(PListHead	*head,
+						 ppointer	data);
+
+/**
+ * @brief Appends an array of data to a list.
+ * @param head #PListHead of the list.
+ * @param data Data to append, in order.
+ * @param count Number of elements in @a data.
+ * @return TRUE in case of success, FALSE otherwise.
+ * @since 0.0.5
+ *
+ * Either all the data is appended or the list is left unchanged.
+ */
+P_LIB_API pboolean	p_list_head_append_bulk	(PListHead	*head,
+						 ppointer const	*data,
+						 psize		count);
+
+/**
+ * @brief Prepends data to a list in O(1) constant time.
+ * @param head #PListHead of the list.
+ * @param data Data to prepend.
+ * @return TRUE in case of success, FALSE otherwise.
+ * @since 0.0.5
+ */
+P_LIB_API pboolean	p_list_head_prepend	(PListHead	*head,
+						 ppointer	data);
+
+/**
+ * @brief Releases all the nodes of a list.
+ * @param head #PListHead of the list.
+ * @since 0.0.5
+ *
+ * Nodes from the heap are freed and pooled nodes are given back to the pool to
+ * be reused, then the list is empty. As with p_list_free(), the data is not
+ * freed.
+ */
+P_LIB_API void		p_list_head_clear	(PListHead	*head);
+
 P_END_DECLS
 
 #endif /* PLIBSYS_HEADER_PLIST_H */
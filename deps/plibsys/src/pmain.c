@@ -40,6 +40,7 @@ extern void p_rwlock_init		(void);
 extern void p_rwlock_shutdown		(void);
 extern void p_time_profiler_init	(void);
 extern void p_time_profiler_shutdown	(void);
+extern void p_time_profiler_cycles_init	(void);
 extern void p_library_loader_init	(void);
 extern void p_library_loader_shutdown	(void);
 
@@ -61,6 +62,7 @@ p_libsys_init (void)
 	p_cond_variable_init ();
 	p_rwlock_init ();
 	p_time_profiler_init ();
+	p_time_profiler_cycles_init ();
 	p_library_loader_init ();
 }
 
@@ -47,9 +47,87 @@
 #  endif
 #endif
 
+#ifdef PLIBSYS_MMAP_HAS_MAP_HUGETLB
+#  include <stdio.h>
+#endif
+
+#ifdef PLIBSYS_HAS_MBIND
+#  include <sys/syscall.h>
+/* Preferred node policy with an empty node set: allocate on the faulting CPU's
+ * node, from <linux/mempolicy.h> which is not always installed */
+#  define PP_MEM_MPOL_PREFERRED	1
+#endif
+
+/* Stride to touch the pages with, not larger than any page size */
+#define PP_MEM_PREFAULT_STRIDE	4096
+
 static pboolean		p_mem_table_inited = FALSE;
 static PMemVTable	p_mem_table;
 
+static pboolean pp_mem_apply_flags (ppointer addr, psize n_bytes, puint flags, PError **error);
+
+static pboolean
+pp_mem_apply_flags (ppointer	addr,
+		    psize	n_bytes,
+		    puint	flags,
+		    PError	**error)
+{
+	volatile pchar	*page;
+	psize		offset;
+
+#ifdef PLIBSYS_HAS_MBIND
+	/* Must be set before the pages are touched */
+	if ((flags & P_MEM_MAP_NUMA_LOCAL) != 0) {
+		if (P_UNLIKELY (syscall (SYS_mbind, addr, n_bytes, PP_MEM_MPOL_PREFERRED, NULL, 0, 0) != 0))
+			P_WARNING ("PMem::pp_mem_apply_flags: failed to set NUMA memory policy");
+	}
+#endif
+
+#ifdef PLIBSYS_HAS_MADVISE_HUGEPAGE
+	/* Also fine for explicit huge pages, the kernel ignores it then */
+	if ((flags & P_MEM_MAP_HUGE_PAGES) != 0) {
+		if (P_UNLIKELY (madvise (addr, n_bytes, MADV_HUGEPAGE) != 0))
+			P_WARNING ("PMem::pp_mem_apply_flags: failed to request transparent huge pages");
+	}
+#endif
+
+	if ((flags & P_MEM_MAP_LOCKED) != 0) {
+#if defined (P_OS_WIN)
+		if (P_UNLIKELY (VirtualLock (addr, n_bytes) == 0)) {
+			p_error_set_error_p (error,
+					     (pint) p_error_get_last_io (),
+					     p_error_get_last_system (),
+					     "Failed to call VirtualLock() to lock memory");
+			return FALSE;
+		}
+#elif defined (PLIBSYS_HAS_MLOCK)
+		if (P_UNLIKELY (mlock (addr, n_bytes) != 0)) {
+			p_error_set_error_p (error,
+					     (pint) p_error_get_last_io (),
+					     p_error_get_last_system (),
+					     "Failed to call mlock() to lock memory");
+			return FALSE;
+		}
+#else
+		p_error_set_error_p (error,
+				     (pint) P_ERROR_IO_NOT_IMPLEMENTED,
+				     0,
+				     "Memory locking is not supported");
+		return FALSE;
+#endif
+	}
+
+	/* Locking commits the pages on most systems, but not on all of them */
+	if ((flags & (P_MEM_MAP_PREFAULT | P_MEM_MAP_LOCKED | P_MEM_MAP_NUMA_LOCAL)) != 0) {
+		page = (volatile pchar *) addr;
+
+		for (offset = 0; offset < n_bytes; offset += PP_MEM_PREFAULT_STRIDE)
+			page[offset] = 0;
+	}
+
+	return TRUE;
+}
+
 void
 p_mem_init (void)
 {
@@ -146,6 +224,14 @@ p_mem_restore_vtable (void)
 P_LIB_API ppointer
 p_mem_mmap (psize	n_bytes,
 	    PError	**error)
+{
+	return p_mem_mmap_full (n_bytes, P_MEM_MAP_DEFAULT, error);
+}
+
+P_LIB_API ppointer
+p_mem_mmap_full (psize	n_bytes,
+		 puint	flags,
+		 PError	**error)
 {
 	ppointer	addr;
 #if defined (P_OS_WIN)
@@ -157,6 +243,9 @@ p_mem_mmap (psize	n_bytes,
 #elif !defined (P_OS_AMIGA)
 	int		fd;
 	int		map_flags = MAP_PRIVATE;
+#  ifdef PLIBSYS_MMAP_HAS_MAP_HUGETLB
+	psize		huge_size;
+#  endif
 #endif
 
 	if (P_UNLIKELY (n_bytes == 0)) {
@@ -260,12 +349,28 @@ p_mem_mmap (psize	n_bytes,
 	map_flags |= MAP_ANON;
 #  endif
 
-	if (P_UNLIKELY ((addr = mmap (NULL,
-				      n_bytes,
-				      PROT_READ | PROT_WRITE,
-				      map_flags,
-				      fd,
-				      0)) == (void *) -1)) {
+	addr = (void *) -1;
+
+#  ifdef PLIBSYS_MMAP_HAS_MAP_HUGETLB
+	/* Explicit huge pages come from a reserved pool which may be empty */
+	if ((flags & P_MEM_MAP_HUGE_PAGES) != 0) {
+		huge_size = p_mem_huge_page_size ();
+
+		if (huge_size > 0 && n_bytes % huge_size == 0)
+			addr = mmap (NULL,
+				     n_bytes,
+				     PROT_READ | PROT_WRITE,
+				     map_flags | MAP_HUGETLB,
+				     fd,
+				     0);
+	}
+
+#  endif
+
+	if (addr == (void *) -1)
+		addr = mmap (NULL, n_bytes, PROT_READ | PROT_WRITE, map_flags, fd, 0);
+
+	if (P_UNLIKELY (addr == (void *) -1)) {
 		p_error_set_error_p (error,
 				     (pint) p_error_get_last_io (),
 				     p_error_get_last_system (),
@@ -289,9 +394,42 @@ p_mem_mmap (psize	n_bytes,
 #  endif
 #endif
 
+	if (flags != P_MEM_MAP_DEFAULT) {
+		if (P_UNLIKELY (pp_mem_apply_flags (addr, n_bytes, flags, error) == FALSE)) {
+			if (P_UNLIKELY (p_mem_munmap (addr, n_bytes, NULL) == FALSE))
+				P_WARNING ("PMem::p_mem_mmap_full: failed to unmap memory");
+
+			return NULL;
+		}
+	}
+
 	return addr;
 }
 
+P_LIB_API psize
+p_mem_huge_page_size (void)
+{
+#ifdef PLIBSYS_MMAP_HAS_MAP_HUGETLB
+	FILE		*file;
+	pchar		line[128];
+	unsigned long	size_kb = 0;
+
+	if (P_UNLIKELY ((file = fopen ("/proc/meminfo", "r")) == NULL))
+		return 0;
+
+	while (fgets (line, sizeof (line), file) != NULL) {
+		if (sscanf (line, "Hugepagesize: %lu kB", &size_kb) == 1)
+			break;
+	}
+
+	fclose (file);
+
+	return (psize) size_kb * 1024;
+#else
+	return 0;
+#endif
+}
+
 P_LIB_API pboolean
 p_mem_munmap (ppointer	mem,
 	      psize	n_bytes,
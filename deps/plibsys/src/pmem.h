@@ -57,6 +57,11 @@
  * i.e. custom memory allocator can request a large block first, and then it
  * allocates chunks of memory within the block upon request.
  *
+ * p_mem_mmap_full() additionally takes #PMemMapFlags to back the block with
+ * huge pages, commit or lock it in physical memory up front, or place it on the
+ * NUMA node of the caller. These are useful for large blocks on a latency
+ * sensitive path, where TLB misses and page faults are expensive.
+ *
  * @note OS/2 supports non-backed memory pages allocation, but in a specific
  * way: an exception handler to control access to uncommitted pages must be
  * allocated on the stack of each thread before using the mapped memory. To
@@ -85,6 +90,15 @@ typedef struct PMemVTable_ {
 	void		(*free)		(ppointer	mem);		/**< free() implementation.	*/
 } PMemVTable;
 
+/** Memory mapping flags, can be combined with a bitwise OR. */
+typedef enum PMemMapFlags_ {
+	P_MEM_MAP_DEFAULT	= 0,		/**< Default pages committed on the first touch.		*/
+	P_MEM_MAP_HUGE_PAGES	= 1 << 0,	/**< Prefer huge pages, a hint.					*/
+	P_MEM_MAP_PREFAULT	= 1 << 1,	/**< Commit all the pages before returning.			*/
+	P_MEM_MAP_LOCKED	= 1 << 2,	/**< Lock the pages in physical memory, implies prefaulting.	*/
+	P_MEM_MAP_NUMA_LOCAL	= 1 << 3	/**< Place the pages on the NUMA node of the caller, a hint.	*/
+} PMemMapFlags;
+
 /**
  * @brief Allocates a memory block for the specified number of bytes.
  * @param n_bytes Size of the memory block in bytes.
@@ -173,10 +187,51 @@ P_LIB_API void		p_mem_restore_vtable	(void);
 P_LIB_API ppointer	p_mem_mmap		(psize			n_bytes,
 						 PError			**error);
 
+/**
+ * @brief Gets a memory mapped block from the system with the given placement
+ * options.
+ * @param n_bytes Size of the memory block in bytes.
+ * @param flags Bitwise OR of #PMemMapFlags.
+ * @param[out] error Error report object, NULL to ignore.
+ * @return Pointer to the allocated memory block in case of success, NULL
+ * otherwise.
+ * @since 0.0.5
+ *
+ * With #P_MEM_MAP_HUGE_PAGES explicit huge pages (MAP_HUGETLB on Linux) are
+ * used if @a n_bytes is a multiple of p_mem_huge_page_size() and the system
+ * has enough of them reserved, otherwise transparent huge pages are requested
+ * for the block where supported. Huge pages reduce TLB misses on large blocks.
+ *
+ * With #P_MEM_MAP_NUMA_LOCAL the block is bound to the NUMA node of the CPU
+ * the caller runs on, overriding the process memory policy (Linux only), and
+ * is prefaulted by the caller. Call it from a thread bound to the node, i.e.
+ * created with p_uthread_create_affine(), to get a stable placement.
+ *
+ * #P_MEM_MAP_LOCKED fails if the pages can't be locked, i.e. when the locked
+ * memory limit of the process is too low. The other flags are hints which are
+ * ignored where not supported.
+ *
+ * Release the block with p_mem_munmap() using the same @a n_bytes.
+ */
+P_LIB_API ppointer	p_mem_mmap_full		(psize			n_bytes,
+						 puint			flags,
+						 PError			**error);
+
+/**
+ * @brief Gets the default size of explicit huge pages.
+ * @return Size of a huge page in bytes, 0 if huge pages are not supported.
+ * @since 0.0.5
+ * @note Only Linux is supported for now.
+ *
+ * Sizes passed to p_mem_mmap_full() with #P_MEM_MAP_HUGE_PAGES should be
+ * rounded up to a multiple of this value to be backed by explicit huge pages.
+ */
+P_LIB_API psize		p_mem_huge_page_size	(void);
+
 /**
  * @brief Unmaps memory back to the system.
  * @param mem Pointer to a memory block previously allocated using the
- * p_mem_mmap() call.
+ * p_mem_mmap() or p_mem_mmap_full() call.
  * @param n_bytes Size of the memory block in bytes.
  * @param[out] error Error report object, NULL to ignore.
  * @return TRUE in case of success, FALSE otherwise.
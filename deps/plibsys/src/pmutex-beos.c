@@ -55,6 +55,13 @@ p_mutex_new (void)
 	return ret;
 }
 
+P_LIB_API PMutex *
+p_mutex_new_adaptive (void)
+{
+	/* No spinning phase on this platform */
+	return p_mutex_new ();
+}
+
 P_LIB_API pboolean
 p_mutex_lock (PMutex *mutex)
 {
@@ -37,6 +37,12 @@ p_mutex_new (void)
 	return NULL;
 }
 
+P_LIB_API PMutex *
+p_mutex_new_adaptive (void)
+{
+	return NULL;
+}
+
 P_LIB_API pboolean
 p_mutex_lock (PMutex *mutex)
 {
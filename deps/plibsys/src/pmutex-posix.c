@@ -25,16 +25,50 @@
 
 #include "pmem.h"
 #include "pmutex.h"
+#include "puthread.h"
+#include "plibsys-private.h"
 
 #include <stdlib.h>
 #include <pthread.h>
 
+/* Total number of CPU pauses before an adaptive mutex sleeps */
+#define P_MUTEX_ADAPTIVE_SPINS		2048
+/* Upper bound of the backoff between two lock attempts, in CPU pauses */
+#define P_MUTEX_ADAPTIVE_MAX_BACKOFF	64
+
 typedef pthread_mutex_t mutex_hdl;
 
+/* The handle must stay the first field, see pcondvariable-posix.c */
 struct PMutex_ {
 	mutex_hdl	hdl;
+	pint		spins;
 };
 
+static pboolean pp_mutex_spin_lock (PMutex *mutex);
+
+static pboolean
+pp_mutex_spin_lock (PMutex *mutex)
+{
+	pint backoff = 1;
+	pint spent   = 0;
+	pint i;
+
+	while (spent < mutex->spins) {
+		if (pthread_mutex_trylock (&mutex->hdl) == 0)
+			return TRUE;
+
+		for (i = 0; i < backoff; ++i)
+			P_CPU_RELAX ();
+
+		spent += backoff;
+
+		if (backoff < P_MUTEX_ADAPTIVE_MAX_BACKOFF)
+			backoff *= 2;
+	}
+
+	return FALSE;
+}
+
 P_LIB_API PMutex *
 p_mutex_new (void)
 {
@@ -54,12 +88,31 @@ p_mutex_new (void)
 	return ret;
 }
 
+P_LIB_API PMutex *
+p_mutex_new_adaptive (void)
+{
+	PMutex *ret;
+
+	if (P_UNLIKELY ((ret = p_mutex_new ()) == NULL))
+		return NULL;
+
+	/* Spinning only pays off if the owner runs on another CPU */
+	if (p_uthread_ideal_count () > 1)
+		ret->spins = P_MUTEX_ADAPTIVE_SPINS;
+
+	return ret;
+}
+
 P_LIB_API pboolean
 p_mutex_lock (PMutex *mutex)
 {
 	if (P_UNLIKELY (mutex == NULL))
 		return FALSE;
 
+	/* Contended locks of an adaptive mutex sleep in the kernel only after spinning */
+	if (mutex->spins > 0 && pp_mutex_spin_lock (mutex) == TRUE)
+		return TRUE;
+
 	if (P_LIKELY (pthread_mutex_lock (&mutex->hdl) == 0))
 		return TRUE;
 	else {
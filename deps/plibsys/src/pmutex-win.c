@@ -49,6 +49,26 @@ p_mutex_new (void)
 	return ret;
 }
 
+P_LIB_API PMutex *
+p_mutex_new_adaptive (void)
+{
+	PMutex *ret;
+
+	if (P_UNLIKELY ((ret = p_malloc0 (sizeof (PMutex))) == NULL)) {
+		P_ERROR ("PMutex::p_mutex_new_adaptive: failed to allocate memory");
+		return NULL;
+	}
+
+	/* Critical sections spin on their own before waiting, and skip it on a single CPU */
+	if (P_UNLIKELY (InitializeCriticalSectionAndSpinCount (&ret->hdl, 2048) == 0)) {
+		P_ERROR ("PMutex::p_mutex_new_adaptive: InitializeCriticalSectionAndSpinCount() failed");
+		p_free (ret);
+		return NULL;
+	}
+
+	return ret;
+}
+
 P_LIB_API pboolean
 p_mutex_lock (PMutex *mutex)
 {
@@ -81,6 +81,21 @@ typedef struct PMutex_ PMutex;
  */
 P_LIB_API PMutex *	p_mutex_new	(void);
 
+/**
+ * @brief Creates a new adaptive #PMutex object.
+ * @return Pointer to a newly created #PMutex object.
+ * @since 0.0.5
+ *
+ * An adaptive mutex suits very short critical sections: when the lock is
+ * taken, the calling thread first spins for a bounded time, pausing the CPU
+ * with an exponential backoff between attempts, and only then sleeps until the
+ * mutex is released. On a single CPU system no spinning is done at all.
+ *
+ * It is used exactly like a mutex created with p_mutex_new(), including with a
+ * #PCondVariable. Platforms without a spinning phase return a regular mutex.
+ */
+P_LIB_API PMutex *	p_mutex_new_adaptive	(void);
+
 /**
  * @brief Locks a mutex.
  * @param mutex #PMutex to lock.
@@ -0,0 +1,340 @@
+/*
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Reader-scalable read-write lock.
+ *
+ * Readers do not share any lock word: each one announces itself by
+ * incrementing the counter of its stripe, chosen from the thread ID, and then
+ * checks the writer flag. A writer raises the flag and waits until the sum of
+ * all the stripe counters drops to zero. Both sides issue a full barrier
+ * between their store and their load, so at least one of them sees the other.
+ * Readers which find the flag raised withdraw and sleep until the writer is
+ * gone, so writers are preferred. The mutex and the condition variables are
+ * used only when a writer is involved.
+ */
+
+#include "pmem.h"
+#include "patomic.h"
+#include "pmutex.h"
+#include "pcondvariable.h"
+#include "prwlock.h"
+#include "puthread.h"
+
+#include <stdlib.h>
+
+#define P_RWLOCK_STRIPES	16
+#define P_RWLOCK_CACHE_LINE	64
+
+typedef struct PRWLockStripe_ {
+	volatile pint	readers;
+	pchar		pad[P_RWLOCK_CACHE_LINE - sizeof (pint)];
+} PRWLockStripe;
+
+struct PRWLock_ {
+	PRWLockStripe	stripes[P_RWLOCK_STRIPES];
+	volatile pint	writer;
+	PMutex		*mutex;
+	PCondVariable	*read_cv;
+	PCondVariable	*write_cv;
+};
+
+static volatile pint * pp_rwlock_get_stripe (PRWLock *lock);
+static pint pp_rwlock_count_readers (PRWLock *lock);
+static pboolean pp_rwlock_reader_leave (PRWLock *lock, volatile pint *stripe);
+
+static volatile pint *
+pp_rwlock_get_stripe (PRWLock *lock)
+{
+	puint32 hash;
+	psize	id;
+
+	id   = (psize) p_uthread_current_id ();
+	hash = (puint32) (id ^ (id >> 12) ^ (id >> 24));
+
+	/* Fibonacci hashing spreads nearby thread IDs over the stripes */
+	return &(lock->stripes[(hash * 2654435761U) >> 28].readers);
+}
+
+static pint
+pp_rwlock_count_readers (PRWLock *lock)
+{
+	pint	count = 0;
+	pint	i;
+
+	for (i = 0; i < P_RWLOCK_STRIPES; ++i)
+		count += p_atomic_int_get (&(lock->stripes[i].readers));
+
+	return count;
+}
+
+static pboolean
+pp_rwlock_reader_leave (PRWLock *lock, volatile pint *stripe)
+{
+	pboolean signal_ok = TRUE;
+
+	(void) p_atomic_int_dec_and_test (stripe);
+
+	/* A writer may be waiting for this reader to leave */
+	if (P_UNLIKELY (p_atomic_int_get (&(lock->writer)) != 0)) {
+		if (P_UNLIKELY (p_mutex_lock (lock->mutex) == FALSE))
+			return FALSE;
+
+		signal_ok = p_cond_variable_broadcast (lock->write_cv);
+
+		if (P_UNLIKELY (p_mutex_unlock (lock->mutex) == FALSE))
+			return FALSE;
+	}
+
+	return signal_ok;
+}
+
+P_LIB_API PRWLock *
+p_rwlock_new (void)
+{
+	PRWLock *ret;
+
+	if (P_UNLIKELY ((ret = p_malloc0 (sizeof (PRWLock))) == NULL)) {
+		P_ERROR ("PRWLock::p_rwlock_new: failed to allocate memory");
+		return NULL;
+	}
+
+	if (P_UNLIKELY ((ret->mutex = p_mutex_new ()) == NULL)) {
+		P_ERROR ("PRWLock::p_rwlock_new: failed to allocate mutex");
+		p_free (ret);
+		return NULL;
+	}
+
+	if (P_UNLIKELY ((ret->read_cv = p_cond_variable_new ()) == NULL)) {
+		P_ERROR ("PRWLock::p_rwlock_new: failed to allocate condition variable for read");
+		p_mutex_free (ret->mutex);
+		p_free (ret);
+		return NULL;
+	}
+
+	if (P_UNLIKELY ((ret->write_cv = p_cond_variable_new ()) == NULL)) {
+		P_ERROR ("PRWLock::p_rwlock_new: failed to allocate condition variable for write");
+		p_cond_variable_free (ret->read_cv);
+		p_mutex_free (ret->mutex);
+		p_free (ret);
+		return NULL;
+	}
+
+	return ret;
+}
+
+P_LIB_API pboolean
+p_rwlock_reader_lock (PRWLock *lock)
+{
+	volatile pint *stripe;
+
+	if (P_UNLIKELY (lock == NULL))
+		return FALSE;
+
+	stripe = pp_rwlock_get_stripe (lock);
+
+	while (TRUE) {
+		p_atomic_int_inc (stripe);
+
+		if (P_LIKELY (p_atomic_int_get (&(lock->writer)) == 0))
+			return TRUE;
+
+		if (P_UNLIKELY (pp_rwlock_reader_leave (lock, stripe) == FALSE)) {
+			P_ERROR ("PRWLock::p_rwlock_reader_lock: failed to wake up writer");
+			return FALSE;
+		}
+
+		if (P_UNLIKELY (p_mutex_lock (lock->mutex) == FALSE)) {
+			P_ERROR ("PRWLock::p_rwlock_reader_lock: p_mutex_lock() failed");
+			return FALSE;
+		}
+
+		while (p_atomic_int_get (&(lock->writer)) != 0) {
+			if (P_UNLIKELY (p_cond_variable_wait (lock->read_cv, lock->mutex) == FALSE)) {
+				P_ERROR ("PRWLock::p_rwlock_reader_lock: p_cond_variable_wait() failed");
+				p_mutex_unlock (lock->mutex);
+				return FALSE;
+			}
+		}
+
+		if (P_UNLIKELY (p_mutex_unlock (lock->mutex) == FALSE)) {
+			P_ERROR ("PRWLock::p_rwlock_reader_lock: p_mutex_unlock() failed");
+			return FALSE;
+		}
+	}
+}
+
+P_LIB_API pboolean
+p_rwlock_reader_trylock (PRWLock *lock)
+{
+	volatile pint *stripe;
+
+	if (P_UNLIKELY (lock == NULL))
+		return FALSE;
+
+	stripe = pp_rwlock_get_stripe (lock);
+
+	p_atomic_int_inc (stripe);
+
+	if (P_LIKELY (p_atomic_int_get (&(lock->writer)) == 0))
+		return TRUE;
+
+	if (P_UNLIKELY (pp_rwlock_reader_leave (lock, stripe) == FALSE))
+		P_ERROR ("PRWLock::p_rwlock_reader_trylock: failed to wake up writer");
+
+	return FALSE;
+}
+
+P_LIB_API pboolean
+p_rwlock_reader_unlock (PRWLock *lock)
+{
+	if (P_UNLIKELY (lock == NULL))
+		return FALSE;
+
+	if (P_UNLIKELY (pp_rwlock_reader_leave (lock, pp_rwlock_get_stripe (lock)) == FALSE)) {
+		P_ERROR ("PRWLock::p_rwlock_reader_unlock: failed to wake up writer");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+P_LIB_API pboolean
+p_rwlock_writer_lock (PRWLock *lock)
+{
+	pboolean wait_ok;
+
+	if (P_UNLIKELY (lock == NULL))
+		return FALSE;
+
+	if (P_UNLIKELY (p_mutex_lock (lock->mutex) == FALSE)) {
+		P_ERROR ("PRWLock::p_rwlock_writer_lock: p_mutex_lock() failed");
+		return FALSE;
+	}
+
+	wait_ok = TRUE;
+
+	/* Wait for the other writer, then keep new readers out */
+	while (p_atomic_int_compare_and_exchange (&(lock->writer), 0, 1) == FALSE) {
+		if (P_UNLIKELY ((wait_ok = p_cond_variable_wait (lock->write_cv, lock->mutex)) == FALSE))
+			break;
+	}
+
+	while (wait_ok == TRUE && pp_rwlock_count_readers (lock) != 0)
+		wait_ok = p_cond_variable_wait (lock->write_cv, lock->mutex);
+
+	if (P_UNLIKELY (wait_ok == FALSE))
+		P_ERROR ("PRWLock::p_rwlock_writer_lock: p_cond_variable_wait() failed");
+
+	if (P_UNLIKELY (p_mutex_unlock (lock->mutex) == FALSE)) {
+		P_ERROR ("PRWLock::p_rwlock_writer_lock: p_mutex_unlock() failed");
+		return FALSE;
+	}
+
+	return wait_ok;
+}
+
+P_LIB_API pboolean
+p_rwlock_writer_trylock (PRWLock *lock)
+{
+	pboolean is_locked;
+
+	if (P_UNLIKELY (lock == NULL))
+		return FALSE;
+
+	if (P_UNLIKELY (p_mutex_lock (lock->mutex) == FALSE)) {
+		P_ERROR ("PRWLock::p_rwlock_writer_trylock: p_mutex_lock() failed");
+		return FALSE;
+	}
+
+	is_locked = p_atomic_int_compare_and_exchange (&(lock->writer), 0, 1);
+
+	if (is_locked == TRUE && pp_rwlock_count_readers (lock) != 0) {
+		/* Let in the readers which have seen the flag meanwhile */
+		p_atomic_int_set (&(lock->writer), 0);
+		p_cond_variable_broadcast (lock->read_cv);
+		p_cond_variable_broadcast (lock->write_cv);
+		is_locked = FALSE;
+	}
+
+	if (P_UNLIKELY (p_mutex_unlock (lock->mutex) == FALSE)) {
+		P_ERROR ("PRWLock::p_rwlock_writer_trylock: p_mutex_unlock() failed");
+		return FALSE;
+	}
+
+	return is_locked;
+}
+
+P_LIB_API pboolean
+p_rwlock_writer_unlock (PRWLock *lock)
+{
+	pboolean signal_ok;
+
+	if (P_UNLIKELY (lock == NULL))
+		return FALSE;
+
+	if (P_UNLIKELY (p_mutex_lock (lock->mutex) == FALSE)) {
+		P_ERROR ("PRWLock::p_rwlock_writer_unlock: p_mutex_lock() failed");
+		return FALSE;
+	}
+
+	p_atomic_int_set (&(lock->writer), 0);
+
+	signal_ok = p_cond_variable_broadcast (lock->read_cv);
+	signal_ok = p_cond_variable_broadcast (lock->write_cv) && signal_ok;
+
+	if (P_UNLIKELY (signal_ok == FALSE))
+		P_ERROR ("PRWLock::p_rwlock_writer_unlock: p_cond_variable_broadcast() failed");
+
+	if (P_UNLIKELY (p_mutex_unlock (lock->mutex) == FALSE)) {
+		P_ERROR ("PRWLock::p_rwlock_writer_unlock: p_mutex_unlock() failed");
+		return FALSE;
+	}
+
+	return signal_ok;
+}
+
+P_LIB_API void
+p_rwlock_free (PRWLock *lock)
+{
+	if (P_UNLIKELY (lock == NULL))
+		return;
+
+	if (P_UNLIKELY (lock->writer != 0 || pp_rwlock_count_readers (lock) != 0))
+		P_WARNING ("PRWLock::p_rwlock_free: destroying while active threads are present");
+
+	p_mutex_free (lock->mutex);
+	p_cond_variable_free (lock->read_cv);
+	p_cond_variable_free (lock->write_cv);
+
+	p_free (lock);
+}
+
+void
+p_rwlock_init (void)
+{
+}
+
+void
+p_rwlock_shutdown (void)
+{
+}
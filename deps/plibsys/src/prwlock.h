@@ -61,6 +61,14 @@
  *
  * A writer enters the critical section with p_rwlock_writer_lock() or
  * p_rwlock_writer_trylock() and exits with p_rwlock_writer_unlock().
+ *
+ * Native read-write locks usually keep all the readers in one shared counter,
+ * so reader threads running on different CPUs still contend for it. The
+ * library can be built with the `striped` read-write lock model
+ * (PLIBSYS_RWLOCK_MODEL=striped) instead: readers are spread over several
+ * counters placed on separate cache lines and only check an atomic writer
+ * flag, so an uncontended reader lock touches no shared cache line. Writers
+ * become more expensive, as they have to scan all the counters.
  */
 
 #if !defined (PLIBSYS_H_INSIDE) && !defined (PLIBSYS_COMPILATION)
@@ -276,7 +276,7 @@ p_socket_address_new_loopback (PSocketFamily	family,
 			       puint16		port)
 {
 	PSocketAddress	*ret;
-	puchar		loop_addr[] = {127, 0, 0, 0};
+	puchar		loop_addr[] = {127, 0, 0, 1};
 #ifdef AF_INET6
 	struct in6_addr	loop6_addr = IN6ADDR_LOOPBACK_INIT;
 #endif
@@ -25,15 +25,22 @@
 
 #include "pmem.h"
 #include "pspinlock.h"
+#include "pspinlock-private.h"
 
 #ifdef P_CC_SUN
 #  define PSPINLOCK_INT_CAST(x) (pint *) (x)
+#  define PSPINLOCK_UINT_CAST(x) (puint *) (x)
 #else
 #  define PSPINLOCK_INT_CAST(x) x
+#  define PSPINLOCK_UINT_CAST(x) x
 #endif
 
+/* The ticket counters are unsigned so that they wrap around without overflowing */
 struct PSpinLock_ {
-	volatile pint spin;
+	volatile pint	spin;
+	volatile puint	next_ticket;
+	volatile puint	now_serving;
+	pboolean	fair;
 };
 
 P_LIB_API PSpinLock *
@@ -49,34 +56,76 @@ p_spinlock_new (void)
 	return ret;
 }
 
+P_LIB_API PSpinLock *
+p_spinlock_new_fair (void)
+{
+	PSpinLock *ret;
+
+	if (P_UNLIKELY ((ret = p_spinlock_new ()) == NULL))
+		return NULL;
+
+	ret->fair = TRUE;
+
+	return ret;
+}
+
 P_LIB_API pboolean
 p_spinlock_lock (PSpinLock *spinlock)
 {
 	pint tmp_int;
+	puint ticket;
+	pint backoff = 1;
 
 	if (P_UNLIKELY (spinlock == NULL))
 		return FALSE;
 
-	do {
+	if (spinlock->fair == TRUE) {
+		ticket = __atomic_fetch_add (PSPINLOCK_UINT_CAST (&(spinlock->next_ticket)), 1, __ATOMIC_RELAXED);
+
+		while (__atomic_load_n (PSPINLOCK_UINT_CAST (&(spinlock->now_serving)), __ATOMIC_ACQUIRE) != ticket)
+			p_spinlock_backoff (&backoff);
+
+		return TRUE;
+	}
+
+	for (;;) {
 		tmp_int = 0;
-	} while ((pboolean) __atomic_compare_exchange_n (PSPINLOCK_INT_CAST (&(spinlock->spin)),
-							 &tmp_int,
-							 1,
-							 0,
-							 __ATOMIC_ACQUIRE,
-							 __ATOMIC_RELAXED) == FALSE);
 
-	return TRUE;
+		if ((pboolean) __atomic_compare_exchange_n (PSPINLOCK_INT_CAST (&(spinlock->spin)),
+							    &tmp_int,
+							    1,
+							    0,
+							    __ATOMIC_ACQUIRE,
+							    __ATOMIC_RELAXED) == TRUE)
+			return TRUE;
+
+		/* Wait on a shared copy of the cache line until the lock looks free */
+		while (__atomic_load_n (PSPINLOCK_INT_CAST (&(spinlock->spin)), __ATOMIC_RELAXED) != 0)
+			p_spinlock_backoff (&backoff);
+	}
 }
 
 P_LIB_API pboolean
 p_spinlock_trylock (PSpinLock *spinlock)
 {
 	pint tmp_int = 0;
+	puint ticket;
 
 	if (P_UNLIKELY (spinlock == NULL))
 		return FALSE;
 
+	if (spinlock->fair == TRUE) {
+		/* The lock is free when no ticket is waiting to be served */
+		ticket = __atomic_load_n (PSPINLOCK_UINT_CAST (&(spinlock->now_serving)), __ATOMIC_ACQUIRE);
+
+		return (pboolean) __atomic_compare_exchange_n (PSPINLOCK_UINT_CAST (&(spinlock->next_ticket)),
+							       &ticket,
+							       ticket + 1,
+							       0,
+							       __ATOMIC_ACQUIRE,
+							       __ATOMIC_RELAXED);
+	}
+
 	return (pboolean) __atomic_compare_exchange_n (PSPINLOCK_INT_CAST (&(spinlock->spin)),
 						       &tmp_int,
 						       1,
@@ -91,6 +140,15 @@ p_spinlock_unlock (PSpinLock *spinlock)
 	if (P_UNLIKELY (spinlock == NULL))
 		return FALSE;
 
+	if (spinlock->fair == TRUE) {
+		/* Only the owner advances the counter */
+		__atomic_store_n (PSPINLOCK_UINT_CAST (&(spinlock->now_serving)),
+				  spinlock->now_serving + 1,
+				  __ATOMIC_RELEASE);
+
+		return TRUE;
+	}
+
 	__atomic_store_4 (PSPINLOCK_INT_CAST (&(spinlock->spin)), 0, __ATOMIC_RELEASE);
 
 	return TRUE;
@@ -49,6 +49,13 @@ p_spinlock_new (void)
 	return ret;
 }
 
+P_LIB_API PSpinLock *
+p_spinlock_new_fair (void)
+{
+	/* No ticket lock for this atomic model */
+	return p_spinlock_new ();
+}
+
 P_LIB_API pboolean
 p_spinlock_lock (PSpinLock *spinlock)
 {
@@ -0,0 +1,51 @@
+/*
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#if !defined (PLIBSYS_H_INSIDE) && !defined (PLIBSYS_COMPILATION)
+#  error "Header files shouldn't be included directly, consider using <plibsys.h> instead."
+#endif
+
+#ifndef PLIBSYS_HEADER_PSPINLOCK_PRIVATE_H
+#define PLIBSYS_HEADER_PSPINLOCK_PRIVATE_H
+
+#include "pmacros.h"
+#include "ptypes.h"
+
+P_BEGIN_DECLS
+
+/** Upper bound of the backoff between two lock attempts, in CPU pauses. */
+#define P_SPINLOCK_MAX_BACKOFF	64
+
+/**
+ * @brief Waits before the next attempt to take a contended spinlock.
+ * @param[in,out] backoff Number of CPU pauses to wait, start with 1.
+ *
+ * The backoff is doubled on every call up to #P_SPINLOCK_MAX_BACKOFF. Once it
+ * is reached the calling thread also yields its time slice, so that a lock
+ * owner preempted on the same CPU can make progress.
+ */
+void p_spinlock_backoff (pint *backoff);
+
+P_END_DECLS
+
+#endif /* PLIBSYS_HEADER_PSPINLOCK_PRIVATE_H */
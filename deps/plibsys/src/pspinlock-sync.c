@@ -25,9 +25,14 @@
 
 #include "pmem.h"
 #include "pspinlock.h"
+#include "pspinlock-private.h"
 
+/* The ticket counters are unsigned so that they wrap around without overflowing */
 struct PSpinLock_ {
-	volatile pint spin;
+	volatile pint	spin;
+	volatile puint	next_ticket;
+	volatile puint	now_serving;
+	pboolean	fair;
 };
 
 P_LIB_API PSpinLock *
@@ -43,14 +48,44 @@ p_spinlock_new (void)
 	return ret;
 }
 
+P_LIB_API PSpinLock *
+p_spinlock_new_fair (void)
+{
+	PSpinLock *ret;
+
+	if (P_UNLIKELY ((ret = p_spinlock_new ()) == NULL))
+		return NULL;
+
+	ret->fair = TRUE;
+
+	return ret;
+}
+
 P_LIB_API pboolean
 p_spinlock_lock (PSpinLock *spinlock)
 {
+	puint ticket;
+	pint backoff = 1;
+
 	if (P_UNLIKELY (spinlock == NULL))
 		return FALSE;
 
-	while ((pboolean) __sync_bool_compare_and_swap (&(spinlock->spin), 0, 1) == FALSE)
-		;
+	if (spinlock->fair == TRUE) {
+		ticket = __sync_fetch_and_add (&(spinlock->next_ticket), 1);
+
+		while (spinlock->now_serving != ticket)
+			p_spinlock_backoff (&backoff);
+
+		__sync_synchronize ();
+
+		return TRUE;
+	}
+
+	while ((pboolean) __sync_bool_compare_and_swap (&(spinlock->spin), 0, 1) == FALSE) {
+		/* Wait on a shared copy of the cache line until the lock looks free */
+		while (spinlock->spin != 0)
+			p_spinlock_backoff (&backoff);
+	}
 
 	return TRUE;
 }
@@ -58,9 +93,18 @@ p_spinlock_lock (PSpinLock *spinlock)
 P_LIB_API pboolean
 p_spinlock_trylock (PSpinLock *spinlock)
 {
+	puint serving;
+
 	if (P_UNLIKELY (spinlock == NULL))
 		return FALSE;
 
+	if (spinlock->fair == TRUE) {
+		/* The lock is free when no ticket is waiting to be served */
+		serving = spinlock->now_serving;
+
+		return (pboolean) __sync_bool_compare_and_swap (&(spinlock->next_ticket), serving, serving + 1);
+	}
+
 	return (pboolean) __sync_bool_compare_and_swap (&(spinlock->spin), 0, 1);
 }
 
@@ -70,6 +114,15 @@ p_spinlock_unlock (PSpinLock *spinlock)
 	if (P_UNLIKELY (spinlock == NULL))
 		return FALSE;
 
+	if (spinlock->fair == TRUE) {
+		/* Only the owner advances the counter */
+		__sync_synchronize ();
+		spinlock->now_serving = spinlock->now_serving + 1;
+		__sync_synchronize ();
+
+		return TRUE;
+	}
+
 	spinlock->spin = 0;
 	__sync_synchronize ();
 
@@ -26,9 +26,13 @@
 #include "pmem.h"
 #include "patomic.h"
 #include "pspinlock.h"
+#include "pspinlock-private.h"
 
 struct PSpinLock_ {
-	volatile pint spin;
+	volatile pint	spin;
+	volatile pint	next_ticket;
+	volatile pint	now_serving;
+	pboolean	fair;
 };
 
 P_LIB_API PSpinLock *
@@ -44,14 +48,42 @@ p_spinlock_new (void)
 	return ret;
 }
 
+P_LIB_API PSpinLock *
+p_spinlock_new_fair (void)
+{
+	PSpinLock *ret;
+
+	if (P_UNLIKELY ((ret = p_spinlock_new ()) == NULL))
+		return NULL;
+
+	ret->fair = TRUE;
+
+	return ret;
+}
+
 P_LIB_API pboolean
 p_spinlock_lock (PSpinLock *spinlock)
 {
+	pint ticket;
+	pint backoff = 1;
+
 	if (P_UNLIKELY (spinlock == NULL))
 		return FALSE;
 
-	while (p_atomic_int_compare_and_exchange (&(spinlock->spin), 0, 1) == FALSE)
-		;
+	if (spinlock->fair == TRUE) {
+		ticket = p_atomic_int_add (&(spinlock->next_ticket), 1);
+
+		while (p_atomic_int_get (&(spinlock->now_serving)) != ticket)
+			p_spinlock_backoff (&backoff);
+
+		return TRUE;
+	}
+
+	while (p_atomic_int_compare_and_exchange (&(spinlock->spin), 0, 1) == FALSE) {
+		/* Wait on a shared copy of the cache line until the lock looks free */
+		while (spinlock->spin != 0)
+			p_spinlock_backoff (&backoff);
+	}
 
 	return TRUE;
 }
@@ -59,9 +91,21 @@ p_spinlock_lock (PSpinLock *spinlock)
 P_LIB_API pboolean
 p_spinlock_trylock (PSpinLock *spinlock)
 {
+	pint serving;
+
 	if (P_UNLIKELY (spinlock == NULL))
 		return FALSE;
 
+	if (spinlock->fair == TRUE) {
+		/* The lock is free when no ticket is waiting to be served */
+		serving = p_atomic_int_get (&(spinlock->now_serving));
+
+		/* Wrap around in unsigned arithmetic, as the atomic increments do */
+		return p_atomic_int_compare_and_exchange (&(spinlock->next_ticket),
+							  serving,
+							  (pint) ((puint) serving + 1));
+	}
+
 	return p_atomic_int_compare_and_exchange (&(spinlock->spin), 0, 1);
 }
 
@@ -71,6 +115,13 @@ p_spinlock_unlock (PSpinLock *spinlock)
 	if (P_UNLIKELY (spinlock == NULL))
 		return FALSE;
 
+	if (spinlock->fair == TRUE) {
+		/* Only the owner advances the counter */
+		p_atomic_int_inc (&(spinlock->now_serving));
+
+		return TRUE;
+	}
+
 	p_atomic_int_set (&(spinlock->spin), 0);
 
 	return TRUE;
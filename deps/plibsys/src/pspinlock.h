@@ -50,6 +50,12 @@
  * this call, others will wait for the p_spinlock_unlock() call which marks the
  * end of the critical section. This way the critical section code is guarded
  * against concurrent access of multiple threads at once.
+ *
+ * A waiting thread only reads the lock until it looks free, pausing the CPU
+ * with an exponential backoff, so that waiters do not keep stealing the cache
+ * line from the owner. Lock acquisition order is not specified. If many
+ * threads contend for the same lock use p_spinlock_new_fair() instead: it
+ * creates a ticket lock which is acquired in the order of arrival.
  */
 
 #if !defined (PLIBSYS_H_INSIDE) && !defined (PLIBSYS_COMPILATION)
@@ -74,6 +80,19 @@ typedef struct PSpinLock_ PSpinLock;
  */
 P_LIB_API PSpinLock *	p_spinlock_new		(void);
 
+/**
+ * @brief Creates a new fair #PSpinLock object.
+ * @return Pointer to a newly created #PSpinLock object.
+ * @since 0.0.5
+ *
+ * A fair spinlock is a ticket lock: threads acquire it strictly in the order
+ * in which they called p_spinlock_lock(), so none of them can starve. It is
+ * used with the same calls as the spinlock created with p_spinlock_new().
+ * Atomic models without a suitable fetch-and-add operation return a regular
+ * spinlock.
+ */
+P_LIB_API PSpinLock *	p_spinlock_new_fair	(void);
+
 /**
  * @brief Locks a spinlock.
  * @param spinlock #PSpinLock to lock.
@@ -0,0 +1,232 @@
+/*
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "patomic.h"
+#include "ptimeprofiler.h"
+#include "ptimeprofiler-private.h"
+#include "puthread.h"
+
+#if defined (P_CC_GNU) && defined (P_CPU_X86)
+#  include <cpuid.h>
+#  define PP_TIME_PROFILER_HAS_TSC
+#elif defined (P_CC_MSVC) && defined (P_CPU_X86)
+#  include <intrin.h>
+#  define PP_TIME_PROFILER_HAS_TSC
+#elif defined (P_CC_GNU) && defined (P_CPU_ARM_64)
+#  define PP_TIME_PROFILER_HAS_CNTVCT
+#endif
+
+/* Long enough for a microsecond clock to give less than 0.01% of error */
+#define PP_TIME_PROFILER_CALIBRATION_MSECS	20
+
+extern puint64 p_time_profiler_get_ticks_internal (void);
+extern puint64 p_time_profiler_elapsed_usecs_internal (const PTimeProfiler *profiler);
+
+/* Whether the cycle counter is used rather than the profiler clock */
+static pboolean		pp_time_profiler_has_counter = FALSE;
+static pboolean		pp_time_profiler_has_rdtscp  = FALSE;
+/* Origin of the profiler clock when it replaces the cycle counter */
+static PTimeProfiler	pp_time_profiler_origin;
+/* Counter frequency in kHz, zero until calibrated */
+static volatile pint	pp_time_profiler_khz = 0;
+
+#ifdef PP_TIME_PROFILER_HAS_TSC
+static void pp_time_profiler_cpuid (puint32 leaf, puint32 regs[4]);
+
+static void
+pp_time_profiler_cpuid (puint32 leaf, puint32 regs[4])
+{
+#  ifdef P_CC_MSVC
+	__cpuid ((int *) regs, (int) leaf);
+#  else
+	__cpuid (leaf, regs[0], regs[1], regs[2], regs[3]);
+#  endif
+}
+#endif
+
+static puint64
+pp_time_profiler_read (pboolean ordered)
+{
+#if defined (PP_TIME_PROFILER_HAS_TSC) && defined (P_CC_MSVC)
+	puint32 aux;
+
+	if (P_LIKELY (pp_time_profiler_has_counter == TRUE))
+		return (ordered && pp_time_profiler_has_rdtscp) ? __rdtscp (&aux) : __rdtsc ();
+#elif defined (PP_TIME_PROFILER_HAS_TSC)
+	puint32 lo;
+	puint32 hi;
+
+	if (P_LIKELY (pp_time_profiler_has_counter == TRUE)) {
+		/* RDTSCP waits for the measured instructions to complete */
+		if (ordered && pp_time_profiler_has_rdtscp)
+			__asm__ __volatile__ ("rdtscp" : "=a" (lo), "=d" (hi) :: "rcx", "memory");
+		else
+			__asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi) :: "memory");
+
+		return (((puint64) hi) << 32) | lo;
+	}
+#elif defined (PP_TIME_PROFILER_HAS_CNTVCT)
+	puint64 val;
+
+	if (P_LIKELY (pp_time_profiler_has_counter == TRUE)) {
+		if (ordered)
+			__asm__ __volatile__ ("isb" ::: "memory");
+
+		__asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (val) :: "memory");
+
+		return val;
+	}
+#endif
+
+	P_UNUSED (ordered);
+
+	return p_time_profiler_elapsed_usecs_internal (&pp_time_profiler_origin);
+}
+
+static pint
+pp_time_profiler_calibrate (void)
+{
+	PTimeProfiler	clock;
+	puint64		cycles;
+	puint64		usecs;
+
+	if (pp_time_profiler_has_counter == FALSE)
+		return 1000;
+
+#ifdef PP_TIME_PROFILER_HAS_CNTVCT
+	/* The architecture reports the counter frequency */
+	__asm__ __volatile__ ("mrs %0, cntfrq_el0" : "=r" (cycles));
+
+	if (P_LIKELY (cycles >= 1000))
+		return (pint) (cycles / 1000);
+#endif
+
+	clock.counter = p_time_profiler_get_ticks_internal ();
+	cycles        = pp_time_profiler_read (FALSE);
+
+	p_uthread_sleep (PP_TIME_PROFILER_CALIBRATION_MSECS);
+
+	cycles = pp_time_profiler_read (TRUE) - cycles;
+	usecs  = p_time_profiler_elapsed_usecs_internal (&clock);
+
+	if (P_UNLIKELY (usecs == 0 || cycles * 1000 / usecs == 0)) {
+		P_WARNING ("PTimeProfiler::pp_time_profiler_calibrate: failed to calibrate the cycle counter");
+		return 1000;
+	}
+
+	return (pint) (cycles * 1000 / usecs);
+}
+
+void
+p_time_profiler_cycles_init (void)
+{
+#ifdef PP_TIME_PROFILER_HAS_TSC
+	puint32 regs[4];
+#endif
+
+	pp_time_profiler_origin.counter = p_time_profiler_get_ticks_internal ();
+	pp_time_profiler_has_counter    = FALSE;
+	pp_time_profiler_has_rdtscp     = FALSE;
+
+#if defined (PP_TIME_PROFILER_HAS_TSC)
+	/* The TSC must run at a constant rate in all the power states */
+	pp_time_profiler_cpuid (0x80000000, regs);
+
+	if (regs[0] >= 0x80000007) {
+		pp_time_profiler_cpuid (0x80000001, regs);
+		pp_time_profiler_has_rdtscp = (regs[3] & (1U << 27)) != 0;
+
+		pp_time_profiler_cpuid (0x80000007, regs);
+		pp_time_profiler_has_counter = (regs[3] & (1U << 8)) != 0;
+	}
+#elif defined (PP_TIME_PROFILER_HAS_CNTVCT)
+	pp_time_profiler_has_counter = TRUE;
+#endif
+
+	p_atomic_int_set (&pp_time_profiler_khz, 0);
+}
+
+P_LIB_API puint64
+p_time_profiler_cycles_now (void)
+{
+	return pp_time_profiler_read (FALSE);
+}
+
+P_LIB_API void
+p_time_profiler_cycles_start (PTimeProfilerCycles *profiler)
+{
+	if (P_UNLIKELY (profiler == NULL))
+		return;
+
+	profiler->start = pp_time_profiler_read (FALSE);
+	profiler->lap   = profiler->start;
+}
+
+P_LIB_API puint64
+p_time_profiler_cycles_lap (PTimeProfilerCycles *profiler)
+{
+	puint64 now;
+	puint64 lap;
+
+	if (P_UNLIKELY (profiler == NULL))
+		return 0;
+
+	now = pp_time_profiler_read (TRUE);
+	lap = now - profiler->lap;
+
+	profiler->lap = now;
+
+	return lap;
+}
+
+P_LIB_API puint64
+p_time_profiler_cycles_split (const PTimeProfilerCycles *profiler)
+{
+	if (P_UNLIKELY (profiler == NULL))
+		return 0;
+
+	return pp_time_profiler_read (TRUE) - profiler->start;
+}
+
+P_LIB_API puint64
+p_time_profiler_cycles_frequency (void)
+{
+	pint khz;
+
+	/* Concurrent first calls calibrate twice, with similar results */
+	if (P_UNLIKELY ((khz = p_atomic_int_get (&pp_time_profiler_khz)) == 0)) {
+		khz = pp_time_profiler_calibrate ();
+		p_atomic_int_set (&pp_time_profiler_khz, khz);
+	}
+
+	return (puint64) khz * 1000;
+}
+
+P_LIB_API puint64
+p_time_profiler_cycles_to_nsecs (puint64 cycles)
+{
+	puint64 khz = p_time_profiler_cycles_frequency () / 1000;
+
+	/* Split to avoid an overflow of cycles * 10^6 */
+	return (cycles / khz) * 1000000 + (cycles % khz) * 1000000 / khz;
+}
@@ -39,6 +39,16 @@
  * and p_time_profiler_elapsed_usecs() to get elapsed time since the creation.
  * If you need to reset a profiler use p_time_profiler_reset(). Remove a
  * profiler with p_time_profiler_free().
+ *
+ * For timing short operations on a hot path use #PTimeProfilerCycles instead: it
+ * reads the CPU cycle counter directly (TSC on x86, the virtual counter on ARM64)
+ * without a system call, doesn't allocate and can live on the stack. Start it
+ * with p_time_profiler_cycles_start(), take laps with
+ * p_time_profiler_cycles_lap() and splits with p_time_profiler_cycles_split(),
+ * and convert the measured cycles with p_time_profiler_cycles_to_nsecs(). The
+ * counter frequency is calibrated against the system clock on the first
+ * conversion. Where no suitable counter exists, i.e. the TSC rate is not
+ * invariant, cycles are the microseconds of the regular profiler clock.
  */
 
 #if !defined (PLIBSYS_H_INSIDE) && !defined (PLIBSYS_COMPILATION)
@@ -56,6 +66,12 @@ P_BEGIN_DECLS
 /** Time profiler opaque data structure. */
 typedef struct PTimeProfiler_ PTimeProfiler;
 
+/** Cycle counter profiler, can be allocated on the stack. */
+typedef struct PTimeProfilerCycles_ {
+	puint64	start;	/**< Counter value at the start.	*/
+	puint64	lap;	/**< Counter value at the last lap.	*/
+} PTimeProfilerCycles;
+
 /**
  * @brief Creates a new #PTimeProfiler object.
  * @return Pointer to a newly created #PTimeProfiler object.
@@ -88,6 +104,58 @@ P_LIB_API puint64		p_time_profiler_elapsed_usecs	(const PTimeProfiler *	profiler
  */
 P_LIB_API void			p_time_profiler_free		(PTimeProfiler *	profiler);
 
+/**
+ * @brief Reads the cycle counter.
+ * @return Current value of the cycle counter.
+ * @since 0.0.5
+ *
+ * Only differences between values read in the same process are meaningful.
+ */
+P_LIB_API puint64		p_time_profiler_cycles_now	(void);
+
+/**
+ * @brief Starts a cycle counter profiler and its first lap.
+ * @param profiler Cycle counter profiler to start.
+ * @since 0.0.5
+ */
+P_LIB_API void			p_time_profiler_cycles_start	(PTimeProfilerCycles *	profiler);
+
+/**
+ * @brief Ends the current lap of a cycle counter profiler and starts the next
+ * one.
+ * @param profiler Cycle counter profiler.
+ * @return Cycles elapsed since the start of the ended lap.
+ * @since 0.0.5
+ */
+P_LIB_API puint64		p_time_profiler_cycles_lap	(PTimeProfilerCycles *	profiler);
+
+/**
+ * @brief Calculates cycles elapsed since a cycle counter profiler was started.
+ * @param profiler Cycle counter profiler.
+ * @return Cycles elapsed since p_time_profiler_cycles_start().
+ * @since 0.0.5
+ * @note The current lap is not affected.
+ */
+P_LIB_API puint64		p_time_profiler_cycles_split	(const PTimeProfilerCycles *	profiler);
+
+/**
+ * @brief Gets the frequency of the cycle counter.
+ * @return Cycle counter frequency in Hz.
+ * @since 0.0.5
+ *
+ * The first call may take a few milliseconds to calibrate the frequency.
+ */
+P_LIB_API puint64		p_time_profiler_cycles_frequency (void);
+
+/**
+ * @brief Converts cycles to nanoseconds.
+ * @param cycles Number of cycles to convert.
+ * @return Nanoseconds taken by @a cycles.
+ * @since 0.0.5
+ * @note See p_time_profiler_cycles_frequency() about the first call.
+ */
+P_LIB_API puint64		p_time_profiler_cycles_to_nsecs	(puint64		cycles);
+
 P_END_DECLS
 
 #endif /* PLIBSYS_HEADER_PTIMEPROFILER_H */
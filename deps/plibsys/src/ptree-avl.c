@@ -337,6 +337,7 @@ pp_tree_avl_balance_remove (PTreeAVLNode *node, PTreeBaseNode **root)
 
 pboolean
 p_tree_avl_insert (PTreeBaseNode	**root_node,
+		   PTreeArena		*arena,
 		   PCompareDataFunc	compare_func,
 		   ppointer		data,
 		   PDestroyFunc		key_destroy_func,
@@ -379,7 +380,7 @@ p_tree_avl_insert (PTreeBaseNode	**root_node,
 		return FALSE;
 	}
 
-	if (P_UNLIKELY ((*cur_node = p_malloc0 (sizeof (PTreeAVLNode))) == NULL))
+	if (P_UNLIKELY ((*cur_node = p_tree_node_alloc (arena, sizeof (PTreeAVLNode))) == NULL))
 		return FALSE;
 
 	(*cur_node)->key   = key;
@@ -396,6 +397,7 @@ p_tree_avl_insert (PTreeBaseNode	**root_node,
 
 pboolean
 p_tree_avl_remove (PTreeBaseNode	**root_node,
+		   PTreeArena		*arena,
 		   PCompareDataFunc	compare_func,
 		   ppointer		data,
 		   PDestroyFunc		key_destroy_func,
@@ -469,7 +471,7 @@ p_tree_avl_remove (PTreeBaseNode	**root_node,
 	if (value_destroy_func != NULL)
 		value_destroy_func (cur_node->value);
 
-	p_free (cur_node);
+	p_tree_node_free (arena, cur_node);
 
 	return TRUE;
 }
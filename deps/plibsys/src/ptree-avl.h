@@ -37,6 +37,7 @@
 P_BEGIN_DECLS
 
 pboolean	p_tree_avl_insert	(PTreeBaseNode		**root_node,
+					 PTreeArena		*arena,
 					 PCompareDataFunc	compare_func,
 					 ppointer		data,
 					 PDestroyFunc		key_destroy_func,
@@ -45,6 +46,7 @@ pboolean	p_tree_avl_insert	(PTreeBaseNode		**root_node,
 					 ppointer		value);
 
 pboolean	p_tree_avl_remove	(PTreeBaseNode		**root_node,
+					 PTreeArena		*arena,
 					 PCompareDataFunc	compare_func,
 					 ppointer		data,
 					 PDestroyFunc		key_destroy_func,
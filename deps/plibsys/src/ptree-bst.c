@@ -28,6 +28,7 @@
 
 pboolean
 p_tree_bst_insert (PTreeBaseNode	**root_node,
+		   PTreeArena		*arena,
 		   PCompareDataFunc	compare_func,
 		   ppointer		data,
 		   PDestroyFunc		key_destroy_func,
@@ -52,7 +53,7 @@ p_tree_bst_insert (PTreeBaseNode	**root_node,
 	}
 
 	if ((*cur_node) == NULL) {
-		if (P_UNLIKELY ((*cur_node = p_malloc0 (sizeof (PTreeBaseNode))) == NULL))
+		if (P_UNLIKELY ((*cur_node = p_tree_node_alloc (arena, sizeof (PTreeBaseNode))) == NULL))
 			return FALSE;
 
 		(*cur_node)->key   = key;
@@ -75,6 +76,7 @@ p_tree_bst_insert (PTreeBaseNode	**root_node,
 
 pboolean
 p_tree_bst_remove (PTreeBaseNode	**root_node,
+		   PTreeArena		*arena,
 		   PCompareDataFunc	compare_func,
 		   ppointer		data,
 		   PDestroyFunc		key_destroy_func,
@@ -128,7 +130,7 @@ p_tree_bst_remove (PTreeBaseNode	**root_node,
 	if (value_destroy_func != NULL)
 		value_destroy_func (cur_node->value);
 
-	p_free (cur_node);
+	p_tree_node_free (arena, cur_node);
 
 	return TRUE;
 }
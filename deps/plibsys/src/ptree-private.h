@@ -43,6 +43,28 @@ typedef struct PTreeBaseNode_ {
 	ppointer		value;	/**< Node value.	*/
 } PTreeBaseNode;
 
+/** Node arena of a tree, see p_tree_enable_arena(). */
+typedef struct PTreeArena_ PTreeArena;
+
+/**
+ * @brief Allocates a zero-filled tree node.
+ * @param arena Arena to allocate from, NULL to use the heap.
+ * @param size Node size in bytes, the same for every node of an arena.
+ * @return Pointer to the node in case of success, NULL otherwise.
+ */
+ppointer	p_tree_node_alloc	(PTreeArena		*arena,
+					 psize			size);
+
+/**
+ * @brief Frees a node allocated with p_tree_node_alloc().
+ * @param arena Arena the node was allocated from, NULL for the heap.
+ * @param node Node to free.
+ *
+ * A node of an arena is kept for reuse by the next allocation.
+ */
+void		p_tree_node_free	(PTreeArena		*arena,
+					 ppointer		node);
+
 P_END_DECLS
 
 #endif /* PLIBSYS_HEADER_PTREE_PRIVATE_H */
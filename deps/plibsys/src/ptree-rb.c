@@ -339,6 +339,7 @@ pp_tree_rb_balance_remove (PTreeRBNode *node, PTreeBaseNode **root)
 
 pboolean
 p_tree_rb_insert (PTreeBaseNode		**root_node,
+		  PTreeArena		*arena,
 		  PCompareDataFunc	compare_func,
 		  ppointer		data,
 		  PDestroyFunc		key_destroy_func,
@@ -381,7 +382,7 @@ p_tree_rb_insert (PTreeBaseNode		**root_node,
 		return FALSE;
 	}
 
-	if (P_UNLIKELY ((*cur_node = p_malloc0 (sizeof (PTreeRBNode))) == NULL))
+	if (P_UNLIKELY ((*cur_node = p_tree_node_alloc (arena, sizeof (PTreeRBNode))) == NULL))
 		return FALSE;
 
 	(*cur_node)->key   = key;
@@ -398,6 +399,7 @@ p_tree_rb_insert (PTreeBaseNode		**root_node,
 
 pboolean
 p_tree_rb_remove (PTreeBaseNode		**root_node,
+		  PTreeArena		*arena,
 		  PCompareDataFunc	compare_func,
 		  ppointer		data,
 		  PDestroyFunc		key_destroy_func,
@@ -472,7 +474,7 @@ p_tree_rb_remove (PTreeBaseNode		**root_node,
 	if (value_destroy_func != NULL)
 		value_destroy_func (cur_node->value);
 
-	p_free (cur_node);
+	p_tree_node_free (arena, cur_node);
 
 	return TRUE;
 }
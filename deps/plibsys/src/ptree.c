@@ -29,7 +29,12 @@
 #include "ptree-bst.h"
 #include "ptree-rb.h"
 
+#include <string.h>
+
+#define P_TREE_ARENA_DEFAULT_NODES 256
+
 typedef pboolean	(*PTreeInsertNode)	(PTreeBaseNode		**root_node,
+						 PTreeArena		*arena,
 						 PCompareDataFunc	compare_func,
 						 ppointer		data,
 						 PDestroyFunc		key_destroy_func,
@@ -38,6 +43,7 @@ typedef pboolean	(*PTreeInsertNode)	(PTreeBaseNode		**root_node,
 						 ppointer		value);
 
 typedef pboolean	(*PTreeRemoveNode)	(PTreeBaseNode		**root_node,
+						 PTreeArena		*arena,
 						 PCompareDataFunc	compare_func,
 						 ppointer		data,
 						 PDestroyFunc		key_destroy_func,
@@ -46,6 +52,20 @@ typedef pboolean	(*PTreeRemoveNode)	(PTreeBaseNode		**root_node,
 
 typedef void		(*PTreeFreeNode)	(PTreeBaseNode	*node);
 
+typedef struct PTreeArenaBlock_ {
+	struct PTreeArenaBlock_	*next;
+	ppointer		pad;	/* Keeps the nodes 16-byte aligned */
+} PTreeArenaBlock;
+
+struct PTreeArena_ {
+	PTreeArenaBlock		*blocks;	/* The newest block first	*/
+	ppointer		free_nodes;	/* Removed nodes for reuse	*/
+	pchar			*next_node;
+	pchar			*end_node;
+	psize			node_size;
+	psize			block_nodes;
+};
+
 struct PTree_ {
 	PTreeBaseNode		*root;
 	PTreeInsertNode		insert_node_func;
@@ -55,10 +75,87 @@ struct PTree_ {
 	PDestroyFunc		value_destroy_func;
 	PCompareDataFunc	compare_func;
 	ppointer		data;
+	PTreeArena		*arena;
 	PTreeType		type;
 	pint			nnodes;
 };
 
+static void
+pp_tree_arena_release (PTreeArena *arena)
+{
+	PTreeArenaBlock	*block;
+
+	/* Keep the newest block, a cleared tree is likely to be filled again */
+	while (arena->blocks != NULL && arena->blocks->next != NULL) {
+		block                = arena->blocks->next;
+		arena->blocks->next  = block->next;
+
+		p_free (block);
+	}
+
+	arena->free_nodes = NULL;
+
+	if (arena->blocks != NULL) {
+		arena->next_node = (pchar *) (arena->blocks + 1);
+		arena->end_node  = arena->next_node + arena->node_size * arena->block_nodes;
+	}
+}
+
+ppointer
+p_tree_node_alloc (PTreeArena	*arena,
+		   psize	size)
+{
+	PTreeArenaBlock	*block;
+	ppointer	node;
+
+	if (arena == NULL)
+		return p_malloc0 (size);
+
+	if (arena->free_nodes != NULL) {
+		node              = arena->free_nodes;
+		arena->free_nodes = *((ppointer *) node);
+
+		memset (node, 0, size);
+
+		return node;
+	}
+
+	if (arena->node_size == 0)
+		arena->node_size = (size + 15) & ~((psize) 15);
+
+	if (arena->next_node == arena->end_node) {
+		if (P_UNLIKELY ((block = p_malloc (sizeof (PTreeArenaBlock) +
+						   arena->node_size * arena->block_nodes)) == NULL))
+			return NULL;
+
+		block->next   = arena->blocks;
+		arena->blocks = block;
+
+		arena->next_node = (pchar *) (block + 1);
+		arena->end_node  = arena->next_node + arena->node_size * arena->block_nodes;
+	}
+
+	node              = arena->next_node;
+	arena->next_node += arena->node_size;
+
+	memset (node, 0, size);
+
+	return node;
+}
+
+void
+p_tree_node_free (PTreeArena	*arena,
+		  ppointer	node)
+{
+	if (arena == NULL) {
+		p_free (node);
+		return;
+	}
+
+	*((ppointer *) node) = arena->free_nodes;
+	arena->free_nodes    = node;
+}
+
 P_LIB_API PTree *
 p_tree_new (PTreeType		type,
 	    PCompareFunc	func)
@@ -132,6 +229,7 @@ p_tree_insert (PTree	*tree,
 		return;
 
 	result = tree->insert_node_func (&tree->root,
+					 tree->arena,
 					 tree->compare_func,
 					 tree->data,
 					 tree->key_destroy_func,
@@ -153,6 +251,7 @@ p_tree_remove (PTree		*tree,
 		return FALSE;
 
 	result = tree->remove_node_func (&tree->root,
+					 tree->arena,
 					 tree->compare_func,
 					 tree->data,
 					 tree->key_destroy_func,
@@ -257,6 +356,16 @@ p_tree_clear (PTree *tree)
 	if (P_UNLIKELY (tree == NULL || tree->root == NULL))
 		return;
 
+	/* Nothing to call per node, so the arena is released at once */
+	if (tree->arena != NULL && tree->key_destroy_func == NULL && tree->value_destroy_func == NULL) {
+		pp_tree_arena_release (tree->arena);
+
+		tree->root   = NULL;
+		tree->nnodes = 0;
+
+		return;
+	}
+
 	cur_node = tree->root;
 
 	while (cur_node != NULL) {
@@ -269,7 +378,9 @@ p_tree_clear (PTree *tree)
 			if (tree->value_destroy_func != NULL)
 				tree->value_destroy_func (cur_node->value);
 
-			tree->free_node_func (cur_node);
+			if (tree->arena == NULL)
+				tree->free_node_func (cur_node);
+
 			--tree->nnodes;
 
 			cur_node = next_node;
@@ -287,6 +398,9 @@ p_tree_clear (PTree *tree)
 	}
 
 	tree->root = NULL;
+
+	if (tree->arena != NULL)
+		pp_tree_arena_release (tree->arena);
 }
 
 P_LIB_API PTreeType
@@ -307,9 +421,38 @@ p_tree_get_nnodes (const PTree *tree)
 	return tree->nnodes;
 }
 
+P_LIB_API pboolean
+p_tree_enable_arena (PTree	*tree,
+		     psize	block_nodes)
+{
+	if (P_UNLIKELY (tree == NULL || tree->arena != NULL || tree->root != NULL))
+		return FALSE;
+
+	if (P_UNLIKELY ((tree->arena = p_malloc0 (sizeof (PTreeArena))) == NULL)) {
+		P_ERROR ("PTree::p_tree_enable_arena: failed to allocate memory");
+		return FALSE;
+	}
+
+	tree->arena->block_nodes = block_nodes > 0 ? block_nodes : P_TREE_ARENA_DEFAULT_NODES;
+
+	return TRUE;
+}
+
 P_LIB_API void
 p_tree_free (PTree *tree)
 {
+	PTreeArenaBlock	*block;
+
 	p_tree_clear (tree);
+
+	if (tree != NULL && tree->arena != NULL) {
+		while ((block = tree->arena->blocks) != NULL) {
+			tree->arena->blocks = block->next;
+			p_free (block);
+		}
+
+		p_free (tree->arena);
+	}
+
 	p_free (tree);
 }
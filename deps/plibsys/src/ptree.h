@@ -54,6 +54,9 @@
  * and values would be destroyed only if the corresponding notification
  * functions were provided.
  *
+ * A tree which is filled and cleared often can allocate its nodes from an
+ * arena, see p_tree_enable_arena().
+ *
  * Note: all operations with the tree are non-recursive, only iterative calls
  * are used.
  */
@@ -127,6 +130,25 @@ P_LIB_API PTree *	p_tree_new_full		(PTreeType		type,
 						 PDestroyFunc		key_destroy,
 						 PDestroyFunc		value_destroy);
 
+/**
+ * @brief Makes a tree allocate its nodes from an arena.
+ * @param tree Empty #PTree to use the arena for.
+ * @param block_nodes Number of nodes allocated at once, 0 for the default of
+ * 256.
+ * @return TRUE in case of success, FALSE if the tree is not empty, already has
+ * an arena or the arena can't be allocated.
+ * @since 0.0.5
+ *
+ * Nodes are carved from blocks of @a block_nodes nodes with a bump pointer
+ * instead of being allocated one by one, and the nodes of removed keys are
+ * reused. The blocks are only released by p_tree_clear() and p_tree_free(),
+ * which don't have to visit the nodes unless there are key or value destroy
+ * functions to call. Suits large transient trees, which are filled and then
+ * cleared as a whole.
+ */
+P_LIB_API pboolean	p_tree_enable_arena	(PTree			*tree,
+						 psize			block_nodes);
+
 /**
  * @brief Inserts a new key-value pair into a tree.
  * @param tree #PTree to insert a node in.
@@ -192,6 +214,9 @@ P_LIB_API void		p_tree_foreach		(PTree			*tree,
  *
  * All the keys will be deleted. Key and value destroy functions would be called
  * on every node if any of them was provided.
+ *
+ * The nodes of a tree with an arena are released all at once, the last
+ * allocated block is kept for the next insertions.
  */
 P_LIB_API void		p_tree_clear		(PTree			*tree);
 
@@ -222,6 +247,9 @@ P_LIB_API pint		p_tree_get_nnodes	(const PTree		*tree);
  *
  * All the keys will be deleted. Key and value destroy functions would be called
  * on every node if any of them was provided.
+ *
+ * The nodes of a tree with an arena are released all at once together with
+ * every block of the arena.
  */
 P_LIB_API void		p_tree_free		(PTree			*tree);
 
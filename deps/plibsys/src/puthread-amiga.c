@@ -537,6 +537,18 @@ p_uthread_set_priority (PUThread		*thread,
 	return TRUE;
 }
 
+P_LIB_API pboolean
+p_uthread_set_affinity (PUThread	*thread,
+			const pint	*cpus,
+			pint		cpus_count)
+{
+	P_UNUSED (thread);
+	P_UNUSED (cpus);
+	P_UNUSED (cpus_count);
+
+	return FALSE;
+}
+
 P_LIB_API P_HANDLE
 p_uthread_current_id (void)
 {
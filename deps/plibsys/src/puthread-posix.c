@@ -23,6 +23,11 @@
  * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+/* pthread_setaffinity_np() and cpu_set_t are GNU extensions */
+#if defined (PLIBSYS_HAS_POSIX_AFFINITY) && !defined (_GNU_SOURCE)
+#  define _GNU_SOURCE
+#endif
+
 #include "pmem.h"
 #include "patomic.h"
 #include "puthread.h"
@@ -39,7 +44,7 @@
 #include <pthread.h>
 #include <time.h>
 
-#ifdef PLIBSYS_HAS_POSIX_SCHEDULING
+#if defined (PLIBSYS_HAS_POSIX_SCHEDULING) || defined (PLIBSYS_HAS_POSIX_AFFINITY)
 #  ifndef P_OS_VMS
 #    include <sched.h>
 #  endif
@@ -384,6 +389,46 @@ p_uthread_set_priority (PUThread		*thread,
 	return TRUE;
 }
 
+P_LIB_API pboolean
+p_uthread_set_affinity (PUThread	*thread,
+			const pint	*cpus,
+			pint		cpus_count)
+{
+#ifdef PLIBSYS_HAS_POSIX_AFFINITY
+	cpu_set_t	cpu_set;
+	pint		i;
+#endif
+
+	if (P_UNLIKELY (thread == NULL || cpus_count < 0 || (cpus == NULL && cpus_count > 0)))
+		return FALSE;
+
+#ifdef PLIBSYS_HAS_POSIX_AFFINITY
+	CPU_ZERO (&cpu_set);
+
+	if (cpus_count == 0) {
+		/* The kernel drops the CPUs which are not present */
+		for (i = 0; i < CPU_SETSIZE; ++i)
+			CPU_SET (i, &cpu_set);
+	} else {
+		for (i = 0; i < cpus_count; ++i) {
+			if (P_UNLIKELY (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE))
+				return FALSE;
+
+			CPU_SET (cpus[i], &cpu_set);
+		}
+	}
+
+	if (P_UNLIKELY (pthread_setaffinity_np (thread->hdl, sizeof (cpu_set), &cpu_set) != 0)) {
+		P_ERROR ("PUThread::p_uthread_set_affinity: pthread_setaffinity_np() failed");
+		return FALSE;
+	}
+
+	return TRUE;
+#else
+	return FALSE;
+#endif
+}
+
 P_LIB_API P_HANDLE
 p_uthread_current_id (void)
 {
@@ -45,6 +45,8 @@ typedef struct PUThreadBase_ {
 	PUThreadFunc		func;		/**< Thread routine.	*/
 	ppointer		data;		/**< Thread input data.	*/
 	PUThreadPriority	prio;		/**< Thread priority.	*/
+	pint			*cpus;		/**< CPUs to bind to.	*/
+	pint			cpus_count;	/**< Number of CPUs.	*/
 } PUThreadBase;
 
 P_END_DECLS
@@ -310,6 +310,40 @@ p_uthread_set_priority (PUThread		*thread,
 	return TRUE;
 }
 
+P_LIB_API pboolean
+p_uthread_set_affinity (PUThread	*thread,
+			const pint	*cpus,
+			pint		cpus_count)
+{
+	DWORD_PTR	mask;
+	DWORD_PTR	sys_mask;
+	pint		i;
+
+	if (P_UNLIKELY (thread == NULL || cpus_count < 0 || (cpus == NULL && cpus_count > 0)))
+		return FALSE;
+
+	if (cpus_count == 0) {
+		if (P_UNLIKELY (GetProcessAffinityMask (GetCurrentProcess (), &mask, &sys_mask) == 0)) {
+			P_ERROR ("PUThread::p_uthread_set_affinity: GetProcessAffinityMask() failed");
+			return FALSE;
+		}
+	} else {
+		for (i = 0, mask = 0; i < cpus_count; ++i) {
+			if (P_UNLIKELY (cpus[i] < 0 || cpus[i] >= (pint) (sizeof (DWORD_PTR) * 8)))
+				return FALSE;
+
+			mask |= ((DWORD_PTR) 1) << cpus[i];
+		}
+	}
+
+	if (P_UNLIKELY (SetThreadAffinityMask (thread->hdl, mask) == 0)) {
+		P_ERROR ("PUThread::p_uthread_set_affinity: SetThreadAffinityMask() failed");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 P_LIB_API P_HANDLE
 p_uthread_current_id (void)
 {
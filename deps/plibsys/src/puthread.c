@@ -49,6 +49,11 @@
 
 #ifdef P_OS_WIN
 typedef void (WINAPI * SystemInfoFunc) (LPSYSTEM_INFO);
+typedef BOOL (WINAPI * NumaNodeMaskFunc) (UCHAR, PULONGLONG);
+#endif
+
+#ifdef P_OS_LINUX
+#  include <stdio.h>
 #endif
 
 #ifdef P_OS_HPUX
@@ -134,6 +139,16 @@ pp_uthread_proxy (ppointer data)
 	p_spinlock_lock (pp_uthread_new_spin);
 	p_spinlock_unlock (pp_uthread_new_spin);
 
+	if (base_thread->cpus != NULL) {
+		if (P_UNLIKELY (p_uthread_set_affinity ((PUThread *) base_thread,
+							base_thread->cpus,
+							base_thread->cpus_count) == FALSE))
+			P_WARNING ("PUThread::pp_uthread_proxy: failed to set affinity");
+
+		p_free (base_thread->cpus);
+		base_thread->cpus = NULL;
+	}
+
 	base_thread->func (base_thread->data);
 
 	return NULL;
@@ -183,11 +198,35 @@ p_uthread_create_full (PUThreadFunc	func,
 		       PUThreadPriority	prio,
 		       psize		stack_size)
 {
-	PUThreadBase *base_thread;
+	/* All checks will be inside */
+	return p_uthread_create_affine (func, data, joinable, prio, stack_size, NULL, 0);
+}
+
+P_LIB_API PUThread *
+p_uthread_create_affine (PUThreadFunc		func,
+			 ppointer		data,
+			 pboolean		joinable,
+			 PUThreadPriority	prio,
+			 psize			stack_size,
+			 const pint		*cpus,
+			 pint			cpus_count)
+{
+	PUThreadBase	*base_thread;
+	pint		*thread_cpus = NULL;
 
-	if (P_UNLIKELY (func == NULL))
+	if (P_UNLIKELY (func == NULL || cpus_count < 0 || (cpus == NULL && cpus_count > 0)))
 		return NULL;
 
+	/* Applied by the thread itself in the proxy, before the main function */
+	if (cpus_count > 0) {
+		if (P_UNLIKELY ((thread_cpus = p_malloc (sizeof (pint) * (psize) cpus_count)) == NULL)) {
+			P_ERROR ("PUThread::p_uthread_create_affine: failed to allocate memory");
+			return NULL;
+		}
+
+		memcpy (thread_cpus, cpus, sizeof (pint) * (psize) cpus_count);
+	}
+
 	p_spinlock_lock (pp_uthread_new_spin);
 
 	base_thread = (PUThreadBase *) p_uthread_create_internal (pp_uthread_proxy,
@@ -196,15 +235,20 @@ p_uthread_create_full (PUThreadFunc	func,
 								  stack_size);
 
 	if (P_LIKELY (base_thread != NULL)) {
-		base_thread->ref_count = 2;
-		base_thread->ours      = TRUE;
-		base_thread->joinable  = joinable;
-		base_thread->func      = func;
-		base_thread->data      = data;
+		base_thread->ref_count  = 2;
+		base_thread->ours       = TRUE;
+		base_thread->joinable   = joinable;
+		base_thread->func       = func;
+		base_thread->data       = data;
+		base_thread->cpus       = thread_cpus;
+		base_thread->cpus_count = cpus_count;
 	}
 
 	p_spinlock_unlock (pp_uthread_new_spin);
 
+	if (P_UNLIKELY (base_thread == NULL && thread_cpus != NULL))
+		p_free (thread_cpus);
+
 	return (PUThread *) base_thread;
 }
 
@@ -436,6 +480,79 @@ p_uthread_ideal_count (void)
 #endif
 }
 
+P_LIB_API pint
+p_uthread_numa_node_cpus (pint	node,
+			  pint	*cpus,
+			  pint	max_count)
+{
+#if defined (P_OS_WIN)
+	NumaNodeMaskFunc	node_mask_func;
+	ULONGLONG		mask;
+	pint			count;
+	pint			i;
+#elif defined (P_OS_LINUX)
+	pchar			path[64];
+	FILE			*file;
+	pint			first;
+	pint			last;
+	pint			count;
+	pint			c;
+#endif
+
+	if (P_UNLIKELY (node < 0 || cpus == NULL || max_count <= 0))
+		return -1;
+
+#if defined (P_OS_WIN)
+	node_mask_func = (NumaNodeMaskFunc) GetProcAddress (GetModuleHandleA ("kernel32.dll"),
+							    "GetNumaNodeProcessorMask");
+
+	if (P_UNLIKELY (node_mask_func == NULL || node > 0xFF))
+		return -1;
+
+	if (P_UNLIKELY (node_mask_func ((UCHAR) node, &mask) == 0))
+		return -1;
+
+	for (i = 0, count = 0; i < 64 && count < max_count; ++i) {
+		if ((mask & (((ULONGLONG) 1) << i)) != 0)
+			cpus[count++] = i;
+	}
+
+	return count;
+#elif defined (P_OS_LINUX)
+	/* A list of CPU ranges, i.e. "0-3,8-11" */
+	snprintf (path, sizeof (path), "/sys/devices/system/node/node%d/cpulist", node);
+
+	if (P_UNLIKELY ((file = fopen (path, "r")) == NULL))
+		return -1;
+
+	count = 0;
+
+	while (count < max_count && fscanf (file, "%d", &first) == 1) {
+		last = first;
+		c    = fgetc (file);
+
+		if (c == '-') {
+			if (P_UNLIKELY (fscanf (file, "%d", &last) != 1))
+				break;
+
+			c = fgetc (file);
+		}
+
+		for (; first <= last && count < max_count; ++first)
+			cpus[count++] = first;
+
+		if (c != ',')
+			break;
+	}
+
+	fclose (file);
+
+	return count > 0 ? count : -1;
+#else
+	return -1;
+#endif
+}
+
 P_LIB_API void
 p_uthread_ref (PUThread *thread)
 {
@@ -135,6 +135,35 @@ P_LIB_API PUThread *	p_uthread_create_full	(PUThreadFunc		func,
 						 PUThreadPriority	prio,
 						 psize			stack_size);
 
+/**
+ * @brief Creates a new #PUThread bound to a set of CPUs and starts it.
+ * @param func Main thread function to run.
+ * @param data Pointer to pass into the thread main function, may be NULL.
+ * @param joinable Whether to create a joinable thread or not.
+ * @param prio Thread priority.
+ * @param stack_size Thread stack size, in bytes. Leave zero to use a default
+ * value.
+ * @param cpus Array of CPU indexes (starting from 0) to run the thread on.
+ * @param cpus_count Number of elements in @a cpus, leave zero to run on any CPU.
+ * @return Pointer to #PUThread in case of success, NULL otherwise.
+ * @since 0.0.5
+ * @note Unreference the returned value after use with p_uthread_unref(). You do
+ * not need to call p_uthread_ref() explicitly on the returned value.
+ *
+ * The affinity is set by the new thread itself before @a func is called, so
+ * all the memory touched first by @a func is allocated on the NUMA node of the
+ * given CPUs with the default first-touch policy. Use
+ * p_uthread_numa_node_cpus() to bind a thread to a NUMA node. If the affinity
+ * can't be set the thread runs on any CPU.
+ */
+P_LIB_API PUThread *	p_uthread_create_affine	(PUThreadFunc		func,
+						 ppointer		data,
+						 pboolean		joinable,
+						 PUThreadPriority	prio,
+						 psize			stack_size,
+						 const pint		*cpus,
+						 pint			cpus_count);
+
 /**
  * @brief Creates a #PUThread and starts it. A short version of
  * p_uthread_create_full().
@@ -184,6 +213,39 @@ P_LIB_API pint		p_uthread_sleep		(puint32		msec);
 P_LIB_API pboolean	p_uthread_set_priority	(PUThread		*thread,
 						 PUThreadPriority	prio);
 
+/**
+ * @brief Binds a thread to a set of CPUs.
+ * @param thread Thread to set the affinity for.
+ * @param cpus Array of CPU indexes (starting from 0) to run the thread on.
+ * @param cpus_count Number of elements in @a cpus, zero to run on any CPU.
+ * @return TRUE in case of success, FALSE otherwise.
+ * @since 0.0.5
+ * @note The thread must be created with p_uthread_create_full() or
+ * p_uthread_create_affine().
+ *
+ * Supported on Linux and Windows only, on Windows only the first 64 CPUs (32
+ * on 32-bit systems) can be used.
+ */
+P_LIB_API pboolean	p_uthread_set_affinity	(PUThread		*thread,
+						 const pint		*cpus,
+						 pint			cpus_count);
+
+/**
+ * @brief Gets the CPUs of a NUMA node.
+ * @param node NUMA node index, starting from 0.
+ * @param[out] cpus Array to store the CPU indexes of the node into.
+ * @param max_count Number of elements in @a cpus.
+ * @return Number of CPUs stored into @a cpus in case of success, -1 otherwise.
+ * @since 0.0.5
+ *
+ * The result can be passed to p_uthread_create_affine() or
+ * p_uthread_set_affinity() to run a thread on the node. Supported on Linux and
+ * Windows only.
+ */
+P_LIB_API pint		p_uthread_numa_node_cpus (pint			node,
+						  pint			*cpus,
+						  pint			max_count);
+
 /**
  * @brief Tells the scheduler to skip the current (caller) thread in the current
  * planning stage.
@@ -165,6 +165,8 @@ P_TEST_CASE_BEGIN (pcondvariable_bad_input_test)
 	P_TEST_REQUIRE (p_cond_variable_broadcast (NULL) == FALSE);
 	P_TEST_REQUIRE (p_cond_variable_signal (NULL) == FALSE);
 	P_TEST_REQUIRE (p_cond_variable_wait (NULL, NULL) == FALSE);
+	P_TEST_REQUIRE (p_cond_variable_wait_for (NULL, NULL, 0) == FALSE);
+	P_TEST_REQUIRE (p_cond_variable_wait_until (NULL, NULL, NULL, 0) == FALSE);
 	p_cond_variable_free (NULL);
 
 	p_libsys_shutdown ();
@@ -221,10 +223,82 @@ P_TEST_CASE_BEGIN (pcondvariable_general_test)
 }
 P_TEST_CASE_END ()
 
+static void * timed_signal_thread (void *)
+{
+	p_uthread_sleep (50);
+
+	p_mutex_lock (cond_mutex);
+	is_working = FALSE;
+	p_cond_variable_signal (queue_full_cond);
+	p_mutex_unlock (cond_mutex);
+
+	p_uthread_exit (0);
+
+	return NULL;
+}
+
+P_TEST_CASE_BEGIN (pcondvariable_timed_test)
+{
+	PTimeProfiler	*profiler;
+	PUThread	*thr;
+	puint64		elapsed;
+	pboolean	signalled;
+
+	p_libsys_init ();
+
+	queue_full_cond = p_cond_variable_new ();
+	P_TEST_REQUIRE (queue_full_cond != NULL);
+	cond_mutex = p_mutex_new ();
+	P_TEST_REQUIRE (cond_mutex != NULL);
+	profiler = p_time_profiler_new ();
+	P_TEST_REQUIRE (profiler != NULL);
+
+	/* Nobody signals, the wait must time out */
+	P_TEST_CHECK (p_mutex_lock (cond_mutex) == TRUE);
+	P_TEST_CHECK (p_cond_variable_wait_for (queue_full_cond, cond_mutex, 100000) == FALSE);
+	elapsed = p_time_profiler_elapsed_usecs (profiler);
+	P_TEST_CHECK (elapsed >= 90000 && elapsed < 2000000);
+
+	/* The deadline has already passed */
+	P_TEST_CHECK (p_cond_variable_wait_until (queue_full_cond, cond_mutex, profiler, 1000) == FALSE);
+	P_TEST_CHECK (p_mutex_unlock (cond_mutex) == TRUE);
+
+	/* Signalled well before the deadline */
+	is_working = TRUE;
+
+	P_TEST_CHECK (p_mutex_lock (cond_mutex) == TRUE);
+
+	thr = p_uthread_create ((PUThreadFunc) timed_signal_thread, NULL, TRUE);
+	P_TEST_REQUIRE (thr != NULL);
+
+	p_time_profiler_reset (profiler);
+	signalled = FALSE;
+
+	while (is_working == TRUE &&
+	       p_cond_variable_wait_until (queue_full_cond, cond_mutex, profiler, 10000000) == TRUE)
+		signalled = TRUE;
+
+	P_TEST_CHECK (signalled == TRUE);
+	P_TEST_CHECK (is_working == FALSE);
+	P_TEST_CHECK (p_time_profiler_elapsed_usecs (profiler) < 10000000);
+	P_TEST_CHECK (p_mutex_unlock (cond_mutex) == TRUE);
+
+	P_TEST_CHECK (p_uthread_join (thr) == 0);
+
+	p_uthread_unref (thr);
+	p_time_profiler_free (profiler);
+	p_cond_variable_free (queue_full_cond);
+	p_mutex_free (cond_mutex);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
 P_TEST_SUITE_BEGIN()
 {
 	P_TEST_SUITE_RUN_CASE (pcondvariable_nomem_test);
 	P_TEST_SUITE_RUN_CASE (pcondvariable_bad_input_test);
 	P_TEST_SUITE_RUN_CASE (pcondvariable_general_test);
+	P_TEST_SUITE_RUN_CASE (pcondvariable_timed_test);
 }
 P_TEST_SUITE_END()
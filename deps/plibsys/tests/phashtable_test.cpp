@@ -32,6 +32,7 @@
 P_TEST_MODULE_INIT ();
 
 #define PHASHTABLE_STRESS_COUNT	10000
+#define PHASHTABLE_LARGE_COUNT	200000
 
 extern "C" ppointer pmem_alloc (psize nbytes)
 {
@@ -310,11 +311,57 @@ P_TEST_CASE_BEGIN (phashtable_stress_test)
 }
 P_TEST_CASE_END ()
 
+P_TEST_CASE_BEGIN (phashtable_large_test)
+{
+	pint i;
+
+	p_libsys_init ();
+
+	PHashTable *table = p_hash_table_new ();
+	P_TEST_REQUIRE (table != NULL);
+
+	/* Sequential keys, as sensor IDs would be */
+	for (i = 0; i < PHASHTABLE_LARGE_COUNT; ++i)
+		p_hash_table_insert (table, PINT_TO_POINTER (i), PINT_TO_POINTER (i * 2 + 1));
+
+	for (i = 0; i < PHASHTABLE_LARGE_COUNT; ++i)
+		P_TEST_REQUIRE (p_hash_table_lookup (table, PINT_TO_POINTER (i)) == PINT_TO_POINTER (i * 2 + 1));
+
+	P_TEST_CHECK (p_hash_table_lookup (table, PINT_TO_POINTER (PHASHTABLE_LARGE_COUNT)) == (ppointer) (-1));
+
+	/* Remove the even keys, the odd ones must survive the shifts */
+	for (i = 0; i < PHASHTABLE_LARGE_COUNT; i += 2)
+		p_hash_table_remove (table, PINT_TO_POINTER (i));
+
+	for (i = 0; i < PHASHTABLE_LARGE_COUNT; ++i) {
+		if (i % 2 == 0)
+			P_TEST_REQUIRE (p_hash_table_lookup (table, PINT_TO_POINTER (i)) == (ppointer) (-1));
+		else
+			P_TEST_REQUIRE (p_hash_table_lookup (table, PINT_TO_POINTER (i)) == PINT_TO_POINTER (i * 2 + 1));
+	}
+
+	/* Shrink back while removing the rest */
+	for (i = 1; i < PHASHTABLE_LARGE_COUNT; i += 2) {
+		p_hash_table_remove (table, PINT_TO_POINTER (i));
+
+		if (i + 2 < PHASHTABLE_LARGE_COUNT && i % 1001 == 0)
+			P_TEST_REQUIRE (p_hash_table_lookup (table, PINT_TO_POINTER (i + 2)) == PINT_TO_POINTER ((i + 2) * 2 + 1));
+	}
+
+	P_TEST_CHECK (p_hash_table_keys (table) == NULL);
+
+	p_hash_table_free (table);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
 P_TEST_SUITE_BEGIN()
 {
 	P_TEST_SUITE_RUN_CASE (phashtable_nomem_test);
 	P_TEST_SUITE_RUN_CASE (phashtable_invalid_test);
 	P_TEST_SUITE_RUN_CASE (phashtable_general_test);
 	P_TEST_SUITE_RUN_CASE (phashtable_stress_test);
+	P_TEST_SUITE_RUN_CASE (phashtable_large_test);
 }
 P_TEST_SUITE_END()
@@ -0,0 +1,342 @@
+/*
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "plibsys.h"
+#include "ptestmacros.h"
+
+P_TEST_MODULE_INIT ();
+
+#define PHISTOGRAM_THREADS	4
+#define PHISTOGRAM_VALUES	100000
+
+static PHistogram * shared_hist = NULL;
+static PHistogram * merged_hist = NULL;
+
+extern "C" ppointer pmem_alloc (psize nbytes)
+{
+	P_UNUSED (nbytes);
+	return (ppointer) NULL;
+}
+
+extern "C" ppointer pmem_realloc (ppointer block, psize nbytes)
+{
+	P_UNUSED (block);
+	P_UNUSED (nbytes);
+	return (ppointer) NULL;
+}
+
+extern "C" void pmem_free (ppointer block)
+{
+	P_UNUSED (block);
+}
+
+static void * histogram_test_thread (void *)
+{
+	PHistogram *local = p_histogram_new (7);
+
+	if (local == NULL)
+		p_uthread_exit (1);
+
+	for (pint i = 1; i <= PHISTOGRAM_VALUES; ++i) {
+		p_histogram_record (local, (puint64) i);
+		p_histogram_record_atomic (shared_hist, (puint64) i);
+
+		/* Merge while the other threads are still recording */
+		if (i % (PHISTOGRAM_VALUES / 4) == 0) {
+			if (!p_histogram_merge (merged_hist, local))
+				p_uthread_exit (1);
+
+			p_histogram_reset (local);
+		}
+	}
+
+	p_histogram_free (local);
+
+	p_uthread_exit (0);
+
+	return NULL;
+}
+
+P_TEST_CASE_BEGIN (phistogram_nomem_test)
+{
+	p_libsys_init ();
+
+	PHistogram	*hist;
+	puint8		*data;
+	psize		size;
+	PMemVTable	vtable;
+
+	hist = p_histogram_new (7);
+	P_TEST_REQUIRE (hist != NULL);
+
+	p_histogram_record (hist, 1000);
+
+	data = p_histogram_serialize (hist, &size);
+	P_TEST_REQUIRE (data != NULL);
+
+	vtable.free    = pmem_free;
+	vtable.malloc  = pmem_alloc;
+	vtable.realloc = pmem_realloc;
+
+	P_TEST_CHECK (p_mem_set_vtable (&vtable) == TRUE);
+
+	P_TEST_CHECK (p_histogram_new (7) == NULL);
+	P_TEST_CHECK (p_histogram_serialize (hist, &size) == NULL);
+	P_TEST_CHECK (p_histogram_deserialize (data, size) == NULL);
+
+	p_mem_restore_vtable ();
+
+	p_free (data);
+	p_histogram_free (hist);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
+P_TEST_CASE_BEGIN (phistogram_bad_input_test)
+{
+	PHistogram	*hist1, *hist2;
+	psize		size;
+
+	p_libsys_init ();
+
+	P_TEST_CHECK (p_histogram_new (0) == NULL);
+	P_TEST_CHECK (p_histogram_new (17) == NULL);
+	P_TEST_CHECK (p_histogram_merge (NULL, NULL) == FALSE);
+	P_TEST_CHECK (p_histogram_count (NULL) == 0);
+	P_TEST_CHECK (p_histogram_min (NULL) == 0);
+	P_TEST_CHECK (p_histogram_max (NULL) == 0);
+	P_TEST_CHECK (p_histogram_mean (NULL) == 0.0);
+	P_TEST_CHECK (p_histogram_value_at_percentile (NULL, 50.0) == 0);
+	P_TEST_CHECK (p_histogram_serialize (NULL, &size) == NULL);
+	P_TEST_CHECK (p_histogram_deserialize (NULL, 0) == NULL);
+
+	p_histogram_record (NULL, 0);
+	p_histogram_record_atomic (NULL, 0);
+	p_histogram_reset (NULL);
+	p_histogram_free (NULL);
+
+	hist1 = p_histogram_new (7);
+	hist2 = p_histogram_new (8);
+
+	P_TEST_REQUIRE (hist1 != NULL);
+	P_TEST_REQUIRE (hist2 != NULL);
+
+	P_TEST_CHECK (p_histogram_serialize (hist1, NULL) == NULL);
+	P_TEST_CHECK (p_histogram_merge (hist1, hist2) == FALSE);
+
+	p_histogram_free (hist2);
+	p_histogram_free (hist1);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
+P_TEST_CASE_BEGIN (phistogram_general_test)
+{
+	PHistogram	*hist;
+	puint64		value;
+	puint64		reported;
+
+	p_libsys_init ();
+
+	hist = p_histogram_new (7);
+	P_TEST_REQUIRE (hist != NULL);
+
+	P_TEST_CHECK (p_histogram_count (hist) == 0);
+	P_TEST_CHECK (p_histogram_min (hist) == 0);
+	P_TEST_CHECK (p_histogram_max (hist) == 0);
+	P_TEST_CHECK (p_histogram_mean (hist) == 0.0);
+	P_TEST_CHECK (p_histogram_value_at_percentile (hist, 99.0) == 0);
+
+	/* Small values are exact */
+	for (puint64 i = 1; i <= 100; ++i)
+		p_histogram_record (hist, i);
+
+	P_TEST_CHECK (p_histogram_count (hist) == 100);
+	P_TEST_CHECK (p_histogram_min (hist) == 1);
+	P_TEST_CHECK (p_histogram_max (hist) == 100);
+	P_TEST_CHECK (p_histogram_mean (hist) == 50.5);
+	P_TEST_CHECK (p_histogram_value_at_percentile (hist, 0.0) == 1);
+	P_TEST_CHECK (p_histogram_value_at_percentile (hist, 50.0) == 50);
+	P_TEST_CHECK (p_histogram_value_at_percentile (hist, 99.0) == 99);
+	P_TEST_CHECK (p_histogram_value_at_percentile (hist, 99.9) == 100);
+	P_TEST_CHECK (p_histogram_value_at_percentile (hist, 100.0) == 100);
+	P_TEST_CHECK (p_histogram_value_at_percentile (hist, 150.0) == 100);
+
+	p_histogram_reset (hist);
+	P_TEST_CHECK (p_histogram_count (hist) == 0);
+
+	/* Larger values keep the relative precision over the whole range */
+	for (pint shift = 0; shift < 64; ++shift) {
+		for (puint64 mul = 1; mul < 16; ++mul) {
+			value = (mul * 0x9E3779B97F4A7C15ULL) >> shift;
+
+			p_histogram_reset (hist);
+			p_histogram_record (hist, value);
+
+			reported = p_histogram_value_at_percentile (hist, 50.0);
+
+			P_TEST_CHECK (p_histogram_min (hist) <= value);
+			P_TEST_CHECK (p_histogram_max (hist) == reported);
+			P_TEST_CHECK (reported >= value);
+			P_TEST_CHECK (reported - value <= value / 64);
+		}
+	}
+
+	p_histogram_reset (hist);
+	p_histogram_record (hist, P_MAXUINT64);
+	P_TEST_CHECK (p_histogram_max (hist) == P_MAXUINT64);
+
+	p_histogram_free (hist);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
+P_TEST_CASE_BEGIN (phistogram_merge_test)
+{
+	PUThread	*threads[PHISTOGRAM_THREADS];
+	puint64		p50;
+
+	p_libsys_init ();
+
+	shared_hist = p_histogram_new (7);
+	merged_hist = p_histogram_new (7);
+
+	P_TEST_REQUIRE (shared_hist != NULL);
+	P_TEST_REQUIRE (merged_hist != NULL);
+
+	for (pint i = 0; i < PHISTOGRAM_THREADS; ++i) {
+		threads[i] = p_uthread_create ((PUThreadFunc) histogram_test_thread, NULL, true);
+		P_TEST_REQUIRE (threads[i] != NULL);
+	}
+
+	for (pint i = 0; i < PHISTOGRAM_THREADS; ++i) {
+		P_TEST_CHECK (p_uthread_join (threads[i]) == 0);
+		p_uthread_unref (threads[i]);
+	}
+
+	P_TEST_CHECK (p_histogram_count (shared_hist) == PHISTOGRAM_THREADS * PHISTOGRAM_VALUES);
+	P_TEST_CHECK (p_histogram_count (merged_hist) == PHISTOGRAM_THREADS * PHISTOGRAM_VALUES);
+
+	for (pint i = 0; i <= 1000; ++i) {
+		P_TEST_CHECK (p_histogram_value_at_percentile (shared_hist, i / 10.0) ==
+			      p_histogram_value_at_percentile (merged_hist, i / 10.0));
+	}
+
+	p50 = p_histogram_value_at_percentile (merged_hist, 50.0);
+
+	P_TEST_CHECK (p50 >= PHISTOGRAM_VALUES / 2);
+	P_TEST_CHECK (p50 - PHISTOGRAM_VALUES / 2 <= PHISTOGRAM_VALUES / 2 / 64);
+	P_TEST_CHECK (p_histogram_min (merged_hist) == 1);
+
+	p_histogram_free (merged_hist);
+	p_histogram_free (shared_hist);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
+P_TEST_CASE_BEGIN (phistogram_serialize_test)
+{
+	PHistogram	*hist;
+	PHistogram	*restored;
+	puint8		*data;
+	psize		size;
+
+	p_libsys_init ();
+
+	hist = p_histogram_new (10);
+	P_TEST_REQUIRE (hist != NULL);
+
+	/* Empty histogram */
+	data = p_histogram_serialize (hist, &size);
+	P_TEST_REQUIRE (data != NULL);
+	P_TEST_CHECK (size == 6);
+
+	restored = p_histogram_deserialize (data, size);
+	P_TEST_REQUIRE (restored != NULL);
+	P_TEST_CHECK (p_histogram_count (restored) == 0);
+	P_TEST_CHECK (p_histogram_merge (restored, hist) == TRUE);
+
+	p_histogram_free (restored);
+	p_free (data);
+
+	for (puint64 i = 0; i < 100000; ++i)
+		p_histogram_record (hist, i * i);
+
+	p_histogram_record (hist, 0);
+	p_histogram_record (hist, P_MAXUINT64);
+
+	data = p_histogram_serialize (hist, &size);
+	P_TEST_REQUIRE (data != NULL);
+
+	restored = p_histogram_deserialize (data, size);
+	P_TEST_REQUIRE (restored != NULL);
+
+	P_TEST_CHECK (p_histogram_count (restored) == p_histogram_count (hist));
+	P_TEST_CHECK (p_histogram_min (restored) == 0);
+	P_TEST_CHECK (p_histogram_max (restored) == P_MAXUINT64);
+	P_TEST_CHECK (p_histogram_mean (restored) == p_histogram_mean (hist));
+
+	for (pint i = 0; i <= 100; ++i) {
+		P_TEST_CHECK (p_histogram_value_at_percentile (restored, i) ==
+			      p_histogram_value_at_percentile (hist, i));
+	}
+
+	/* Malformed data */
+	P_TEST_CHECK (p_histogram_deserialize (data, 5) == NULL);
+	P_TEST_CHECK (p_histogram_deserialize (data, size - 1) == NULL);
+
+	data[0] = 'X';
+	P_TEST_CHECK (p_histogram_deserialize (data, size) == NULL);
+	data[0] = 'P';
+
+	data[5] = 17;
+	P_TEST_CHECK (p_histogram_deserialize (data, size) == NULL);
+	data[5] = 10;
+
+	/* Bucket index past the end */
+	data[6] = 0xFF;
+	data[7] = 0xFF;
+	data[8] = 0x7F;
+	P_TEST_CHECK (p_histogram_deserialize (data, size) == NULL);
+
+	p_histogram_free (restored);
+	p_histogram_free (hist);
+	p_free (data);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
+P_TEST_SUITE_BEGIN()
+{
+	P_TEST_SUITE_RUN_CASE (phistogram_nomem_test);
+	P_TEST_SUITE_RUN_CASE (phistogram_bad_input_test);
+	P_TEST_SUITE_RUN_CASE (phistogram_general_test);
+	P_TEST_SUITE_RUN_CASE (phistogram_merge_test);
+	P_TEST_SUITE_RUN_CASE (phistogram_serialize_test);
+}
+P_TEST_SUITE_END()
@@ -77,13 +77,54 @@ P_TEST_CASE_BEGIN (plist_nomem_test)
 	vtable.malloc  = pmem_alloc;
 	vtable.realloc = pmem_realloc;
 
+	PListHead	head;
+	PListPool	*pool;
+	ppointer	bulk[2] = {PINT_TO_POINTER (1), PINT_TO_POINTER (2)};
+
+	pool = p_list_pool_new (2);
+	P_TEST_REQUIRE (pool != NULL);
+
 	P_TEST_CHECK (p_mem_set_vtable (&vtable) == TRUE);
 
 	P_TEST_CHECK (p_list_append (NULL, PINT_TO_POINTER (10)) == NULL);
 	P_TEST_CHECK (p_list_prepend (NULL, PINT_TO_POINTER (10)) == NULL);
+	P_TEST_CHECK (p_list_pool_new (0) == NULL);
+
+	p_list_head_init (&head, NULL);
+
+	P_TEST_CHECK (p_list_head_append (&head, PINT_TO_POINTER (10)) == FALSE);
+	P_TEST_CHECK (p_list_head_prepend (&head, PINT_TO_POINTER (10)) == FALSE);
+	P_TEST_CHECK (p_list_head_append_bulk (&head, bulk, 2) == FALSE);
+	P_TEST_CHECK (head.first == NULL && head.last == NULL && head.length == 0);
+
+	/* A pool can't grow either, and a failed bulk append gives the nodes back */
+	p_list_head_init (&head, pool);
+
+	P_TEST_CHECK (p_list_head_append (&head, PINT_TO_POINTER (10)) == FALSE);
+	P_TEST_CHECK (p_list_head_append_bulk (&head, bulk, 2) == FALSE);
+	P_TEST_CHECK (head.first == NULL && head.length == 0);
+
+	p_mem_restore_vtable ();
+
+	P_TEST_CHECK (p_list_head_append_bulk (&head, bulk, 2) == TRUE);
+	P_TEST_CHECK (head.length == 2);
+
+	P_TEST_CHECK (p_mem_set_vtable (&vtable) == TRUE);
+
+	/* Full block, no released nodes */
+	P_TEST_CHECK (p_list_head_append (&head, PINT_TO_POINTER (3)) == FALSE);
+	P_TEST_CHECK (head.length == 2);
+
+	p_list_head_clear (&head);
+
+	/* Released nodes are reused without allocations */
+	P_TEST_CHECK (p_list_head_append_bulk (&head, bulk, 2) == TRUE);
+	P_TEST_CHECK (head.length == 2);
 
 	p_mem_restore_vtable ();
 
+	p_list_pool_free (pool);
+
 	p_libsys_shutdown ();
 }
 P_TEST_CASE_END ()
@@ -97,8 +138,15 @@ P_TEST_CASE_BEGIN (plist_invalid_test)
 	P_TEST_CHECK (p_list_length (NULL) == 0);
 	P_TEST_CHECK (p_list_reverse (NULL) == NULL);
 
+	P_TEST_CHECK (p_list_head_append (NULL, NULL) == FALSE);
+	P_TEST_CHECK (p_list_head_append_bulk (NULL, NULL, 0) == FALSE);
+	P_TEST_CHECK (p_list_head_prepend (NULL, NULL) == FALSE);
+
 	p_list_free (NULL);
 	p_list_foreach (NULL, NULL, NULL);
+	p_list_head_init (NULL, NULL);
+	p_list_head_clear (NULL);
+	p_list_pool_free (NULL);
 
 	p_libsys_shutdown ();
 }
@@ -191,10 +239,95 @@ P_TEST_CASE_BEGIN (plist_general_test)
 }
 P_TEST_CASE_END ()
 
+P_TEST_CASE_BEGIN (plist_head_test)
+{
+	PListHead	head;
+	PListPool	*pool;
+	PList		*item;
+	ppointer	bulk[1000];
+	pint		i;
+
+	p_libsys_init ();
+
+	for (i = 0; i < 1000; ++i)
+		bulk[i] = PINT_TO_POINTER (i + 1);
+
+	/* Heap nodes make an ordinary list */
+	p_list_head_init (&head, NULL);
+
+	P_TEST_CHECK (p_list_head_append_bulk (&head, bulk, 0) == TRUE);
+	P_TEST_CHECK (head.first == NULL && head.last == NULL && head.length == 0);
+
+	P_TEST_CHECK (p_list_head_append (&head, PINT_TO_POINTER (2)) == TRUE);
+	P_TEST_CHECK (p_list_head_prepend (&head, PINT_TO_POINTER (1)) == TRUE);
+	P_TEST_CHECK (p_list_head_append (&head, PINT_TO_POINTER (3)) == TRUE);
+
+	P_TEST_CHECK (head.length == 3);
+	P_TEST_CHECK (p_list_length (head.first) == 3);
+	P_TEST_CHECK (P_POINTER_TO_INT (head.first->data) == 1);
+	P_TEST_CHECK (P_POINTER_TO_INT (head.first->next->data) == 2);
+	P_TEST_CHECK (P_POINTER_TO_INT (head.last->data) == 3);
+	P_TEST_CHECK (p_list_last (head.first) == head.last);
+
+	P_TEST_CHECK (p_list_head_append_bulk (&head, bulk, 1000) == TRUE);
+	P_TEST_CHECK (head.length == 1003);
+	P_TEST_CHECK (p_list_length (head.first) == 1003);
+	P_TEST_CHECK (P_POINTER_TO_INT (head.last->data) == 1000);
+	P_TEST_CHECK (p_list_last (head.first) == head.last);
+
+	p_list_free (head.first);
+
+	/* Prepending into an empty list sets the last node too */
+	p_list_head_init (&head, NULL);
+
+	P_TEST_CHECK (p_list_head_prepend (&head, PINT_TO_POINTER (5)) == TRUE);
+	P_TEST_CHECK (head.first == head.last);
+	P_TEST_CHECK (p_list_head_append (&head, PINT_TO_POINTER (6)) == TRUE);
+	P_TEST_CHECK (P_POINTER_TO_INT (head.last->data) == 6);
+
+	p_list_head_clear (&head);
+	P_TEST_CHECK (head.first == NULL && head.last == NULL && head.length == 0);
+
+	/* Pooled nodes spanning several blocks */
+	pool = p_list_pool_new (64);
+	P_TEST_REQUIRE (pool != NULL);
+
+	p_list_head_init (&head, pool);
+
+	for (i = 0; i < 500; ++i)
+		P_TEST_CHECK (p_list_head_append (&head, bulk[i]) == TRUE);
+
+	P_TEST_CHECK (p_list_head_append_bulk (&head, bulk + 500, 500) == TRUE);
+	P_TEST_CHECK (head.length == 1000);
+
+	for (item = head.first, i = 0; item != NULL; item = item->next, ++i)
+		P_TEST_CHECK (P_POINTER_TO_INT (item->data) == i + 1);
+
+	P_TEST_CHECK (i == 1000);
+
+	/* Nodes are recycled: the same nodes come back after a clear */
+	item = head.first;
+
+	p_list_head_clear (&head);
+	P_TEST_CHECK (head.length == 0);
+
+	P_TEST_CHECK (p_list_head_append (&head, PINT_TO_POINTER (7)) == TRUE);
+	P_TEST_CHECK (head.first == item);
+	P_TEST_CHECK (head.first->next == NULL);
+	P_TEST_CHECK (P_POINTER_TO_INT (head.first->data) == 7);
+
+	/* Nodes still in a list go away with the pool */
+	p_list_pool_free (pool);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
 P_TEST_SUITE_BEGIN()
 {
 	P_TEST_SUITE_RUN_CASE (plist_nomem_test);
 	P_TEST_SUITE_RUN_CASE (plist_invalid_test);
 	P_TEST_SUITE_RUN_CASE (plist_general_test);
+	P_TEST_SUITE_RUN_CASE (plist_head_test);
 }
 P_TEST_SUITE_END()
@@ -163,9 +163,68 @@ P_TEST_CASE_BEGIN (pmem_general_test)
 }
 P_TEST_CASE_END ()
 
+P_TEST_CASE_BEGIN (pmem_mmap_flags_test)
+{
+	PError		*error = NULL;
+	ppointer	ptr;
+	psize		huge_size;
+	psize		n_bytes;
+	psize		i;
+
+	p_libsys_init ();
+
+	P_TEST_CHECK (p_mem_mmap_full (0, P_MEM_MAP_PREFAULT, NULL) == NULL);
+
+	/* Huge pages are a hint, a block of any size must be mapped */
+	huge_size = p_mem_huge_page_size ();
+	n_bytes   = huge_size > 0 ? 2 * huge_size : 4 * 1024 * 1024;
+
+	ptr = p_mem_mmap_full (n_bytes,
+			       P_MEM_MAP_HUGE_PAGES | P_MEM_MAP_PREFAULT | P_MEM_MAP_NUMA_LOCAL,
+			       NULL);
+	P_TEST_REQUIRE (ptr != NULL);
+
+	for (i = 0; i < n_bytes; i += 4096)
+		P_TEST_CHECK (*(((pchar *) ptr) + i) == 0);
+
+	for (i = 0; i < n_bytes; i += 1024)
+		*(((pchar *) ptr) + i) = (pchar) (i % 127);
+
+	for (i = 0; i < n_bytes; i += 1024)
+		P_TEST_CHECK (*(((pchar *) ptr) + i) == (pchar) (i % 127));
+
+	P_TEST_CHECK (p_mem_munmap (ptr, n_bytes, NULL) == TRUE);
+
+	ptr = p_mem_mmap_full (1000, P_MEM_MAP_HUGE_PAGES, NULL);
+	P_TEST_REQUIRE (ptr != NULL);
+	P_TEST_CHECK (p_mem_munmap (ptr, 1000, NULL) == TRUE);
+
+	/* Locking may be forbidden by the limits, but then it must be reported */
+	ptr = p_mem_mmap_full (64 * 1024, P_MEM_MAP_LOCKED, &error);
+
+	if (ptr != NULL) {
+		P_TEST_CHECK (error == NULL);
+
+		for (i = 0; i < 64 * 1024; ++i)
+			*(((pchar *) ptr) + i) = (pchar) (i % 127);
+
+		for (i = 0; i < 64 * 1024; ++i)
+			P_TEST_CHECK (*(((pchar *) ptr) + i) == (pchar) (i % 127));
+
+		P_TEST_CHECK (p_mem_munmap (ptr, 64 * 1024, NULL) == TRUE);
+	} else {
+		P_TEST_CHECK (error != NULL);
+		p_error_free (error);
+	}
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
 P_TEST_SUITE_BEGIN()
 {
 	P_TEST_SUITE_RUN_CASE (pmem_bad_input_test);
 	P_TEST_SUITE_RUN_CASE (pmem_general_test);
+	P_TEST_SUITE_RUN_CASE (pmem_mmap_flags_test);
 }
 P_TEST_SUITE_END()
@@ -28,8 +28,12 @@
 
 P_TEST_MODULE_INIT ();
 
+#define PMUTEX_BENCH_THREADS	4
+#define PMUTEX_BENCH_ITERATIONS	50000
+
 static pint mutex_test_val  = 0;
 static PMutex *global_mutex = NULL;
+static volatile pint64 mutex_bench_counter = 0;
 
 extern "C" ppointer pmem_alloc (psize nbytes)
 {
@@ -75,6 +79,60 @@ static void * mutex_test_thread (void *)
 	return NULL;
 }
 
+static void * mutex_bench_thread (void *)
+{
+	pint i;
+
+	for (i = 0; i < PMUTEX_BENCH_ITERATIONS; ++i) {
+		if (!p_mutex_lock (global_mutex))
+			p_uthread_exit (1);
+
+		/* A critical section as short as a queue push */
+		++mutex_bench_counter;
+
+		if (!p_mutex_unlock (global_mutex))
+			p_uthread_exit (1);
+	}
+
+	p_uthread_exit (0);
+
+	return NULL;
+}
+
+static puint64 mutex_bench_run (PMutex *mutex)
+{
+	PUThread	*thr[PMUTEX_BENCH_THREADS];
+	PTimeProfiler	*profiler;
+	puint64		usecs;
+	pint		i;
+
+	global_mutex        = mutex;
+	mutex_bench_counter = 0;
+
+	profiler = p_time_profiler_new ();
+
+	if (profiler == NULL)
+		return 0;
+
+	for (i = 0; i < PMUTEX_BENCH_THREADS; ++i)
+		thr[i] = p_uthread_create ((PUThreadFunc) mutex_bench_thread, NULL, true);
+
+	for (i = 0; i < PMUTEX_BENCH_THREADS; ++i) {
+		if (thr[i] == NULL)
+			continue;
+
+		if (p_uthread_join (thr[i]) != 0)
+			mutex_bench_counter = -1;
+
+		p_uthread_unref (thr[i]);
+	}
+
+	usecs = p_time_profiler_elapsed_usecs (profiler);
+	p_time_profiler_free (profiler);
+
+	return usecs;
+}
+
 P_TEST_CASE_BEGIN (pmutex_nomem_test)
 {
 	p_libsys_init ();
@@ -87,6 +145,7 @@ P_TEST_CASE_BEGIN (pmutex_nomem_test)
 
 	P_TEST_CHECK (p_mem_set_vtable (&vtable) == TRUE);
 	P_TEST_CHECK (p_mutex_new () == NULL);
+	P_TEST_CHECK (p_mutex_new_adaptive () == NULL);
 
 	p_mem_restore_vtable ();
 
@@ -137,10 +196,80 @@ P_TEST_CASE_BEGIN (pmutex_general_test)
 }
 P_TEST_CASE_END ()
 
+P_TEST_CASE_BEGIN (pmutex_adaptive_test)
+{
+	PUThread *thr1, *thr2;
+
+	p_libsys_init ();
+
+	global_mutex = p_mutex_new_adaptive ();
+	P_TEST_REQUIRE (global_mutex != NULL);
+
+	P_TEST_CHECK (p_mutex_trylock (global_mutex) == TRUE);
+	P_TEST_CHECK (p_mutex_trylock (global_mutex) == FALSE);
+	P_TEST_CHECK (p_mutex_unlock (global_mutex) == TRUE);
+
+	mutex_test_val = 10;
+
+	thr1 = p_uthread_create ((PUThreadFunc) mutex_test_thread, NULL, true);
+	P_TEST_REQUIRE (thr1 != NULL);
+
+	thr2 = p_uthread_create ((PUThreadFunc) mutex_test_thread, NULL, true);
+	P_TEST_REQUIRE (thr2 != NULL);
+
+	P_TEST_CHECK (p_uthread_join (thr1) == 0);
+	P_TEST_CHECK (p_uthread_join (thr2) == 0);
+
+	P_TEST_REQUIRE (mutex_test_val == 10);
+
+	p_uthread_unref (thr1);
+	p_uthread_unref (thr2);
+	p_mutex_free (global_mutex);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
+P_TEST_CASE_BEGIN (pmutex_contention_bench_test)
+{
+	PMutex	*mutex;
+	puint64	regular_usecs;
+	puint64	adaptive_usecs;
+
+	p_libsys_init ();
+
+	mutex = p_mutex_new ();
+	P_TEST_REQUIRE (mutex != NULL);
+
+	regular_usecs = mutex_bench_run (mutex);
+	P_TEST_CHECK (mutex_bench_counter == PMUTEX_BENCH_THREADS * PMUTEX_BENCH_ITERATIONS);
+
+	p_mutex_free (mutex);
+
+	mutex = p_mutex_new_adaptive ();
+	P_TEST_REQUIRE (mutex != NULL);
+
+	adaptive_usecs = mutex_bench_run (mutex);
+	P_TEST_CHECK (mutex_bench_counter == PMUTEX_BENCH_THREADS * PMUTEX_BENCH_ITERATIONS);
+
+	p_mutex_free (mutex);
+
+	printf ("PMutex contention, %d threads x %d locks: regular %llu us, adaptive %llu us\n",
+		PMUTEX_BENCH_THREADS,
+		PMUTEX_BENCH_ITERATIONS,
+		(unsigned long long) regular_usecs,
+		(unsigned long long) adaptive_usecs);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
 P_TEST_SUITE_BEGIN()
 {
 	P_TEST_SUITE_RUN_CASE (pmutex_nomem_test);
 	P_TEST_SUITE_RUN_CASE (pmutex_bad_input_test);
 	P_TEST_SUITE_RUN_CASE (pmutex_general_test);
+	P_TEST_SUITE_RUN_CASE (pmutex_adaptive_test);
+	P_TEST_SUITE_RUN_CASE (pmutex_contention_bench_test);
 }
 P_TEST_SUITE_END()
@@ -159,6 +159,38 @@ P_TEST_CASE_BEGIN (prwlock_bad_input_test)
 }
 P_TEST_CASE_END ()
 
+P_TEST_CASE_BEGIN (prwlock_trylock_test)
+{
+	p_libsys_init ();
+
+	test_rwlock = p_rwlock_new ();
+	P_TEST_REQUIRE (test_rwlock != NULL);
+
+	/* Readers share the lock and keep writers out */
+	P_TEST_CHECK (p_rwlock_reader_trylock (test_rwlock) == TRUE);
+	P_TEST_CHECK (p_rwlock_reader_trylock (test_rwlock) == TRUE);
+	P_TEST_CHECK (p_rwlock_writer_trylock (test_rwlock) == FALSE);
+	P_TEST_CHECK (p_rwlock_reader_unlock (test_rwlock) == TRUE);
+	P_TEST_CHECK (p_rwlock_writer_trylock (test_rwlock) == FALSE);
+	P_TEST_CHECK (p_rwlock_reader_unlock (test_rwlock) == TRUE);
+
+	/* A writer keeps everyone else out */
+	P_TEST_CHECK (p_rwlock_writer_trylock (test_rwlock) == TRUE);
+	P_TEST_CHECK (p_rwlock_reader_trylock (test_rwlock) == FALSE);
+	P_TEST_CHECK (p_rwlock_writer_trylock (test_rwlock) == FALSE);
+	P_TEST_CHECK (p_rwlock_writer_unlock (test_rwlock) == TRUE);
+
+	P_TEST_CHECK (p_rwlock_reader_lock (test_rwlock) == TRUE);
+	P_TEST_CHECK (p_rwlock_reader_unlock (test_rwlock) == TRUE);
+	P_TEST_CHECK (p_rwlock_writer_lock (test_rwlock) == TRUE);
+	P_TEST_CHECK (p_rwlock_writer_unlock (test_rwlock) == TRUE);
+
+	p_rwlock_free (test_rwlock);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
 P_TEST_CASE_BEGIN (prwlock_general_test)
 {
 	p_libsys_init ();
@@ -215,6 +247,7 @@ P_TEST_SUITE_BEGIN()
 {
 	P_TEST_SUITE_RUN_CASE (prwlock_nomem_test);
 	P_TEST_SUITE_RUN_CASE (prwlock_bad_input_test);
+	P_TEST_SUITE_RUN_CASE (prwlock_trylock_test);
 	P_TEST_SUITE_RUN_CASE (prwlock_general_test);
 }
 P_TEST_SUITE_END()
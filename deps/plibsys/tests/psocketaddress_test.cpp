@@ -200,6 +200,12 @@ P_TEST_CASE_BEGIN (psocketaddress_general_test)
 	P_TEST_CHECK (p_socket_address_get_flow_info (addr) == 0);
 	P_TEST_CHECK (p_socket_address_get_scope_id (addr) == 0);
 
+	addr_str = p_socket_address_get_address (addr);
+
+	P_TEST_REQUIRE (addr_str != NULL);
+	P_TEST_CHECK (strcmp (addr_str, "127.0.0.1") == 0);
+
+	p_free (addr_str);
 	p_socket_address_free (addr);
 
 	if (p_socket_address_is_ipv6_supported ()) {
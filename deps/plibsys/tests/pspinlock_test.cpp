@@ -89,6 +89,7 @@ P_TEST_CASE_BEGIN (pspinlock_nomem_test)
 
 	P_TEST_CHECK (p_mem_set_vtable (&vtable) == TRUE);
 	P_TEST_CHECK (p_spinlock_new () == NULL);
+	P_TEST_CHECK (p_spinlock_new_fair () == NULL);
 
 	p_mem_restore_vtable ();
 
@@ -139,10 +140,56 @@ P_TEST_CASE_BEGIN (pspinlock_general_test)
 }
 P_TEST_CASE_END ()
 
+P_TEST_CASE_BEGIN (pspinlock_fair_test)
+{
+	PUThread *thr1, *thr2, *thr3;
+
+	p_libsys_init ();
+
+	spinlock_test_val = PSPINLOCK_MAX_VAL;
+	global_spinlock   = p_spinlock_new_fair ();
+
+	P_TEST_REQUIRE (global_spinlock != NULL);
+
+	P_TEST_CHECK (p_spinlock_trylock (global_spinlock) == TRUE);
+	P_TEST_CHECK (p_spinlock_trylock (global_spinlock) == FALSE);
+	P_TEST_CHECK (p_spinlock_unlock (global_spinlock) == TRUE);
+	P_TEST_CHECK (p_spinlock_lock (global_spinlock) == TRUE);
+	P_TEST_CHECK (p_spinlock_trylock (global_spinlock) == FALSE);
+	P_TEST_CHECK (p_spinlock_unlock (global_spinlock) == TRUE);
+
+	thr1 = p_uthread_create ((PUThreadFunc) spinlock_test_thread, NULL, true);
+	P_TEST_REQUIRE (thr1 != NULL);
+
+	thr2 = p_uthread_create ((PUThreadFunc) spinlock_test_thread, NULL, true);
+	P_TEST_REQUIRE (thr2 != NULL);
+
+	thr3 = p_uthread_create ((PUThreadFunc) spinlock_test_thread, NULL, true);
+	P_TEST_REQUIRE (thr3 != NULL);
+
+	P_TEST_CHECK (p_uthread_join (thr1) == 0);
+	P_TEST_CHECK (p_uthread_join (thr2) == 0);
+	P_TEST_CHECK (p_uthread_join (thr3) == 0);
+
+	P_TEST_REQUIRE (spinlock_test_val == PSPINLOCK_MAX_VAL);
+
+	P_TEST_CHECK (p_spinlock_trylock (global_spinlock) == TRUE);
+	P_TEST_CHECK (p_spinlock_unlock (global_spinlock) == TRUE);
+
+	p_uthread_unref (thr1);
+	p_uthread_unref (thr2);
+	p_uthread_unref (thr3);
+	p_spinlock_free (global_spinlock);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
 P_TEST_SUITE_BEGIN()
 {
 	P_TEST_SUITE_RUN_CASE (pspinlock_nomem_test);
 	P_TEST_SUITE_RUN_CASE (pspinlock_bad_input_test);
 	P_TEST_SUITE_RUN_CASE (pspinlock_general_test);
+	P_TEST_SUITE_RUN_CASE (pspinlock_fair_test);
 }
 P_TEST_SUITE_END()
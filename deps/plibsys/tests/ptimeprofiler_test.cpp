@@ -71,8 +71,11 @@ P_TEST_CASE_BEGIN (ptimeprofiler_bad_input_test)
 	p_libsys_init ();
 
 	P_TEST_CHECK (p_time_profiler_elapsed_usecs (NULL) == 0);
+	P_TEST_CHECK (p_time_profiler_cycles_lap (NULL) == 0);
+	P_TEST_CHECK (p_time_profiler_cycles_split (NULL) == 0);
 	p_time_profiler_reset (NULL);
 	p_time_profiler_free (NULL);
+	p_time_profiler_cycles_start (NULL);
 
 	p_libsys_shutdown ();
 }
@@ -117,10 +120,68 @@ P_TEST_CASE_BEGIN (ptimeprofiler_general_test)
 }
 P_TEST_CASE_END ()
 
+P_TEST_CASE_BEGIN (ptimeprofiler_cycles_test)
+{
+	PTimeProfilerCycles	profiler;
+	PTimeProfiler		*clock;
+	puint64			lap1, lap2, split;
+	puint64			nsecs, usecs;
+	puint64			prev_val, val;
+
+	p_libsys_init ();
+
+	P_TEST_CHECK (p_time_profiler_cycles_frequency () > 0);
+	P_TEST_CHECK (p_time_profiler_cycles_to_nsecs (0) == 0);
+	P_TEST_CHECK (p_time_profiler_cycles_to_nsecs (p_time_profiler_cycles_frequency ()) == 1000000000ULL);
+
+	prev_val = p_time_profiler_cycles_now ();
+	val      = p_time_profiler_cycles_now ();
+	P_TEST_CHECK (val >= prev_val);
+
+	clock = p_time_profiler_new ();
+	P_TEST_REQUIRE (clock != NULL);
+
+	p_time_profiler_cycles_start (&profiler);
+
+	p_uthread_sleep (50);
+	lap1 = p_time_profiler_cycles_lap (&profiler);
+
+	p_uthread_sleep (100);
+	lap2  = p_time_profiler_cycles_lap (&profiler);
+	split = p_time_profiler_cycles_split (&profiler);
+
+	usecs = p_time_profiler_elapsed_usecs (clock);
+	nsecs = p_time_profiler_cycles_to_nsecs (split);
+
+	P_TEST_CHECK (lap1 > 0);
+	P_TEST_CHECK (lap2 > lap1);
+	P_TEST_CHECK (split >= lap1 + lap2);
+
+	/* Both clocks must agree within the scheduling noise */
+	P_TEST_CHECK (nsecs >= 150 * 1000000ULL);
+	P_TEST_CHECK (nsecs / 1000 <= usecs + 5000);
+	P_TEST_CHECK (nsecs / 1000 + 5000 >= usecs);
+
+	p_time_profiler_free (clock);
+
+	/* Cheap enough to time single queue operations */
+	p_time_profiler_cycles_start (&profiler);
+
+	for (pint i = 0; i < 100000; ++i)
+		p_time_profiler_cycles_lap (&profiler);
+
+	nsecs = p_time_profiler_cycles_to_nsecs (p_time_profiler_cycles_split (&profiler));
+	P_TEST_CHECK (nsecs / 100000 < 1000);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
 P_TEST_SUITE_BEGIN()
 {
 	P_TEST_SUITE_RUN_CASE (ptimeprofiler_nomem_test);
 	P_TEST_SUITE_RUN_CASE (ptimeprofiler_bad_input_test);
 	P_TEST_SUITE_RUN_CASE (ptimeprofiler_general_test);
+	P_TEST_SUITE_RUN_CASE (ptimeprofiler_cycles_test);
 }
 P_TEST_SUITE_END()
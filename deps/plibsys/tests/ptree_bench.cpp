@@ -0,0 +1,150 @@
+/*
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * 'Software'), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED 'AS IS', WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * Compares the node arena of PTree with per-node heap allocation: fills a
+ * tree with random keys and clears it a few times, then frees it. Not run as
+ * a test, build it in release mode and run it by hand.
+ */
+
+#include "plibsys.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define PTREE_BENCH_NODES	1000000
+#define PTREE_BENCH_ROUNDS	5
+
+static pint
+tree_bench_compare (pconstpointer a, pconstpointer b)
+{
+	psize	ka = (psize) a;
+	psize	kb = (psize) b;
+
+	return ka < kb ? -1 : (ka > kb ? 1 : 0);
+}
+
+static void
+tree_bench_fill (PTree *tree, const psize *keys)
+{
+	pint i;
+
+	for (i = 0; i < PTREE_BENCH_NODES; ++i)
+		p_tree_insert (tree, (ppointer) keys[i], (ppointer) keys[i]);
+}
+
+static void
+tree_bench_run (PTreeType type, const pchar *name, pboolean use_arena, const psize *keys)
+{
+	PTimeProfiler	*profiler;
+	PTree		*tree;
+	puint64		insert_us = 0;
+	puint64		clear_us  = 0;
+	puint64		free_us;
+	pint		i;
+
+	profiler = p_time_profiler_new ();
+	tree     = p_tree_new (type, tree_bench_compare);
+
+	if (use_arena == TRUE && p_tree_enable_arena (tree, 0) == FALSE) {
+		printf ("%s: failed to enable the arena\n", name);
+		p_tree_free (tree);
+		p_time_profiler_free (profiler);
+		return;
+	}
+
+	for (i = 0; i < PTREE_BENCH_ROUNDS; ++i) {
+		p_time_profiler_reset (profiler);
+		tree_bench_fill (tree, keys);
+		insert_us += p_time_profiler_elapsed_usecs (profiler);
+
+		if (p_tree_get_nnodes (tree) != PTREE_BENCH_NODES)
+			printf ("%s: %d nodes instead of %d\n", name, p_tree_get_nnodes (tree), PTREE_BENCH_NODES);
+
+		/* The last round is left for p_tree_free() */
+		if (i == PTREE_BENCH_ROUNDS - 1)
+			break;
+
+		p_time_profiler_reset (profiler);
+		p_tree_clear (tree);
+		clear_us += p_time_profiler_elapsed_usecs (profiler);
+	}
+
+	p_time_profiler_reset (profiler);
+	p_tree_free (tree);
+	free_us = p_time_profiler_elapsed_usecs (profiler);
+
+	printf ("%-10s %-5s insert %.2f s, clear %.1f ms, free %.1f ms\n",
+		name,
+		use_arena == TRUE ? "arena" : "heap",
+		insert_us / 1e6 / PTREE_BENCH_ROUNDS,
+		clear_us / 1e3 / (PTREE_BENCH_ROUNDS - 1),
+		free_us / 1e3);
+
+	p_time_profiler_free (profiler);
+}
+
+int
+main (void)
+{
+	psize	*keys;
+	pint	i;
+
+	p_libsys_init ();
+
+	keys = (psize *) malloc (sizeof (psize) * PTREE_BENCH_NODES);
+
+	if (keys == NULL) {
+		p_libsys_shutdown ();
+		return 1;
+	}
+
+	srand (1);
+
+	/* Distinct keys in random order */
+	for (i = 0; i < PTREE_BENCH_NODES; ++i)
+		keys[i] = (psize) i + 1;
+
+	for (i = PTREE_BENCH_NODES - 1; i > 0; --i) {
+		pint	j   = rand () % (i + 1);
+		psize	tmp = keys[i];
+
+		keys[i] = keys[j];
+		keys[j] = tmp;
+	}
+
+	printf ("%d random keys, %d fill/clear rounds, times per round\n",
+		PTREE_BENCH_NODES,
+		PTREE_BENCH_ROUNDS);
+
+	tree_bench_run (P_TREE_TYPE_RB, "RB", FALSE, keys);
+	tree_bench_run (P_TREE_TYPE_RB, "RB", TRUE, keys);
+	tree_bench_run (P_TREE_TYPE_AVL, "AVL", FALSE, keys);
+	tree_bench_run (P_TREE_TYPE_AVL, "AVL", TRUE, keys);
+
+	free (keys);
+
+	p_libsys_shutdown ();
+
+	return 0;
+}
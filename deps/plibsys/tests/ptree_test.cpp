@@ -496,6 +496,16 @@ P_TEST_CASE_BEGIN (ptree_nomem_test)
 		P_TEST_CHECK (p_mem_set_vtable (&vtable) == TRUE);
 
 		P_TEST_CHECK (p_tree_new ((PTreeType) i, (PCompareFunc) compare_keys) == NULL);
+		p_tree_insert (tree, PINT_TO_POINTER (1), PINT_TO_POINTER (10));
+		P_TEST_CHECK (p_tree_get_nnodes (tree) == 0);
+		P_TEST_CHECK (p_tree_enable_arena (tree, 0) == FALSE);
+
+		p_mem_restore_vtable ();
+
+		P_TEST_CHECK (p_tree_enable_arena (tree, 0) == TRUE);
+
+		P_TEST_CHECK (p_mem_set_vtable (&vtable) == TRUE);
+
 		p_tree_insert (tree, PINT_TO_POINTER (1), PINT_TO_POINTER (10));
 		P_TEST_CHECK (p_tree_get_nnodes (tree) == 0);
 
@@ -543,6 +553,8 @@ P_TEST_CASE_BEGIN (ptree_invalid_test)
 		P_TEST_CHECK (p_tree_get_type (NULL) == (PTreeType) -1);
 		P_TEST_CHECK (p_tree_get_nnodes (NULL) == 0);
 
+		P_TEST_CHECK (p_tree_enable_arena (NULL, 0) == FALSE);
+
 		p_tree_insert (NULL, NULL, NULL);
 		p_tree_foreach (NULL, NULL, NULL);
 		p_tree_clear (NULL);
@@ -623,11 +635,78 @@ P_TEST_CASE_BEGIN (ptree_stress_test)
 }
 P_TEST_CASE_END ()
 
+P_TEST_CASE_BEGIN (ptree_arena_test)
+{
+	PTree *tree;
+
+	p_libsys_init ();
+
+	for (int i = (int) P_TREE_TYPE_BINARY; i <= (int) P_TREE_TYPE_AVL; ++i) {
+		/* Without destroy functions clearing releases the arena at once */
+		tree = p_tree_new_with_data ((PTreeType) i,
+					     (PCompareDataFunc) compare_keys_data,
+					     &tree_data);
+
+		P_TEST_CHECK (p_tree_enable_arena (tree, 4) == TRUE);
+		P_TEST_CHECK (p_tree_enable_arena (tree, 4) == FALSE);
+
+		P_TEST_CHECK (general_tree_test (tree, (PTreeType) i, true, false) == true);
+		P_TEST_CHECK (stress_tree_test (tree, PTREE_STRESS_NODES) == true);
+
+		p_tree_insert (tree, PINT_TO_POINTER (1), PINT_TO_POINTER (10));
+		P_TEST_CHECK (p_tree_get_nnodes (tree) == 1);
+		P_TEST_CHECK (p_tree_lookup (tree, PINT_TO_POINTER (1)) == PINT_TO_POINTER (10));
+
+		memset (&tree_data, 0, sizeof (tree_data));
+		p_tree_free (tree);
+
+		P_TEST_CHECK (check_tree_data_is_zero () == true);
+
+		/* A non-empty tree can't switch to an arena */
+		tree = p_tree_new ((PTreeType) i, (PCompareFunc) compare_keys);
+
+		p_tree_insert (tree, PINT_TO_POINTER (1), PINT_TO_POINTER (10));
+		P_TEST_CHECK (p_tree_enable_arena (tree, 0) == FALSE);
+
+		p_tree_clear (tree);
+		P_TEST_CHECK (p_tree_enable_arena (tree, 0) == TRUE);
+
+		p_tree_free (tree);
+
+		/* Destroy functions are still called for every node */
+		tree = p_tree_new_full ((PTreeType) i,
+					(PCompareDataFunc) compare_keys_data,
+					&tree_data,
+					(PDestroyFunc) key_destroy_notify,
+					(PDestroyFunc) value_destroy_notify);
+
+		P_TEST_CHECK (p_tree_enable_arena (tree, 0) == TRUE);
+
+		for (int j = 0; j < PTREE_STRESS_ITERATIONS; ++j)
+			P_TEST_CHECK (stress_tree_test (tree, PTREE_STRESS_NODES) == true);
+
+		P_TEST_CHECK (general_tree_test (tree, (PTreeType) i, true, true) == true);
+
+		for (int j = 1; j <= 3; ++j)
+			p_tree_insert (tree, PINT_TO_POINTER (j), PINT_TO_POINTER (j * 10));
+
+		memset (&tree_data, 0, sizeof (tree_data));
+		p_tree_free (tree);
+
+		P_TEST_CHECK (tree_data.key_sum   == 6);
+		P_TEST_CHECK (tree_data.value_sum == 60);
+	}
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
 P_TEST_SUITE_BEGIN()
 {
 	P_TEST_SUITE_RUN_CASE (ptree_nomem_test);
 	P_TEST_SUITE_RUN_CASE (ptree_invalid_test);
 	P_TEST_SUITE_RUN_CASE (ptree_general_test);
 	P_TEST_SUITE_RUN_CASE (ptree_stress_test);
+	P_TEST_SUITE_RUN_CASE (ptree_arena_test);
 }
 P_TEST_SUITE_END()
@@ -165,6 +165,20 @@ static void * test_thread_tls_func (void *data)
 	return NULL;
 }
 
+static void * test_thread_affinity_func (void *data)
+{
+	P_UNUSED (data);
+
+	thread1_obj = p_uthread_current ();
+
+	while (is_threads_working == TRUE)
+		p_uthread_sleep (10);
+
+	p_uthread_exit (10);
+
+	return NULL;
+}
+
 static void * test_thread_tls_create_func (void *data)
 {
 	P_UNUSED (data);
@@ -208,6 +222,16 @@ P_TEST_CASE_BEGIN (puthread_nomem_test)
 					    P_UTHREAD_PRIORITY_NORMAL,
 					    0) == NULL);
 
+	pint cpus[1] = { 0 };
+
+	P_TEST_CHECK (p_uthread_create_affine ((PUThreadFunc) test_thread_func,
+					      (ppointer) &thread_wakes_2,
+					      TRUE,
+					      P_UTHREAD_PRIORITY_NORMAL,
+					      0,
+					      cpus,
+					      1) == NULL);
+
 	P_TEST_CHECK (p_uthread_current () == NULL);
 	P_TEST_CHECK (p_uthread_local_new (NULL) == NULL);
 
@@ -247,6 +271,16 @@ P_TEST_CASE_BEGIN (puthread_bad_input_test)
 	P_TEST_CHECK (p_uthread_create_full (NULL, NULL, false, P_UTHREAD_PRIORITY_NORMAL, 0) == NULL);
 	P_TEST_CHECK (p_uthread_join (NULL) == -1);
 	P_TEST_CHECK (p_uthread_set_priority (NULL, P_UTHREAD_PRIORITY_NORMAL) == FALSE);
+	P_TEST_CHECK (p_uthread_create_affine (NULL, NULL, false, P_UTHREAD_PRIORITY_NORMAL, 0, NULL, 0) == NULL);
+	P_TEST_CHECK (p_uthread_create_affine ((PUThreadFunc) test_thread_func,
+					      NULL,
+					      false,
+					      P_UTHREAD_PRIORITY_NORMAL,
+					      0,
+					      NULL,
+					      1) == NULL);
+	P_TEST_CHECK (p_uthread_set_affinity (NULL, NULL, 0) == FALSE);
+	P_TEST_CHECK (p_uthread_numa_node_cpus (-1, NULL, 0) == -1);
 	P_TEST_CHECK (p_uthread_get_local (NULL) == NULL);
 	p_uthread_set_local (NULL, NULL);
 	p_uthread_replace_local (NULL, NULL);
@@ -325,6 +359,61 @@ P_TEST_CASE_BEGIN (puthread_general_test)
 }
 P_TEST_CASE_END ()
 
+P_TEST_CASE_BEGIN (puthread_affinity_test)
+{
+	p_libsys_init ();
+
+	pint cpus[64];
+	pint cpus_count = p_uthread_numa_node_cpus (0, cpus, 64);
+
+#if defined (P_OS_LINUX) || defined (P_OS_WIN)
+	P_TEST_CHECK (cpus_count > 0);
+#endif
+
+	if (cpus_count <= 0) {
+		cpus[0]    = 0;
+		cpus_count = 1;
+	}
+
+	P_TEST_CHECK (p_uthread_numa_node_cpus (0, cpus, 0) == -1);
+	P_TEST_CHECK (p_uthread_numa_node_cpus (4096, cpus, 64) == -1);
+
+	thread1_obj        = NULL;
+	is_threads_working = TRUE;
+
+	PUThread *thr = p_uthread_create_affine ((PUThreadFunc) test_thread_affinity_func,
+						 NULL,
+						 TRUE,
+						 P_UTHREAD_PRIORITY_INHERIT,
+						 0,
+						 cpus,
+						 cpus_count);
+
+	P_TEST_REQUIRE (thr != NULL);
+
+	pint bad_cpus[1] = { -1 };
+
+	P_TEST_CHECK (p_uthread_set_affinity (thr, bad_cpus, 1) == FALSE);
+	P_TEST_CHECK (p_uthread_set_affinity (thr, cpus, -1) == FALSE);
+
+#if defined (P_OS_LINUX) || defined (P_OS_WIN)
+	P_TEST_CHECK (p_uthread_set_affinity (thr, cpus, 1) == TRUE);
+	P_TEST_CHECK (p_uthread_set_affinity (thr, NULL, 0) == TRUE);
+#endif
+
+	p_uthread_sleep (100);
+
+	is_threads_working = FALSE;
+
+	P_TEST_CHECK (p_uthread_join (thr) == 10);
+	P_TEST_CHECK (thread1_obj == thr);
+
+	p_uthread_unref (thr);
+
+	p_libsys_shutdown ();
+}
+P_TEST_CASE_END ()
+
 P_TEST_CASE_BEGIN (puthread_nonjoinable_test)
 {
 	p_libsys_init ();
@@ -461,6 +550,7 @@ P_TEST_SUITE_BEGIN()
 	P_TEST_SUITE_RUN_CASE (puthread_nomem_test);
 	P_TEST_SUITE_RUN_CASE (puthread_bad_input_test);
 	P_TEST_SUITE_RUN_CASE (puthread_general_test);
+	P_TEST_SUITE_RUN_CASE (puthread_affinity_test);
 	P_TEST_SUITE_RUN_CASE (puthread_nonjoinable_test);
 	P_TEST_SUITE_RUN_CASE (puthread_tls_test);
 }
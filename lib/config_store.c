@@ -0,0 +1,373 @@
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "config_store.h"
+
+/*
+ * Readers load the current snapshot with a single atomic pointer load and never
+ * take a lock. Snapshots are reclaimed with epochs: a reader announces the
+ * global epoch in its slot before loading the pointer and clears it when done.
+ * A replaced snapshot is tagged with the epoch current at the time it was
+ * replaced, and freed once no slot announces an epoch up to that tag, since
+ * any reader which could still hold it must have announced such an epoch.
+ */
+
+struct config_store_node_t
+{
+    struct config_t             cfg; // must be the first field
+    pint                        retired_epoch;
+    struct config_store_node_t* next;
+};
+
+struct config_store_reader_t
+{
+    volatile pint epoch;  // 0 outside of read-side sections
+    volatile pint in_use;
+    pchar         pad[64 - 2 * sizeof(pint)]; // one cache line per reader
+};
+
+struct config_store_t
+{
+    struct config_store_reader_t readers[CONFIG_STORE_MAX_READERS];
+
+    volatile ppointer            current;
+    volatile pint                epoch;
+
+    PMutex*                      mutex;   // serializes publishers
+    struct config_store_node_t*  retired; // replaced snapshots not freed yet
+
+    PUThread*                    watch_th;
+    pchar*                       watch_path;
+    puint32                      watch_period_ms;
+    pboolean                     watch_done;
+};
+
+/**
+ * Free the retired snapshots that no reader can hold anymore.
+ * Called with the mutex locked.
+ */
+static void
+config_store_reclaim(struct config_store_t* const self)
+{
+    pint oldest = 0; // the oldest epoch announced by a reader, 0 if none
+
+    for (psize idx = 0;
+               idx < CONFIG_STORE_MAX_READERS;
+               idx++)
+    {
+        const pint epoch = p_atomic_int_get(&self->readers[idx].epoch);
+
+        if ((0 != epoch) &&
+            ((0 == oldest) || (epoch < oldest)))
+        {
+            oldest = epoch;
+        }
+    }
+
+    struct config_store_node_t** link = &self->retired;
+
+    while (NULL != *link)
+    {
+        struct config_store_node_t* const node = *link;
+
+        if ((0 != oldest) &&
+            (oldest <= node->retired_epoch))
+        {
+            link = &node->next;
+            continue;
+        }
+
+        *link = node->next;
+        p_free(node);
+    }
+}
+
+static ppointer
+config_store_watch_task(ppointer arg)
+{
+    struct config_store_t* self = (struct config_store_t*)arg;
+
+    struct timespec last_mtime = { 0, 0 };
+    struct stat     st;
+
+    if (0 == stat(self->watch_path, &st)) {
+        last_mtime = st.st_mtim;
+    }
+
+    while (!self->watch_done)
+    {
+        p_uthread_sleep(self->watch_period_ms);
+
+        if ((0 != stat(self->watch_path, &st)) ||
+            ((st.st_mtim.tv_sec == last_mtime.tv_sec) &&
+             (st.st_mtim.tv_nsec == last_mtime.tv_nsec)))
+        {
+            continue;
+        }
+
+        last_mtime = st.st_mtim;
+
+        if (config_store_load(self, self->watch_path)) {
+            printf("### configuration reloaded from %s ###\n", self->watch_path);
+        }
+    }
+
+    return NULL;
+}
+
+struct config_store_t*
+config_store_create(const struct config_t* const initial)
+{
+    struct config_store_t* self = NULL;
+
+    do
+    {
+        self = p_malloc0(sizeof(struct config_store_t));
+
+        if (NULL == self)
+        {
+            printf("!!! not enough memory to create a configuration store !!!\n");
+            break;
+        }
+
+        self->epoch = 1;
+        self->mutex = p_mutex_new();
+
+        if (NULL == self->mutex)
+        {
+            printf("!!! not enough memory to create a mutex !!!\n");
+            config_store_destroy(self);
+            self = NULL;
+            break;
+        }
+
+        if (!config_store_publish(self, initial))
+        {
+            config_store_destroy(self);
+            self = NULL;
+            break;
+        }
+
+    } while (0);
+
+    return self;
+}
+
+void
+config_store_destroy(struct config_store_t* const self)
+{
+    if (NULL == self) {
+        return;
+    }
+
+    if (NULL != self->watch_th)
+    {
+        self->watch_done = TRUE;
+        p_uthread_join(self->watch_th);
+        p_uthread_unref(self->watch_th);
+        self->watch_th = NULL;
+    }
+
+    if (NULL != self->watch_path)
+    {
+        p_free(self->watch_path);
+        self->watch_path = NULL;
+    }
+
+    while (NULL != self->retired)
+    {
+        struct config_store_node_t* const node = self->retired;
+        self->retired = node->next;
+        p_free(node);
+    }
+
+    if (NULL != self->current)
+    {
+        p_free(self->current);
+        self->current = NULL;
+    }
+
+    if (NULL != self->mutex)
+    {
+        p_mutex_free(self->mutex);
+        self->mutex = NULL;
+    }
+
+    p_free(self);
+}
+
+pint
+config_store_register_reader(struct config_store_t* const self)
+{
+    for (pint idx = 0;
+              idx < CONFIG_STORE_MAX_READERS;
+              idx++)
+    {
+        if (p_atomic_int_compare_and_exchange(&self->readers[idx].in_use, 0, 1)) {
+            return idx;
+        }
+    }
+
+    printf("!!! no free configuration reader slot !!!\n");
+
+    return -1;
+}
+
+void
+config_store_unregister_reader(      struct config_store_t* const self,
+                               const pint                         reader)
+{
+    p_atomic_int_set(&self->readers[reader].epoch, 0);
+    p_atomic_int_set(&self->readers[reader].in_use, 0);
+}
+
+const struct config_t*
+config_store_read_lock(      struct config_store_t* const self,
+                       const pint                         reader)
+{
+    // both are full barriers: the slot is visible before the pointer is read
+    p_atomic_int_set(&self->readers[reader].epoch,
+                     p_atomic_int_get(&self->epoch));
+
+    return (const struct config_t*) p_atomic_pointer_get(&self->current);
+}
+
+void
+config_store_read_unlock(      struct config_store_t* const self,
+                         const pint                         reader)
+{
+    p_atomic_int_set(&self->readers[reader].epoch, 0);
+}
+
+pboolean
+config_store_publish(      struct config_store_t* const self,
+                     const struct config_t*       const cfg)
+{
+    struct config_store_node_t* const node = p_malloc0(sizeof(struct config_store_node_t));
+
+    if (NULL == node)
+    {
+        printf("!!! not enough memory to publish a configuration !!!\n");
+        return FALSE;
+    }
+
+    node->cfg = *cfg;
+
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the configuration store !!!\n");
+        p_free(node);
+        return FALSE;
+    }
+
+    struct config_store_node_t* const old = (struct config_store_node_t*) self->current;
+
+    node->cfg.version = (NULL == old) ? 1 : old->cfg.version + 1;
+
+    p_atomic_pointer_set(&self->current, node);
+
+    if (NULL != old)
+    {
+        // readers announcing this epoch or an older one may still hold it
+        old->retired_epoch = p_atomic_int_add(&self->epoch, 1);
+        old->next          = self->retired;
+        self->retired      = old;
+    }
+
+    config_store_reclaim(self);
+
+    p_mutex_unlock(self->mutex);
+
+    return TRUE;
+}
+
+pboolean
+config_store_load(      struct config_store_t* const self,
+                  const pchar*                 const path)
+{
+    PIniFile* const ini = p_ini_file_new(path);
+
+    if (NULL == ini) {
+        return FALSE;
+    }
+
+    if (!p_ini_file_parse(ini, NULL))
+    {
+        printf("!!! failed to parse configuration file %s !!!\n", path);
+        p_ini_file_free(ini);
+        return FALSE;
+    }
+
+    // start from the current configuration, read like any other reader does
+    const pint reader = config_store_register_reader(self);
+
+    if (0 > reader)
+    {
+        p_ini_file_free(ini);
+        return FALSE;
+    }
+
+    struct config_t cfg = *config_store_read_lock(self, reader);
+    config_store_read_unlock(self, reader);
+    config_store_unregister_reader(self, reader);
+
+    for (psize sens_id = 0;
+               sens_id < CONFIG_STORE_MAX_SENSORS;
+               sens_id++)
+    {
+        pchar section[16];
+        snprintf(section, sizeof(section), "sensor%lu", sens_id);
+
+        cfg.sens[sens_id].proc_ms = (puint32) p_ini_file_parameter_int(ini,
+                                                                       section,
+                                                                       "proc_ms",
+                                                                       (pint) cfg.sens[sens_id].proc_ms);
+    }
+
+    cfg.fetch_timeout_us = (puint64) p_ini_file_parameter_int(ini,
+                                                              "consumer",
+                                                              "fetch_timeout_ms",
+                                                              (pint) (cfg.fetch_timeout_us / 1000)) * 1000;
+
+    pchar* const coalesce = p_ini_file_parameter_string(ini, "collector", "coalesce", NULL);
+
+    p_ini_file_free(ini);
+
+    if (NULL != coalesce)
+    {
+        if (sizeof(cfg.coalesce) <= strlen(coalesce))
+        {
+            printf("!!! coalescing policies in %s are too long !!!\n", path);
+            p_free(coalesce);
+            return FALSE;
+        }
+
+        strcpy(cfg.coalesce, coalesce);
+        p_free(coalesce);
+    }
+
+    return config_store_publish(self, &cfg);
+}
+
+pboolean
+config_store_watch(      struct config_store_t* const self,
+                   const pchar*                 const path,
+                   const puint32                      period_ms)
+{
+    if (NULL != self->watch_th) {
+        return FALSE;
+    }
+
+    self->watch_path = p_strdup(path);
+
+    if (NULL == self->watch_path) {
+        return FALSE;
+    }
+
+    self->watch_period_ms = period_ms;
+    self->watch_done      = FALSE;
+    self->watch_th        = p_uthread_create(config_store_watch_task, self, TRUE);
+
+    return NULL != self->watch_th;
+}
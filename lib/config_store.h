@@ -0,0 +1,151 @@
+#ifndef _CONFIG_STORE_H_INCLUDED
+    #define _CONFIG_STORE_H_INCLUDED
+
+    #include "plibsys.h"
+
+    #define CONFIG_STORE_MAX_SENSORS 256 // every value of sens_sample_t.sens_id
+
+    /**
+     * Maximum number of threads registered to read the configuration.
+     */
+    #define CONFIG_STORE_MAX_READERS 8
+
+    /**
+     * Longest coalescing policy list, terminating NUL included.
+     */
+    #define CONFIG_STORE_MAX_SPEC 128
+
+    /**
+     * Handler of the samples of a sensor.
+     * @param val: The sample value.
+     * @param proc_ms: The processing time to spend on the sample, in milliseconds.
+     */
+    typedef void (*config_sample_hdlr)(puint32 val, puint32 proc_ms);
+
+    /**
+     * Handler of a batch of samples of a sensor, drained from the queue together.
+     * @param sens_id: The sensor ID.
+     * @param vals: The sample values, in queue order.
+     * @param count: The number of samples.
+     * @param proc_ms: The processing time to spend on each sample of the batch, in milliseconds.
+     */
+    typedef void (*config_batch_hdlr)(puint8 sens_id, const puint32* vals, psize count, puint32 proc_ms);
+
+    /**
+     * A snapshot of the tunable configuration. A published snapshot is never
+     * modified, a change publishes a new one.
+     */
+    typedef struct config_t
+    {
+        struct
+        {
+            config_sample_hdlr hdlr;       // The handler, NULL if the sensor is not handled
+            config_batch_hdlr  batch_hdlr; // The batch handler, used instead of hdlr if not NULL
+            puint32            proc_ms;    // The processing time of a sample, also in a batch
+        } sens[CONFIG_STORE_MAX_SENSORS];
+
+        puint64 fetch_timeout_us; // Longest wait of the consumer on an empty queue
+        pchar   coalesce[CONFIG_STORE_MAX_SPEC]; // Coalescing policies of the collector, see sample_coalesce_configure()
+        puint64 version;          // Incremented on every publication
+    }config;
+
+    struct config_store_t;
+
+    /**
+     * Configuration store constructor.
+     * @param initial: The configuration to publish first, copied.
+     * @returns: A pointer to the store if successful, NULL otherwise.
+     */
+    struct config_store_t*
+    config_store_create(const struct config_t* const initial);
+
+    /**
+     * Configuration store destructor.
+     * Stops watching the configuration file. No reader may be inside a read-side
+     * section.
+     * @param self: A pointer to the store instance.
+     */
+    void
+    config_store_destroy(struct config_store_t* const self);
+
+    /**
+     * Register the calling thread as a reader.
+     * @param self: A pointer to the store instance.
+     * @returns: The reader ID to pass to the read-side calls, -1 if all the
+     * reader slots are taken.
+     */
+    pint
+    config_store_register_reader(struct config_store_t* const self);
+
+    /**
+     * Release a reader ID.
+     * @param self: A pointer to the store instance.
+     * @param reader: The reader ID.
+     */
+    void
+    config_store_unregister_reader(      struct config_store_t* const self,
+                                   const pint                         reader);
+
+    /**
+     * Enter a read-side section and get the current configuration, which stays
+     * valid until config_store_read_unlock(). It never blocks.
+     * @param self: A pointer to the store instance.
+     * @param reader: The reader ID.
+     * @returns: The current configuration.
+     */
+    const struct config_t*
+    config_store_read_lock(      struct config_store_t* const self,
+                           const pint                         reader);
+
+    /**
+     * Leave a read-side section.
+     * @param self: A pointer to the store instance.
+     * @param reader: The reader ID.
+     */
+    void
+    config_store_read_unlock(      struct config_store_t* const self,
+                             const pint                         reader);
+
+    /**
+     * Publish a new configuration. Readers entering a read-side section from now
+     * on get the new one, the previous one is released once every reader that
+     * may still use it has left its section.
+     * @param self: A pointer to the store instance.
+     * @param cfg: The configuration to publish, copied.
+     * @returns: TRUE if successful, FALSE otherwise.
+     */
+    pboolean
+    config_store_publish(      struct config_store_t* const self,
+                         const struct config_t*       const cfg);
+
+    /**
+     * Publish the current configuration updated from an INI file:
+     *   [sensorN]
+     *   proc_ms = <processing time of a sample of sensor N>
+     *   [consumer]
+     *   fetch_timeout_ms = <longest wait on an empty queue>
+     *   [collector]
+     *   coalesce = <coalescing policies, as for sample_coalesce_configure()>
+     * Missing keys keep their current value.
+     * @param self: A pointer to the store instance.
+     * @param path: The path of the INI file.
+     * @returns: TRUE if successful, FALSE otherwise.
+     */
+    pboolean
+    config_store_load(      struct config_store_t* const self,
+                      const pchar*                 const path);
+
+    /**
+     * Start a thread reloading the INI file with config_store_load() whenever its
+     * modification time changes.
+     * @param self: A pointer to the store instance.
+     * @param path: The path of the INI file.
+     * @param period_ms: How often the file is checked, in milliseconds.
+     * @returns: TRUE if successful, FALSE otherwise.
+     */
+    pboolean
+    config_store_watch(      struct config_store_t* const self,
+                       const pchar*                 const path,
+                       const puint32                      period_ms);
+
+#endif // _CONFIG_STORE_H_INCLUDED
@@ -0,0 +1,596 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "metrics.h"
+
+// Longest time the exporter thread waits for a connection before it rechecks for shutdown
+#define METRICS_ACCEPT_TIMEOUT_MS 200
+
+// Longest time a scraper may take to send its request and read the response
+#define METRICS_CLIENT_TIMEOUT_MS 1000
+
+struct metric_t
+{
+    metric_type       type;
+    pchar*            name;
+    pchar*            labels; // NULL for none
+    pchar*            help;
+    pdouble           scale;
+    volatile psize    value;
+    const PHistogram* hist;   // Set for a summary, value is unused then
+};
+
+struct metrics_t
+{
+    PListHead            metrics; // struct metric_t*, in the order they were added
+    metrics_collect_func collect_func;
+    ppointer             collect_data;
+
+    PSocket*             listener;
+    PUThread*            server_th;
+    volatile pint        is_stopping;
+};
+
+// A growing text buffer
+struct metrics_text_t
+{
+    pchar*   data;
+    psize    len;
+    psize    cap;
+    pboolean is_oom;
+};
+
+static void
+metrics_text_printf(      struct metrics_text_t* const self,
+                    const pchar*                 const format,
+                    ...)
+{
+    if (self->is_oom) {
+        return;
+    }
+
+    va_list args;
+
+    va_start(args, format);
+    const int needed = vsnprintf(self->data + self->len, self->cap - self->len, format, args);
+    va_end(args);
+
+    if (needed < 0)
+    {
+        self->is_oom = TRUE;
+        return;
+    }
+
+    if (self->len + (psize) needed < self->cap)
+    {
+        self->len += (psize) needed;
+        return;
+    }
+
+    psize new_cap = self->cap * 2;
+
+    while (new_cap <= self->len + (psize) needed) {
+        new_cap *= 2;
+    }
+
+    pchar* const new_data = p_realloc(self->data, new_cap);
+
+    if (NULL == new_data)
+    {
+        self->is_oom = TRUE;
+        return;
+    }
+
+    self->data = new_data;
+    self->cap  = new_cap;
+
+    va_start(args, format);
+    vsnprintf(self->data + self->len, self->cap - self->len, format, args);
+    va_end(args);
+
+    self->len += (psize) needed;
+}
+
+static void
+metric_free(struct metric_t* const metric)
+{
+    p_free(metric->name);
+    p_free(metric->labels);
+    p_free(metric->help);
+    p_free(metric);
+}
+
+/**
+ * Free a metric, for p_list_foreach().
+ */
+static void
+metric_free_func(ppointer metric, ppointer user_data)
+{
+    P_UNUSED(user_data);
+
+    metric_free(metric);
+}
+
+/**
+ * Allocate a metric and append it to the registry.
+ * @returns: The metric, NULL if out of memory
+ */
+static struct metric_t*
+metrics_append(      struct metrics_t* const self,
+               const metric_type             type,
+               const pchar*            const name,
+               const pchar*            const labels,
+               const pchar*            const help,
+               const pdouble                 scale)
+{
+    struct metric_t* metric = NULL;
+
+    do
+    {
+        metric = p_malloc0(sizeof(struct metric_t));
+
+        if (NULL == metric)
+        {
+            printf("!!! not enough memory to add metric %s !!!\n", name);
+            break;
+        }
+
+        metric->type  = type;
+        metric->scale = scale;
+        metric->name  = p_strdup(name);
+        metric->help  = p_strdup(help);
+
+        if (NULL != labels) {
+            metric->labels = p_strdup(labels);
+        }
+
+        if ((NULL == metric->name) ||
+            (NULL == metric->help) ||
+            ((NULL != labels) && (NULL == metric->labels)))
+        {
+            printf("!!! not enough memory to add metric %s !!!\n", name);
+            metric_free(metric);
+            metric = NULL;
+            break;
+        }
+
+        if (!p_list_head_append(&self->metrics, metric))
+        {
+            printf("!!! not enough memory to add metric %s !!!\n", name);
+            metric_free(metric);
+            metric = NULL;
+            break;
+        }
+
+    } while (0);
+
+    return metric;
+}
+
+static void
+metrics_format_value(      struct metrics_text_t* const text,
+                     const struct metric_t*       const metric,
+                     const pchar*                 const suffix,
+                     const pchar*                 const labels,
+                     const psize                        value)
+{
+    metrics_text_printf(text, "%s%s", metric->name, suffix);
+
+    if (NULL != labels) {
+        metrics_text_printf(text, "{%s}", labels);
+    }
+
+    if (1.0 == metric->scale) {
+        metrics_text_printf(text, " %lu\n", value);
+    } else {
+        metrics_text_printf(text, " %.9g\n", (pdouble) value * metric->scale);
+    }
+}
+
+static void
+metrics_format_summary(      struct metrics_text_t* const text,
+                       const struct metric_t*       const metric)
+{
+    static const pdouble quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+    for (psize idx = 0;
+               idx < sizeof(quantiles) / sizeof(quantiles[0]);
+               idx++)
+    {
+        pchar labels[32];
+
+        snprintf(labels, sizeof(labels), "quantile=\"%g\"", quantiles[idx]);
+
+        metrics_format_value(text,
+                             metric,
+                             "",
+                             labels,
+                             p_histogram_value_at_percentile(metric->hist, quantiles[idx] * 100.0));
+    }
+
+    const puint64 count = p_histogram_count(metric->hist);
+
+    metrics_text_printf(text,
+                        "%s_sum %.9g\n",
+                        metric->name,
+                        p_histogram_mean(metric->hist) * (pdouble) count * metric->scale);
+
+    metrics_text_printf(text, "%s_count %lu\n", metric->name, count);
+}
+
+/**
+ * Answer a scraper with the current metrics.
+ * @param conn: The connection of the scraper
+ */
+static void
+metrics_answer(      struct metrics_t* const self,
+               const PSocket*          const conn)
+{
+    pchar request[4096];
+    psize request_len = 0;
+
+    // the request is not parsed, whatever path is asked for gets the metrics
+    while (request_len < sizeof(request) - 1)
+    {
+        const pssize received = p_socket_receive(conn,
+                                                 request + request_len,
+                                                 sizeof(request) - 1 - request_len,
+                                                 NULL);
+
+        if (received <= 0) {
+            return;
+        }
+
+        request_len += (psize) received;
+        request[request_len] = '\0';
+
+        if (NULL != strstr(request, "\r\n\r\n")) {
+            break;
+        }
+    }
+
+    psize body_len = 0;
+    pchar* const body = metrics_format(self, &body_len);
+
+    if (NULL == body) {
+        return;
+    }
+
+    pchar header[160];
+
+    const int header_len = snprintf(header,
+                                    sizeof(header),
+                                    "HTTP/1.0 200 OK\r\n"
+                                    "Content-Type: text/plain; version=0.0.4\r\n"
+                                    "Content-Length: %lu\r\n"
+                                    "Connection: close\r\n"
+                                    "\r\n",
+                                    body_len);
+
+    const pchar* const parts[]     = { header, body };
+    const psize        parts_len[] = { (psize) header_len, body_len };
+
+    for (psize part = 0;
+               part < 2;
+               part++)
+    {
+        psize sent = 0;
+
+        while (sent < parts_len[part])
+        {
+            const pssize res = p_socket_send(conn,
+                                             parts[part] + sent,
+                                             parts_len[part] - sent,
+                                             NULL);
+
+            if (res <= 0)
+            {
+                p_free(body);
+                return;
+            }
+
+            sent += (psize) res;
+        }
+    }
+
+    p_free(body);
+}
+
+static ppointer
+metrics_server_task(ppointer arg)
+{
+    struct metrics_t* const self = (struct metrics_t*) arg;
+
+    while (!p_atomic_int_get(&self->is_stopping))
+    {
+        PError* error = NULL;
+        PSocket* const conn = p_socket_accept(self->listener, &error);
+
+        if (NULL == conn)
+        {
+            if ((NULL != error) &&
+                (P_ERROR_IO_TIMED_OUT != p_error_get_code(error)))
+            {
+                printf("!!! failed to accept a metrics connection: %s !!!\n",
+                       p_error_get_message(error));
+            }
+
+            if (NULL != error) {
+                p_error_free(error);
+            }
+
+            continue;
+        }
+
+        p_socket_set_blocking(conn, TRUE);
+        p_socket_set_timeout(conn, METRICS_CLIENT_TIMEOUT_MS);
+
+        metrics_answer(self, conn);
+
+        p_socket_close(conn, NULL);
+        p_socket_free(conn);
+    }
+
+    return NULL;
+}
+
+struct metrics_t*
+metrics_create(void)
+{
+    struct metrics_t* const self = p_malloc0(sizeof(struct metrics_t));
+
+    if (NULL == self)
+    {
+        printf("!!! not enough memory to create the metrics registry !!!\n");
+        return NULL;
+    }
+
+    p_list_head_init(&self->metrics, NULL);
+
+    return self;
+}
+
+void
+metrics_destroy(struct metrics_t* const self)
+{
+    if (NULL == self) {
+        return;
+    }
+
+    if (NULL != self->server_th)
+    {
+        p_atomic_int_set(&self->is_stopping, TRUE);
+        p_uthread_join(self->server_th);
+        p_uthread_unref(self->server_th);
+        self->server_th = NULL;
+    }
+
+    if (NULL != self->listener)
+    {
+        p_socket_close(self->listener, NULL);
+        p_socket_free(self->listener);
+        self->listener = NULL;
+    }
+
+    p_list_foreach(self->metrics.first, metric_free_func, NULL);
+    p_list_head_clear(&self->metrics);
+
+    p_free(self);
+}
+
+struct metric_t*
+metrics_add(      struct metrics_t* const self,
+            const metric_type             type,
+            const pchar*            const name,
+            const pchar*            const labels,
+            const pchar*            const help,
+            const pdouble                 scale)
+{
+    return metrics_append(self, type, name, labels, help, scale);
+}
+
+pboolean
+metrics_add_summary(      struct metrics_t* const self,
+                    const pchar*            const name,
+                    const pchar*            const help,
+                    const PHistogram*       const hist,
+                    const pdouble                 scale)
+{
+    struct metric_t* const metric = metrics_append(self, METRIC_GAUGE, name, NULL, help, scale);
+
+    if (NULL == metric) {
+        return FALSE;
+    }
+
+    metric->hist = hist;
+
+    return TRUE;
+}
+
+void
+metrics_set_collect_func(      struct metrics_t*    const self,
+                         const metrics_collect_func       func,
+                               ppointer                   data)
+{
+    self->collect_func = func;
+    self->collect_data = data;
+}
+
+void
+metric_add(      struct metric_t* const metric,
+           const psize                  delta)
+{
+    if (NULL != metric) {
+        p_atomic_pointer_add(&metric->value, (pssize) delta);
+    }
+}
+
+void
+metric_set(      struct metric_t* const metric,
+           const psize                  value)
+{
+    if (NULL != metric) {
+        p_atomic_pointer_set(&metric->value, PSIZE_TO_POINTER(value));
+    }
+}
+
+void
+metric_set_max(      struct metric_t* const metric,
+               const psize                  value)
+{
+    if (NULL == metric) {
+        return;
+    }
+
+    psize current = PPOINTER_TO_PSIZE(p_atomic_pointer_get(&metric->value));
+
+    while ((current < value) &&
+           !p_atomic_pointer_compare_and_exchange(&metric->value,
+                                                  PSIZE_TO_POINTER(current),
+                                                  PSIZE_TO_POINTER(value)))
+    {
+        current = PPOINTER_TO_PSIZE(p_atomic_pointer_get(&metric->value));
+    }
+}
+
+psize
+metric_get(const struct metric_t* const metric)
+{
+    if (NULL == metric) {
+        return 0;
+    }
+
+    return PPOINTER_TO_PSIZE(p_atomic_pointer_get(&metric->value));
+}
+
+pchar*
+metrics_format(struct metrics_t* const self,
+               psize*            const size)
+{
+    struct metrics_text_t text = { NULL, 0, 4096, FALSE };
+
+    text.data = p_malloc(text.cap);
+
+    if (NULL == text.data)
+    {
+        printf("!!! not enough memory to format the metrics !!!\n");
+        return NULL;
+    }
+
+    text.data[0] = '\0';
+
+    if (NULL != self->collect_func) {
+        self->collect_func(self->collect_data);
+    }
+
+    const pchar* family = NULL;
+
+    for (PList* item = self->metrics.first;
+                item != NULL;
+                item = item->next)
+    {
+        const struct metric_t* const metric = item->data;
+
+        // samples of a family share the HELP and TYPE lines
+        if ((NULL == family) ||
+            (0 != strcmp(family, metric->name)))
+        {
+            family = metric->name;
+
+            metrics_text_printf(&text, "# HELP %s %s\n", metric->name, metric->help);
+            metrics_text_printf(&text,
+                                "# TYPE %s %s\n",
+                                metric->name,
+                                (NULL != metric->hist) ? "summary" :
+                                (METRIC_COUNTER == metric->type) ? "counter" : "gauge");
+        }
+
+        if (NULL != metric->hist) {
+            metrics_format_summary(&text, metric);
+        } else {
+            metrics_format_value(&text, metric, "", metric->labels, metric_get(metric));
+        }
+    }
+
+    if (text.is_oom)
+    {
+        printf("!!! not enough memory to format the metrics !!!\n");
+        p_free(text.data);
+        return NULL;
+    }
+
+    *size = text.len;
+
+    return text.data;
+}
+
+pboolean
+metrics_serve(      struct metrics_t* const self,
+              const puint16                 port)
+{
+    PError* error = NULL;
+    PSocketAddress* address = NULL;
+    pboolean is_serving = FALSE;
+
+    do
+    {
+        self->listener = p_socket_new(P_SOCKET_FAMILY_INET,
+                                      P_SOCKET_TYPE_STREAM,
+                                      P_SOCKET_PROTOCOL_TCP,
+                                      &error);
+
+        if (NULL == self->listener) {
+            break;
+        }
+
+        address = p_socket_address_new_loopback(P_SOCKET_FAMILY_INET, port);
+
+        if (NULL == address)
+        {
+            printf("!!! not enough memory to create the metrics address !!!\n");
+            break;
+        }
+
+        if (!p_socket_bind(self->listener, address, TRUE, &error) ||
+            !p_socket_listen(self->listener, &error))
+        {
+            break;
+        }
+
+        // the exporter thread wakes up regularly to notice metrics_destroy()
+        p_socket_set_timeout(self->listener, METRICS_ACCEPT_TIMEOUT_MS);
+
+        self->server_th = p_uthread_create(metrics_server_task, self, TRUE);
+
+        if (NULL == self->server_th)
+        {
+            printf("!!! failed to start the metrics exporter thread !!!\n");
+            break;
+        }
+
+        is_serving = TRUE;
+
+    } while (0);
+
+    if (NULL != error)
+    {
+        printf("!!! failed to listen for metrics on port %u: %s !!!\n",
+               port,
+               p_error_get_message(error));
+        p_error_free(error);
+    }
+
+    if (NULL != address) {
+        p_socket_address_free(address);
+    }
+
+    if ((!is_serving) &&
+        (NULL != self->listener))
+    {
+        p_socket_free(self->listener);
+        self->listener = NULL;
+    }
+
+    return is_serving;
+}
@@ -0,0 +1,144 @@
+#ifndef _METRICS_H_INCLUDED
+    #define _METRICS_H_INCLUDED
+
+    #include "plibsys.h"
+
+    /**
+     * Kind of a metric, as reported to Prometheus.
+     */
+    typedef enum metric_type_t
+    {
+        METRIC_COUNTER, // Only goes up, rates are taken by the scraper
+        METRIC_GAUGE    // Goes up and down
+    }metric_type;
+
+    struct metrics_t;
+    struct metric_t;
+
+    /**
+     * Called before the metrics are exported, to refresh the ones which are
+     * computed rather than updated as things happen.
+     * @param data: The data given to metrics_set_collect_func().
+     */
+    typedef void (*metrics_collect_func)(ppointer data);
+
+    /**
+     * Metrics registry constructor.
+     * @returns: A pointer to the registry if successful, NULL otherwise.
+     */
+    struct metrics_t*
+    metrics_create(void);
+
+    /**
+     * Metrics registry destructor, stops the exporter if it is running.
+     * @param self: A pointer to the registry instance.
+     */
+    void
+    metrics_destroy(struct metrics_t* const self);
+
+    /**
+     * Add a counter or a gauge. All the metrics are added before the exporter
+     * is started, the ones sharing a name next to each other.
+     * @param self: A pointer to the registry instance.
+     * @param type: The kind of the metric.
+     * @param name: The name, e.g. "pcp_queue_pushes_total".
+     * @param labels: The labels, e.g. "sensor=\"1\"", NULL for none.
+     * @param help: The description.
+     * @param scale: The factor converting the value to the exported unit,
+     * e.g. 1e-9 for a value in nanoseconds exported in seconds.
+     * @returns: A handle to update the metric, NULL if out of memory.
+     */
+    struct metric_t*
+    metrics_add(      struct metrics_t* const self,
+                const metric_type             type,
+                const pchar*            const name,
+                const pchar*            const labels,
+                const pchar*            const help,
+                const pdouble                 scale);
+
+    /**
+     * Add a summary exporting the quantiles of a histogram. The histogram may
+     * be recorded into while it is exported.
+     * @param self: A pointer to the registry instance.
+     * @param name: The name, e.g. "pcp_handler_latency_seconds".
+     * @param help: The description.
+     * @param hist: The histogram, it must outlive the registry.
+     * @param scale: The factor converting the recorded values to the exported unit.
+     * @returns: TRUE if successful, FALSE if out of memory.
+     */
+    pboolean
+    metrics_add_summary(      struct metrics_t* const self,
+                        const pchar*            const name,
+                        const pchar*            const help,
+                        const PHistogram*       const hist,
+                        const pdouble                 scale);
+
+    /**
+     * Set the function refreshing the computed metrics.
+     * @param self: A pointer to the registry instance.
+     * @param func: The function, called from the exporter thread.
+     * @param data: The data to pass to func.
+     */
+    void
+    metrics_set_collect_func(      struct metrics_t*    const self,
+                             const metrics_collect_func       func,
+                                   ppointer                   data);
+
+    /**
+     * Add to a metric. Lock-free, may be called from any thread.
+     * @param metric: The metric, nothing is done if NULL.
+     * @param delta: The amount to add.
+     */
+    void
+    metric_add(      struct metric_t* const metric,
+               const psize                  delta);
+
+    /**
+     * Set a gauge. Lock-free, may be called from any thread.
+     * @param metric: The metric, nothing is done if NULL.
+     * @param value: The new value.
+     */
+    void
+    metric_set(      struct metric_t* const metric,
+               const psize                  value);
+
+    /**
+     * Raise a gauge to a value if it is lower, e.g. for a high-water mark.
+     * Lock-free, may be called from any thread.
+     * @param metric: The metric, nothing is done if NULL.
+     * @param value: The value.
+     */
+    void
+    metric_set_max(      struct metric_t* const metric,
+                   const psize                  value);
+
+    /**
+     * Get the value of a metric.
+     * @param metric: The metric.
+     * @returns: The value, 0 if metric is NULL.
+     */
+    psize
+    metric_get(const struct metric_t* const metric);
+
+    /**
+     * Write all the metrics in the Prometheus text format.
+     * @param self: A pointer to the registry instance.
+     * @param size: Where to store the length of the text.
+     * @returns: The text to free with p_free(), NULL if out of memory.
+     */
+    pchar*
+    metrics_format(struct metrics_t* const self,
+                   psize*            const size);
+
+    /**
+     * Start exporting the metrics over HTTP on the loopback interface, from a
+     * thread of its own, for a Prometheus server to scrape.
+     * @param self: A pointer to the registry instance.
+     * @param port: The TCP port to listen on.
+     * @returns: TRUE if the exporter is listening, FALSE otherwise.
+     */
+    pboolean
+    metrics_serve(      struct metrics_t* const self,
+                  const puint16                 port);
+
+#endif // _METRICS_H_INCLUDED
@@ -9,9 +9,11 @@
      */
     typedef struct sens_sample_t
     {
-        puint8  sens_id; // The sensor ID
-        puint32 val;     // The sample value
-        psize   num;     // The sample number
+        puint8  sens_id;      // The sensor ID
+        puint16 num_absorbed; // The number of samples right before this one absorbed by coalescing
+        puint32 val;          // The sample value
+        psize   num;          // The sample number
+        puint64 ts;           // The collection time in microseconds, 0 if unknown
     }sens_sample;
 
     struct queue_t;
@@ -24,6 +26,19 @@
     struct queue_t*
     queue_create(const psize len);
 
+    /**
+     * Concurrent queue constructor with placement options for the storage of the
+     * samples, to keep page faults and swapping off the push and pop path.
+     * With P_MEM_MAP_DEFAULT it is the same as queue_create().
+     * @param len: The capacity of the queue.
+     * @param storage_flags: A bitwise OR of PMemMapFlags, e.g. P_MEM_MAP_PREFAULT
+     * and P_MEM_MAP_LOCKED to commit and lock the storage at creation.
+     * @returns: A pointer to the queue if successful, NULL otherwise.
+     */
+    struct queue_t*
+    queue_create_full(const psize len,
+                      const puint storage_flags);
+
     /**
      * Concurrent queue destructor.
      * @param self: A pointer to the queue instance.
@@ -38,6 +53,14 @@
     pboolean
     queue_full(struct queue_t* const self);
 
+    /**
+     * Returns true if the queue can accept another item without blocking.
+     * Unlike queue_full() it prints nothing, so it suits per-item checks.
+     * @param self: A pointer to the queue instance.
+     */
+    pboolean
+    queue_has_room(struct queue_t* const self);
+
     /**
      * Returns true if the queue is empty.
      * @param self: A pointer to the queue instance.
@@ -64,4 +87,16 @@
     struct sens_sample_t
     queue_pop(struct queue_t* const self);
 
+    /**
+     * Pop an item from the queue, waiting at most the given time for one.
+     * @param self: A pointer to the queue instance.
+     * @param timeout_us: The longest time to wait in microseconds.
+     * @param sample: Where to store the sample.
+     * @returns: TRUE if a sample was popped, FALSE if the queue stayed empty.
+     */
+    pboolean
+    queue_pop_timed(      struct queue_t*      const self,
+                    const puint64                    timeout_us,
+                          struct sens_sample_t* const sample);
+
 #endif // _QUEUE_USING_LINKED_LIST_H_INCLUDED
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <unistd.h>
+
+#include "queue_storage.h"
+
+ppointer
+queue_storage_alloc(const psize        size,
+                    const puint        flags,
+                          psize* const mapped_size)
+{
+    psize map_size = size;
+
+    if (0 != (flags & P_MEM_MAP_HUGE_PAGES))
+    {
+        const psize huge_size = p_mem_huge_page_size();
+
+        // smaller rings are left to transparent huge pages instead of wasting a whole one
+        if ((0 != huge_size) &&
+            (map_size >= huge_size))
+        {
+            map_size = (map_size + huge_size - 1) / huge_size * huge_size;
+        }
+    }
+
+    PError* error = NULL;
+    const ppointer mem = p_mem_mmap_full(map_size, flags, &error);
+
+    if (NULL == mem)
+    {
+        printf("!!! failed to map %lu bytes of queue storage: %s !!!\n",
+               map_size,
+               (NULL != error) ? p_error_get_message(error) : "unknown error");
+
+        if (NULL != error) {
+            p_error_free(error);
+        }
+
+        return NULL;
+    }
+
+    *mapped_size = map_size;
+
+    return mem;
+}
+
+void
+queue_storage_free(ppointer    mem,
+                   const psize mapped_size)
+{
+    if (NULL == mem) {
+        return;
+    }
+
+    if (!p_mem_munmap(mem, mapped_size, NULL)) {
+        printf("!!! failed to unmap the queue storage !!!\n");
+    }
+}
+
+psize
+queue_storage_rss(void)
+{
+    FILE* const file = fopen("/proc/self/statm", "r");
+
+    if (NULL == file) {
+        return 0;
+    }
+
+    unsigned long total_pages    = 0;
+    unsigned long resident_pages = 0;
+
+    const int num_fields = fscanf(file, "%lu %lu", &total_pages, &resident_pages);
+
+    fclose(file);
+
+    if (2 != num_fields) {
+        return 0;
+    }
+
+    return (psize) resident_pages * (psize) sysconf(_SC_PAGESIZE);
+}
@@ -0,0 +1,37 @@
+#ifndef _QUEUE_STORAGE_H_INCLUDED
+    #define _QUEUE_STORAGE_H_INCLUDED
+
+    #include "plibsys.h"
+
+    /**
+     * Allocate the sample storage of a queue as a memory mapping with the given
+     * placement options. With P_MEM_MAP_HUGE_PAGES a storage of at least one huge
+     * page is rounded up to whole huge pages.
+     * @param size: The size of the storage in bytes.
+     * @param flags: A bitwise OR of PMemMapFlags.
+     * @param mapped_size: Where to store the size actually mapped, to pass to
+     * queue_storage_free().
+     * @returns: The zero-filled storage if successful, NULL otherwise.
+     */
+    ppointer
+    queue_storage_alloc(const psize        size,
+                        const puint        flags,
+                              psize* const mapped_size);
+
+    /**
+     * Release a storage allocated with queue_storage_alloc().
+     * @param mem: The storage.
+     * @param mapped_size: The size returned by queue_storage_alloc().
+     */
+    void
+    queue_storage_free(ppointer    mem,
+                       const psize mapped_size);
+
+    /**
+     * Get the resident set size of the process.
+     * @returns: The size in bytes, 0 if it is unknown.
+     */
+    psize
+    queue_storage_rss(void);
+
+#endif // _QUEUE_STORAGE_H_INCLUDED
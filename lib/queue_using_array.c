@@ -1,10 +1,12 @@
 #include <assert.h>
 
 #include "queue.h"
+#include "queue_storage.h"
 
 struct queue_t
 {
     struct sens_sample_t *data;
+    psize data_mapped_size; // 0 if data comes from the heap
     psize len;
     psize next_in;
     psize next_out;
@@ -23,6 +25,13 @@ queue_incr(struct queue_t* const self,
 
 struct queue_t*
 queue_create(const psize len)
+{
+    return queue_create_full(len, P_MEM_MAP_DEFAULT);
+}
+
+struct queue_t*
+queue_create_full(const psize len,
+                  const puint storage_flags)
 {
     struct queue_t* self = p_malloc0(sizeof(struct queue_t));
 
@@ -31,7 +40,16 @@ queue_create(const psize len)
         return NULL;
     }
 
-    self->data = p_malloc0(sizeof(struct sens_sample_t) * len);
+    if (storage_flags == P_MEM_MAP_DEFAULT)
+    {
+        self->data = p_malloc0(sizeof(struct sens_sample_t) * len);
+    }
+    else
+    {
+        self->data = queue_storage_alloc(sizeof(struct sens_sample_t) * len,
+                                         storage_flags,
+                                         &self->data_mapped_size);
+    }
 
     if (self->data == NULL)
     {
@@ -79,7 +97,12 @@ queue_destroy(struct queue_t *const self)
 
     if (self->data != NULL)
     {
-        p_free(self->data);
+        if (self->data_mapped_size != 0) {
+            queue_storage_free(self->data, self->data_mapped_size);
+        } else {
+            p_free(self->data);
+        }
+
         self->data = NULL;
     }
 
@@ -110,7 +133,7 @@ queue_full(struct queue_t *const self)
     // Modified for print log
     //return queue_incr(self, self->next_in) == self->next_out;
 
-    pboolean is_full = queue_incr(self, self->next_in) == self->next_out;
+    pboolean is_full = !queue_has_room(self);
 
     if (is_full) {
         printf("!!! queue is full !!!");
@@ -119,6 +142,12 @@ queue_full(struct queue_t *const self)
     return is_full;
 }
 
+pboolean
+queue_has_room(struct queue_t *const self)
+{
+    return queue_incr(self, self->next_in) != self->next_out;
+}
+
 pboolean
 queue_empty(struct queue_t *const self)
 {
@@ -166,3 +195,52 @@ queue_pop(struct queue_t* const self)
 
     return sample;
 }
+
+pboolean
+queue_pop_timed(      struct queue_t*      const self,
+                const puint64                    timeout_us,
+                      struct sens_sample_t* const sample)
+{
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the queue !!!\n");
+        return FALSE;
+    }
+
+    if (queue_empty(self))
+    {
+        // keep the deadline across spurious wake-ups
+        PTimeProfiler* const origin = p_time_profiler_new();
+
+        if (NULL == origin)
+        {
+            p_cond_variable_wait_for(self->non_empty_sig,
+                                     self->mutex,
+                                     timeout_us);
+        }
+        else
+        {
+            while (queue_empty(self) &&
+                   p_cond_variable_wait_until(self->non_empty_sig,
+                                              self->mutex,
+                                              origin,
+                                              timeout_us));
+
+            p_time_profiler_free(origin);
+        }
+    }
+
+    if (queue_empty(self))
+    {
+        p_mutex_unlock(self->mutex);
+        return FALSE;
+    }
+
+    *sample = self->data[self->next_out];
+    self->next_out = queue_incr(self, self->next_out);
+
+    p_mutex_unlock(self->mutex);
+    p_cond_variable_signal(self->non_full_sig);
+
+    return TRUE;
+}
@@ -1,6 +1,7 @@
 #include <assert.h>
 
 #include "queue.h"
+#include "queue_storage.h"
 
 // a single link list
 typedef struct sens_sample_node_t sens_sample_node;
@@ -20,11 +21,24 @@ struct queue_t
 
     psize             len;
 
+    // The initial nodes if they were allocated with placement options, the
+    // nodes added later on always come from the heap
+    sens_sample_node* nodes_block;
+    psize             nodes_block_size;
+
     PMutex*           mutex;
+    PCondVariable*    non_empty_sig;
 };
 
 struct queue_t*
 queue_create(const psize len)
+{
+    return queue_create_full(len, P_MEM_MAP_DEFAULT);
+}
+
+struct queue_t*
+queue_create_full(const psize len,
+                  const puint storage_flags)
 {
     struct queue_t* self = NULL;
 
@@ -38,13 +52,29 @@ queue_create(const psize len)
             break;
         }
 
+        if (P_MEM_MAP_DEFAULT != storage_flags)
+        {
+            self->nodes_block = queue_storage_alloc(sizeof(sens_sample_node) * len,
+                                                    storage_flags,
+                                                    &self->nodes_block_size);
+
+            if (NULL == self->nodes_block)
+            {
+                queue_destroy(self);
+                self = NULL;
+                break;
+            }
+        }
+
         sens_sample_node* last_node = NULL;
 
         for (psize idx = 0;
                    idx < len;
                    idx++)
         {
-            sens_sample_node *new_node = p_malloc0(sizeof(sens_sample_node));
+            sens_sample_node *new_node = (NULL != self->nodes_block) ?
+                                         &self->nodes_block[idx] :
+                                         p_malloc0(sizeof(sens_sample_node));
 
             if (NULL == new_node)
             {
@@ -87,6 +117,15 @@ queue_create(const psize len)
             break;
         }
 
+        self->non_empty_sig = p_cond_variable_new();
+
+        if (NULL == self->non_empty_sig)
+        {
+            printf("!!! not enough memory to create a condition variable !!!\n");
+            queue_destroy(self);
+            break;
+        }
+
         self->len = len;
         self->next_in  = self->head_data;
         self->next_out = self->head_data;
@@ -112,7 +151,19 @@ queue_destroy(struct queue_t* const self)
     {
         sens_sample_node *last_node = curr_node;
         curr_node = last_node->next_node;
-        p_free(last_node);
+
+        if ((NULL == self->nodes_block) ||
+            ((pchar*) last_node < (pchar*) self->nodes_block) ||
+            ((pchar*) last_node >= (pchar*) self->nodes_block + self->nodes_block_size))
+        {
+            p_free(last_node);
+        }
+    }
+
+    if (NULL != self->nodes_block)
+    {
+        queue_storage_free(self->nodes_block, self->nodes_block_size);
+        self->nodes_block = NULL;
     }
 
     self->head_data = NULL;
@@ -126,9 +177,30 @@ queue_destroy(struct queue_t* const self)
         self->mutex = NULL;
     }
 
+    if (self->non_empty_sig != NULL)
+    {
+        p_cond_variable_free(self->non_empty_sig);
+        self->non_empty_sig = NULL;
+    }
+
     p_free(self);
 }
 
+pboolean
+queue_full(struct queue_t* const self)
+{
+    // the linked list grows a new node whenever it runs out of free ones
+    P_UNUSED(self);
+
+    return FALSE;
+}
+
+pboolean
+queue_has_room(struct queue_t* const self)
+{
+    return !queue_full(self);
+}
+
 pboolean
 queue_empty(struct queue_t* const self)
 {
@@ -186,6 +258,8 @@ queue_push(      struct queue_t* const self,
         p_mutex_unlock(self->mutex);
     }
 
+    p_cond_variable_signal(self->non_empty_sig);
+
     printf("### Saving sensor %d sample %d number %ld ###\n",
            sample.sens_id,
            sample.val,
@@ -232,3 +306,49 @@ queue_pop(struct queue_t* const self)
 
     return sample;
 }
+
+pboolean
+queue_pop_timed(      struct queue_t*      const self,
+                const puint64                    timeout_us,
+                      struct sens_sample_t* const sample)
+{
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the queue !!!\n");
+        return FALSE;
+    }
+
+    if (self->next_in == self->next_out)
+    {
+        // keep the deadline across spurious wake-ups
+        PTimeProfiler* const origin = p_time_profiler_new();
+
+        if (NULL == origin)
+        {
+            p_cond_variable_wait_for(self->non_empty_sig,
+                                     self->mutex,
+                                     timeout_us);
+        }
+        else
+        {
+            while ((self->next_in == self->next_out) &&
+                   p_cond_variable_wait_until(self->non_empty_sig,
+                                              self->mutex,
+                                              origin,
+                                              timeout_us));
+
+            p_time_profiler_free(origin);
+        }
+    }
+
+    const pboolean is_popped = (self->next_in != self->next_out);
+
+    p_mutex_unlock(self->mutex);
+
+    if (is_popped) {
+        // the consumer is the only one advancing next_out
+        *sample = queue_pop(self);
+    }
+
+    return is_popped;
+}
@@ -0,0 +1,792 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sample_archive.h"
+
+#define SAMPLE_ARCHIVE_MAGIC   0x52504350 // "PCPR"
+#define SAMPLE_ARCHIVE_VERSION 1
+#define SAMPLE_ARCHIVE_ALIGN   8
+
+#define SAMPLE_RECORDER_MAX_SENSORS 256 // every value of sens_sample_t.sens_id
+
+/*
+ * File layout:
+ *   file header
+ *   blocks, each a block header followed by the ts, num and val columns,
+ *   padded to SAMPLE_ARCHIVE_ALIGN
+ *   block index, one entry per block
+ *   footer
+ */
+
+struct sample_archive_hdr_t
+{
+    puint32 magic;
+    puint32 version;
+};
+
+struct sample_archive_blk_t
+{
+    puint64 first_ts;
+    puint64 first_num;
+    puint32 first_val;
+    puint32 count;
+    puint32 sens_id;
+    puint32 ts_len;
+    puint32 num_len;
+    puint32 val_len;
+};
+
+struct sample_archive_idx_t
+{
+    puint64 offset;
+    puint64 first_ts;
+    puint64 last_ts;
+    puint64 first_num;
+    puint32 count;
+    puint32 sens_id;
+};
+
+struct sample_archive_ftr_t
+{
+    puint64 idx_offset;
+    puint32 block_count;
+    puint32 magic;
+};
+
+// --- encoding ---
+
+struct sample_archive_buf_t
+{
+    puint8* data;
+    psize   len;
+    psize   cap;
+
+    // bit writer state
+    puint32 bit_acc;
+    puint32 bit_cnt;
+};
+
+static pboolean
+buf_reserve(struct sample_archive_buf_t* const buf,
+            const psize                        extra)
+{
+    if (buf->len + extra <= buf->cap) {
+        return TRUE;
+    }
+
+    psize new_cap = (0 == buf->cap) ? 256 : buf->cap;
+
+    while (new_cap < buf->len + extra) {
+        new_cap *= 2;
+    }
+
+    puint8* new_data = p_realloc(buf->data, new_cap);
+
+    if (NULL == new_data) {
+        return FALSE;
+    }
+
+    buf->data = new_data;
+    buf->cap  = new_cap;
+
+    return TRUE;
+}
+
+static void
+buf_put_varint(struct sample_archive_buf_t* const buf,
+               puint64                            val)
+{
+    while (val >= 0x80)
+    {
+        buf->data[buf->len++] = (puint8) (val | 0x80);
+        val >>= 7;
+    }
+
+    buf->data[buf->len++] = (puint8) val;
+}
+
+static void
+buf_put_bits(struct sample_archive_buf_t* const buf,
+             const puint32                      val,
+             const puint32                      num_bits)
+{
+    for (puint32 bit = num_bits; bit > 0; bit--)
+    {
+        buf->bit_acc = (buf->bit_acc << 1) | ((val >> (bit - 1)) & 1);
+        buf->bit_cnt++;
+
+        if (8 == buf->bit_cnt)
+        {
+            buf->data[buf->len++] = (puint8) buf->bit_acc;
+            buf->bit_acc = 0;
+            buf->bit_cnt = 0;
+        }
+    }
+}
+
+static void
+buf_flush_bits(struct sample_archive_buf_t* const buf)
+{
+    if (0 < buf->bit_cnt)
+    {
+        buf->data[buf->len++] = (puint8) (buf->bit_acc << (8 - buf->bit_cnt));
+        buf->bit_acc = 0;
+        buf->bit_cnt = 0;
+    }
+}
+
+static inline puint64
+zigzag_encode(const pint64 val)
+{
+    return ((puint64) val << 1) ^ (puint64) (val >> 63);
+}
+
+static inline pint64
+zigzag_decode(const puint64 val)
+{
+    return (pint64) (val >> 1) ^ -(pint64) (val & 1);
+}
+
+// --- decoding ---
+
+struct sample_archive_rd_t
+{
+    const puint8* data;
+    psize         len;
+    psize         pos;
+    puint32       bit_pos;
+};
+
+static pboolean
+rd_get_varint(struct sample_archive_rd_t* const rd,
+              puint64*                    const val)
+{
+    puint64 res   = 0;
+    puint32 shift = 0;
+
+    while (rd->pos < rd->len && shift < 64)
+    {
+        const puint8 byte = rd->data[rd->pos++];
+
+        res |= (puint64) (byte & 0x7F) << shift;
+
+        if (0 == (byte & 0x80))
+        {
+            *val = res;
+            return TRUE;
+        }
+
+        shift += 7;
+    }
+
+    return FALSE;
+}
+
+static pboolean
+rd_get_bits(struct sample_archive_rd_t* const rd,
+            const puint32                     num_bits,
+            puint32*                    const val)
+{
+    puint32 res = 0;
+
+    for (puint32 bit = 0; bit < num_bits; bit++)
+    {
+        if (rd->pos >= rd->len) {
+            return FALSE;
+        }
+
+        res = (res << 1) | ((rd->data[rd->pos] >> (7 - rd->bit_pos)) & 1);
+
+        if (8 == ++rd->bit_pos)
+        {
+            rd->bit_pos = 0;
+            rd->pos++;
+        }
+    }
+
+    *val = res;
+
+    return TRUE;
+}
+
+// --- recorder ---
+
+struct sample_recorder_col_t
+{
+    puint64* ts;
+    psize*   num;
+    puint32* val;
+    psize    count;
+};
+
+struct sample_recorder_t
+{
+    FILE*                         file;
+    psize                         offset;
+    psize                         block_len;
+
+    struct sample_recorder_col_t* cols[SAMPLE_RECORDER_MAX_SENSORS]; // one column set per sensor ID, created on first use
+
+    struct sample_archive_idx_t*  idx;
+    psize                         idx_len;
+    psize                         idx_cap;
+
+    struct sample_archive_buf_t   buf;
+};
+
+static pboolean
+sample_recorder_put(      struct sample_recorder_t* const self,
+                    const void*                     const data,
+                    const psize                           len)
+{
+    if (len != fwrite(data, 1, len, self->file))
+    {
+        printf("!!! failed to write the sample archive !!!\n");
+        return FALSE;
+    }
+
+    self->offset += len;
+
+    return TRUE;
+}
+
+static pboolean
+sample_recorder_flush_block(      struct sample_recorder_t*     const self,
+                            const puint8                              sens_id,
+                                  struct sample_recorder_col_t* const col)
+{
+    if (0 == col->count) {
+        return TRUE;
+    }
+
+    struct sample_archive_buf_t* const buf = &self->buf;
+
+    // worst cases: 10 bytes per varint, 44 bits per value
+    buf->len = 0;
+
+    if (!buf_reserve(buf, col->count * (10 + 10 + 10) + SAMPLE_ARCHIVE_ALIGN))
+    {
+        printf("!!! not enough memory to encode a sample block !!!\n");
+        return FALSE;
+    }
+
+    struct sample_archive_blk_t blk;
+    memset(&blk, 0, sizeof(blk));
+
+    blk.first_ts  = col->ts[0];
+    blk.first_num = col->num[0];
+    blk.first_val = col->val[0];
+    blk.count     = (puint32) col->count;
+    blk.sens_id   = sens_id;
+
+    // timestamps: delta-of-delta
+    pint64 prev_delta = 0;
+
+    for (psize idx = 1; idx < col->count; idx++)
+    {
+        const pint64 delta = (pint64) (col->ts[idx] - col->ts[idx - 1]);
+
+        buf_put_varint(buf, zigzag_encode(delta - prev_delta));
+        prev_delta = delta;
+    }
+
+    blk.ts_len = (puint32) buf->len;
+
+    // sample numbers: delta
+    for (psize idx = 1; idx < col->count; idx++) {
+        buf_put_varint(buf, zigzag_encode((pint64) (col->num[idx] - col->num[idx - 1])));
+    }
+
+    blk.num_len = (puint32) buf->len - blk.ts_len;
+
+    // values: XOR against the previous value, keeping the meaningful bits only
+    puint32 prev_lead  = 0;
+    puint32 prev_trail = 0;
+    pboolean has_window = FALSE;
+
+    for (psize idx = 1; idx < col->count; idx++)
+    {
+        const puint32 xor_val = col->val[idx] ^ col->val[idx - 1];
+
+        if (0 == xor_val)
+        {
+            buf_put_bits(buf, 0, 1);
+            continue;
+        }
+
+        const puint32 lead  = (puint32) __builtin_clz(xor_val);
+        const puint32 trail = (puint32) __builtin_ctz(xor_val);
+
+        buf_put_bits(buf, 1, 1);
+
+        if (has_window && lead >= prev_lead && trail >= prev_trail)
+        {
+            buf_put_bits(buf, 0, 1);
+            buf_put_bits(buf, xor_val >> prev_trail, 32 - prev_lead - prev_trail);
+        }
+        else
+        {
+            const puint32 bits = 32 - lead - trail;
+
+            buf_put_bits(buf, 1, 1);
+            buf_put_bits(buf, lead, 5);
+            buf_put_bits(buf, bits - 1, 5);
+            buf_put_bits(buf, xor_val >> trail, bits);
+
+            prev_lead  = lead;
+            prev_trail = trail;
+            has_window = TRUE;
+        }
+    }
+
+    buf_flush_bits(buf);
+
+    blk.val_len = (puint32) buf->len - blk.ts_len - blk.num_len;
+
+    while (0 != (buf->len % SAMPLE_ARCHIVE_ALIGN)) {
+        buf->data[buf->len++] = 0;
+    }
+
+    if (self->idx_len == self->idx_cap)
+    {
+        const psize new_cap = (0 == self->idx_cap) ? 64 : self->idx_cap * 2;
+        struct sample_archive_idx_t* new_idx = p_realloc(self->idx,
+                                                         new_cap * sizeof(struct sample_archive_idx_t));
+
+        if (NULL == new_idx)
+        {
+            printf("!!! not enough memory to grow the block index !!!\n");
+            return FALSE;
+        }
+
+        self->idx     = new_idx;
+        self->idx_cap = new_cap;
+    }
+
+    struct sample_archive_idx_t* const entry = &self->idx[self->idx_len++];
+
+    entry->offset    = self->offset;
+    entry->first_ts  = col->ts[0];
+    entry->last_ts   = col->ts[col->count - 1];
+    entry->first_num = col->num[0];
+    entry->count     = (puint32) col->count;
+    entry->sens_id   = sens_id;
+
+    col->count = 0;
+
+    return sample_recorder_put(self, &blk, sizeof(blk)) &&
+           sample_recorder_put(self, buf->data, buf->len);
+}
+
+struct sample_recorder_t*
+sample_recorder_create(const pchar* const path,
+                       const psize        block_len)
+{
+    struct sample_recorder_t* self = NULL;
+
+    do
+    {
+        if (0 == block_len) {
+            break;
+        }
+
+        self = p_malloc0(sizeof(struct sample_recorder_t));
+
+        if (NULL == self)
+        {
+            printf("!!! not enough memory to create a sample recorder !!!\n");
+            break;
+        }
+
+        self->block_len = block_len;
+        self->file      = fopen(path, "wb");
+
+        if (NULL == self->file)
+        {
+            printf("!!! failed to create the sample archive %s !!!\n", path);
+            sample_recorder_destroy(self);
+            self = NULL;
+            break;
+        }
+
+        struct sample_archive_hdr_t hdr;
+
+        hdr.magic   = SAMPLE_ARCHIVE_MAGIC;
+        hdr.version = SAMPLE_ARCHIVE_VERSION;
+
+        if (!sample_recorder_put(self, &hdr, sizeof(hdr)))
+        {
+            sample_recorder_destroy(self);
+            self = NULL;
+            break;
+        }
+
+    } while (0);
+
+    return self;
+}
+
+void
+sample_recorder_destroy(struct sample_recorder_t* const self)
+{
+    if (NULL == self) {
+        return;
+    }
+
+    if (NULL != self->file)
+    {
+        pboolean is_ok = TRUE;
+
+        for (psize sens_id = 0;
+                   sens_id < SAMPLE_RECORDER_MAX_SENSORS;
+                   sens_id++)
+        {
+            if (NULL != self->cols[sens_id]) {
+                is_ok = is_ok && sample_recorder_flush_block(self, (puint8) sens_id, self->cols[sens_id]);
+            }
+        }
+
+        if (is_ok)
+        {
+            struct sample_archive_ftr_t ftr;
+
+            ftr.idx_offset  = self->offset;
+            ftr.block_count = (puint32) self->idx_len;
+            ftr.magic       = SAMPLE_ARCHIVE_MAGIC;
+
+            if (0 < self->idx_len) {
+                sample_recorder_put(self, self->idx, self->idx_len * sizeof(struct sample_archive_idx_t));
+            }
+
+            sample_recorder_put(self, &ftr, sizeof(ftr));
+        }
+
+        fclose(self->file);
+        self->file = NULL;
+    }
+
+    for (psize sens_id = 0;
+               sens_id < SAMPLE_RECORDER_MAX_SENSORS;
+               sens_id++)
+    {
+        struct sample_recorder_col_t* const col = self->cols[sens_id];
+
+        if (NULL != col)
+        {
+            p_free(col->ts);
+            p_free(col->num);
+            p_free(col->val);
+            p_free(col);
+            self->cols[sens_id] = NULL;
+        }
+    }
+
+    p_free(self->idx);
+    p_free(self->buf.data);
+    p_free(self);
+}
+
+pboolean
+sample_recorder_write(      struct sample_recorder_t* const self,
+                      const struct sens_sample_t            sample,
+                      const puint64                         ts)
+{
+    struct sample_recorder_col_t* col = self->cols[sample.sens_id];
+
+    if (NULL == col)
+    {
+        col = p_malloc0(sizeof(struct sample_recorder_col_t));
+
+        if (NULL == col) {
+            printf("!!! not enough memory to create a sample column !!!\n");
+            return FALSE;
+        }
+
+        col->ts  = p_malloc0(sizeof(puint64) * self->block_len);
+        col->num = p_malloc0(sizeof(psize)   * self->block_len);
+        col->val = p_malloc0(sizeof(puint32) * self->block_len);
+
+        self->cols[sample.sens_id] = col;
+
+        if ((NULL == col->ts) ||
+            (NULL == col->num) ||
+            (NULL == col->val))
+        {
+            printf("!!! not enough memory to create a sample column !!!\n");
+            return FALSE;
+        }
+    }
+
+    if ((NULL == col->ts) ||
+        (NULL == col->num) ||
+        (NULL == col->val))
+    {
+        return FALSE;
+    }
+
+    col->ts[col->count]  = ts;
+    col->num[col->count] = sample.num;
+    col->val[col->count] = sample.val;
+    col->count++;
+
+    if (self->block_len == col->count) {
+        return sample_recorder_flush_block(self, sample.sens_id, col);
+    }
+
+    return TRUE;
+}
+
+// --- reader ---
+
+struct sample_archive_t
+{
+    const puint8*                      map;
+    psize                              map_len;
+
+    const struct sample_archive_idx_t* idx;
+    psize                              block_count;
+    psize                              sample_count;
+};
+
+struct sample_archive_t*
+sample_archive_open(const pchar* const path)
+{
+    struct sample_archive_t* self = NULL;
+    int                      fd   = -1;
+
+    do
+    {
+        self = p_malloc0(sizeof(struct sample_archive_t));
+
+        if (NULL == self)
+        {
+            printf("!!! not enough memory to open a sample archive !!!\n");
+            break;
+        }
+
+        fd = open(path, O_RDONLY);
+
+        struct stat st;
+
+        if ((-1 == fd) ||
+            (0 != fstat(fd, &st)) ||
+            ((psize) st.st_size < sizeof(struct sample_archive_hdr_t) + sizeof(struct sample_archive_ftr_t)))
+        {
+            printf("!!! failed to open the sample archive %s !!!\n", path);
+            sample_archive_close(self);
+            self = NULL;
+            break;
+        }
+
+        void* map = mmap(NULL, (psize) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (MAP_FAILED == map)
+        {
+            printf("!!! failed to map the sample archive %s !!!\n", path);
+            sample_archive_close(self);
+            self = NULL;
+            break;
+        }
+
+        self->map     = (const puint8*) map;
+        self->map_len = (psize) st.st_size;
+
+        madvise(map, self->map_len, MADV_SEQUENTIAL);
+
+        const struct sample_archive_hdr_t* const hdr = (const struct sample_archive_hdr_t*) self->map;
+        const struct sample_archive_ftr_t* const ftr =
+            (const struct sample_archive_ftr_t*) (self->map + self->map_len - sizeof(struct sample_archive_ftr_t));
+
+        if ((SAMPLE_ARCHIVE_MAGIC != hdr->magic) ||
+            (SAMPLE_ARCHIVE_VERSION != hdr->version) ||
+            (SAMPLE_ARCHIVE_MAGIC != ftr->magic) ||
+            (0 != (ftr->idx_offset % SAMPLE_ARCHIVE_ALIGN)) ||
+            (ftr->idx_offset + (puint64) ftr->block_count * sizeof(struct sample_archive_idx_t) !=
+             self->map_len - sizeof(struct sample_archive_ftr_t)))
+        {
+            printf("!!! %s is not a complete sample archive !!!\n", path);
+            sample_archive_close(self);
+            self = NULL;
+            break;
+        }
+
+        self->idx         = (const struct sample_archive_idx_t*) (self->map + ftr->idx_offset);
+        self->block_count = ftr->block_count;
+
+        for (psize idx = 0; idx < self->block_count; idx++) {
+            self->sample_count += self->idx[idx].count;
+        }
+
+    } while (0);
+
+    if (-1 != fd) {
+        close(fd);
+    }
+
+    return self;
+}
+
+void
+sample_archive_close(struct sample_archive_t* const self)
+{
+    if (NULL == self) {
+        return;
+    }
+
+    if (NULL != self->map)
+    {
+        munmap((void*) self->map, self->map_len);
+        self->map = NULL;
+    }
+
+    p_free(self);
+}
+
+psize
+sample_archive_block_count(const struct sample_archive_t* const self)
+{
+    return self->block_count;
+}
+
+psize
+sample_archive_sample_count(const struct sample_archive_t* const self)
+{
+    return self->sample_count;
+}
+
+pboolean
+sample_archive_block_info(const struct sample_archive_t*        const self,
+                          const psize                                 idx,
+                                struct sample_archive_block_t* const block)
+{
+    if (idx >= self->block_count) {
+        return FALSE;
+    }
+
+    const struct sample_archive_idx_t* const entry = &self->idx[idx];
+
+    block->sens_id   = (puint8) entry->sens_id;
+    block->count     = entry->count;
+    block->first_ts  = entry->first_ts;
+    block->last_ts   = entry->last_ts;
+    block->first_num = (psize) entry->first_num;
+
+    return TRUE;
+}
+
+psize
+sample_archive_decode_block(const struct sample_archive_t* const self,
+                            const psize                          idx,
+                                  struct sample_record_t*  const records)
+{
+    if (idx >= self->block_count) {
+        return 0;
+    }
+
+    const struct sample_archive_idx_t* const entry = &self->idx[idx];
+
+    if (entry->offset + sizeof(struct sample_archive_blk_t) > self->map_len) {
+        return 0;
+    }
+
+    const struct sample_archive_blk_t* const blk = (const struct sample_archive_blk_t*) (self->map + entry->offset);
+    const puint8* const                      payload = (const puint8*) (blk + 1);
+
+    if ((blk->count != entry->count) ||
+        (0 == blk->count) ||
+        (entry->offset + sizeof(*blk) + (puint64) blk->ts_len + blk->num_len + blk->val_len > self->map_len))
+    {
+        return 0;
+    }
+
+    struct sample_archive_rd_t ts_rd  = { payload,                               blk->ts_len,  0, 0 };
+    struct sample_archive_rd_t num_rd = { payload + blk->ts_len,                 blk->num_len, 0, 0 };
+    struct sample_archive_rd_t val_rd = { payload + blk->ts_len + blk->num_len,  blk->val_len, 0, 0 };
+
+    records[0].ts                  = blk->first_ts;
+    records[0].sample.sens_id      = (puint8) blk->sens_id;
+    records[0].sample.num_absorbed = 0; // recorded before coalescing
+    records[0].sample.num          = (psize) blk->first_num;
+    records[0].sample.val          = blk->first_val;
+    records[0].sample.ts           = blk->first_ts;
+
+    pint64  prev_delta = 0;
+    puint32 prev_lead  = 0;
+    puint32 prev_trail = 0;
+
+    for (psize pos = 1; pos < blk->count; pos++)
+    {
+        struct sample_record_t* const rec  = &records[pos];
+        struct sample_record_t* const prev = &records[pos - 1];
+        puint64                       raw;
+        puint32                       bit;
+
+        if (!rd_get_varint(&ts_rd, &raw)) {
+            return 0;
+        }
+
+        prev_delta += zigzag_decode(raw);
+        rec->ts     = prev->ts + (puint64) prev_delta;
+
+        if (!rd_get_varint(&num_rd, &raw)) {
+            return 0;
+        }
+
+        rec->sample.sens_id      = (puint8) blk->sens_id;
+        rec->sample.num_absorbed = 0;
+        rec->sample.num          = prev->sample.num + (psize) zigzag_decode(raw);
+        rec->sample.ts           = rec->ts;
+
+        if (!rd_get_bits(&val_rd, 1, &bit)) {
+            return 0;
+        }
+
+        if (0 == bit)
+        {
+            rec->sample.val = prev->sample.val;
+            continue;
+        }
+
+        if (!rd_get_bits(&val_rd, 1, &bit)) {
+            return 0;
+        }
+
+        puint32 bits;
+        puint32 meaningful;
+
+        if (1 == bit)
+        {
+            if (!rd_get_bits(&val_rd, 5, &prev_lead) ||
+                !rd_get_bits(&val_rd, 5, &bits))
+            {
+                return 0;
+            }
+
+            bits++;
+
+            if (prev_lead + bits > 32) {
+                return 0;
+            }
+
+            prev_trail = 32 - prev_lead - bits;
+        }
+        else
+        {
+            bits = 32 - prev_lead - prev_trail;
+        }
+
+        if (!rd_get_bits(&val_rd, bits, &meaningful)) {
+            return 0;
+        }
+
+        rec->sample.val = prev->sample.val ^ (puint32) ((puint64) meaningful << prev_trail);
+    }
+
+    return blk->count;
+}
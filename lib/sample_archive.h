@@ -0,0 +1,124 @@
+#ifndef _SAMPLE_ARCHIVE_H_INCLUDED
+    #define _SAMPLE_ARCHIVE_H_INCLUDED
+
+    #include "plibsys.h"
+
+    #include "queue.h"
+
+    /**
+     * Default number of samples of a single sensor encoded into one block.
+     */
+    #define SAMPLE_ARCHIVE_BLOCK_LEN 1024
+
+    /**
+     * A recorded sample together with the time it was collected at.
+     */
+    typedef struct sample_record_t
+    {
+        puint64     ts;     // The collection time in microseconds
+        sens_sample sample; // The sample
+    }sample_record;
+
+    /**
+     * Description of a block of the archive, as stored in the block index.
+     */
+    typedef struct sample_archive_block_t
+    {
+        puint8  sens_id;  // The sensor ID of every sample in the block
+        psize   count;    // The number of samples in the block
+        puint64 first_ts; // The collection time of the first sample
+        puint64 last_ts;  // The collection time of the last sample
+        psize   first_num;// The sample number of the first sample
+    }sample_archive_block;
+
+    struct sample_recorder_t;
+    struct sample_archive_t;
+
+    /**
+     * Recorder constructor.
+     * Samples are buffered per sensor and written as columnar blocks: the
+     * timestamps are delta-of-delta encoded, the sample numbers delta encoded and
+     * the values XOR compressed against the previous value of the same sensor.
+     * @param path: The path of the archive file, truncated if it exists.
+     * @param block_len: The number of samples of a sensor per block.
+     * @returns: A pointer to the recorder if successful, NULL otherwise.
+     */
+    struct sample_recorder_t*
+    sample_recorder_create(const pchar* const path,
+                           const psize        block_len);
+
+    /**
+     * Recorder destructor.
+     * Writes the partially filled blocks, the block index and the footer.
+     * @param self: A pointer to the recorder instance.
+     */
+    void
+    sample_recorder_destroy(struct sample_recorder_t* const self);
+
+    /**
+     * Record a sample.
+     * @param self: A pointer to the recorder instance.
+     * @param sample: The sample to record.
+     * @param ts: The collection time of the sample in microseconds.
+     * @returns: TRUE if successful, FALSE otherwise.
+     */
+    pboolean
+    sample_recorder_write(      struct sample_recorder_t* const self,
+                          const struct sens_sample_t            sample,
+                          const puint64                         ts);
+
+    /**
+     * Archive reader constructor.
+     * The file is memory-mapped read-only and only its block index is parsed.
+     * @param path: The path of the archive file.
+     * @returns: A pointer to the archive if successful, NULL otherwise.
+     */
+    struct sample_archive_t*
+    sample_archive_open(const pchar* const path);
+
+    /**
+     * Archive reader destructor.
+     * @param self: A pointer to the archive instance.
+     */
+    void
+    sample_archive_close(struct sample_archive_t* const self);
+
+    /**
+     * Get the number of blocks in the archive.
+     * @param self: A pointer to the archive instance.
+     */
+    psize
+    sample_archive_block_count(const struct sample_archive_t* const self);
+
+    /**
+     * Get the total number of samples in the archive.
+     * @param self: A pointer to the archive instance.
+     */
+    psize
+    sample_archive_sample_count(const struct sample_archive_t* const self);
+
+    /**
+     * Get the index entry of a block.
+     * @param self: A pointer to the archive instance.
+     * @param idx: The index of the block.
+     * @param block: Where to store the block description.
+     * @returns: TRUE if successful, FALSE if the index is out of range.
+     */
+    pboolean
+    sample_archive_block_info(const struct sample_archive_t*  const self,
+                              const psize                           idx,
+                                    struct sample_archive_block_t* const block);
+
+    /**
+     * Decode the samples of a block.
+     * @param self: A pointer to the archive instance.
+     * @param idx: The index of the block.
+     * @param records: Where to store the samples, room for the block count is required.
+     * @returns: The number of decoded samples, 0 if the block is invalid.
+     */
+    psize
+    sample_archive_decode_block(const struct sample_archive_t* const self,
+                                const psize                          idx,
+                                      struct sample_record_t*  const records);
+
+#endif // _SAMPLE_ARCHIVE_H_INCLUDED
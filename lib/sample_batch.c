@@ -0,0 +1,130 @@
+#include <stdio.h>
+
+#include "sample_batch.h"
+
+struct sample_batch_t*
+sample_batch_create(const psize max_len)
+{
+    struct sample_batch_t* self = NULL;
+
+    do
+    {
+        self = p_malloc0(sizeof(struct sample_batch_t));
+
+        if (NULL == self)
+        {
+            printf("!!! not enough memory to create a sample batch !!!\n");
+            break;
+        }
+
+        // one allocation, the columns ordered by alignment
+        self->ts = p_malloc0(max_len * (sizeof(puint64) + sizeof(psize) + sizeof(puint32) + sizeof(puint16) + sizeof(puint8)));
+
+        if (NULL == self->ts)
+        {
+            printf("!!! not enough memory for a batch of %lu samples !!!\n", max_len);
+            sample_batch_destroy(self);
+            self = NULL;
+            break;
+        }
+
+        self->nums     = (psize*) (self->ts + max_len);
+        self->vals     = (puint32*) (self->nums + max_len);
+        self->absorbed = (puint16*) (self->vals + max_len);
+        self->ids      = (puint8*) (self->absorbed + max_len);
+        self->max_len  = max_len;
+
+    } while (0);
+
+    return self;
+}
+
+void
+sample_batch_destroy(struct sample_batch_t* const self)
+{
+    if (NULL == self) {
+        return;
+    }
+
+    if (NULL != self->ts)
+    {
+        p_free(self->ts);
+        self->ts = NULL;
+    }
+
+    p_free(self);
+}
+
+void
+sample_batch_clear(struct sample_batch_t* const self)
+{
+    self->len = 0;
+}
+
+psize
+sample_batch_pack(      struct sample_batch_t* const self,
+                  const struct sens_sample_t*  const samples,
+                  const psize                        count)
+{
+    const psize num_packed = (count < self->max_len - self->len) ? count : self->max_len - self->len;
+
+    for (psize idx = 0;
+               idx < num_packed;
+               idx++)
+    {
+        self->ids[self->len + idx]      = samples[idx].sens_id;
+        self->absorbed[self->len + idx] = samples[idx].num_absorbed;
+        self->vals[self->len + idx]     = samples[idx].val;
+        self->nums[self->len + idx]     = samples[idx].num;
+        self->ts[self->len + idx]       = samples[idx].ts;
+    }
+
+    self->len += num_packed;
+
+    return num_packed;
+}
+
+psize
+sample_batch_unpack(const struct sample_batch_t* const self,
+                    const psize                        first,
+                    const psize                        count,
+                          struct sens_sample_t*  const samples)
+{
+    if (first >= self->len) {
+        return 0;
+    }
+
+    const psize num_unpacked = (count < self->len - first) ? count : self->len - first;
+
+    for (psize idx = 0;
+               idx < num_unpacked;
+               idx++)
+    {
+        samples[idx].sens_id      = self->ids[first + idx];
+        samples[idx].num_absorbed = self->absorbed[first + idx];
+        samples[idx].val          = self->vals[first + idx];
+        samples[idx].num          = self->nums[first + idx];
+        samples[idx].ts           = self->ts[first + idx];
+    }
+
+    return num_unpacked;
+}
+
+psize
+sample_batch_gather(const struct sample_batch_t* const self,
+                    const puint8                       sens_id,
+                          puint32*               const vals)
+{
+    psize count = 0;
+
+    for (psize idx = 0;
+               idx < self->len;
+               idx++)
+    {
+        // unconditional store, the index only moves on a match
+        vals[count] = self->vals[idx];
+        count      += (self->ids[idx] == sens_id);
+    }
+
+    return count;
+}
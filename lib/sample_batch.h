@@ -0,0 +1,84 @@
+#ifndef _SAMPLE_BATCH_H_INCLUDED
+    #define _SAMPLE_BATCH_H_INCLUDED
+
+    #include "plibsys.h"
+
+    #include "queue.h"
+
+    /**
+     * A batch of samples stored column by column. A sens_sample_t takes 24 bytes
+     * with padding while a sample takes 23 bytes of columns here, and each column
+     * is a dense array the vector kernels can run over.
+     */
+    typedef struct sample_batch_t
+    {
+        psize    len;      // The number of samples
+        psize    max_len;  // The number of samples the columns have room for
+        puint8*  ids;      // The sensor IDs
+        puint16* absorbed; // The numbers of samples absorbed by coalescing before each sample
+        puint32* vals;     // The sample values
+        psize*   nums;     // The sample numbers
+        puint64* ts;       // The collection times in microseconds, 0 if unknown
+    }sample_batch;
+
+    /**
+     * Batch constructor. The batch starts empty.
+     * @param max_len: The number of samples the batch can hold.
+     * @returns: A pointer to the batch if successful, NULL otherwise.
+     */
+    struct sample_batch_t*
+    sample_batch_create(const psize max_len);
+
+    /**
+     * Batch destructor.
+     * @param self: A pointer to the batch instance.
+     */
+    void
+    sample_batch_destroy(struct sample_batch_t* const self);
+
+    /**
+     * Remove every sample from the batch.
+     * @param self: A pointer to the batch instance.
+     */
+    void
+    sample_batch_clear(struct sample_batch_t* const self);
+
+    /**
+     * Append samples to the batch, splitting their fields into the columns.
+     * @param self: A pointer to the batch instance.
+     * @param samples: The samples, as stored in the queue.
+     * @param count: The number of samples.
+     * @returns: The number of samples appended, less than count if the batch is full.
+     */
+    psize
+    sample_batch_pack(      struct sample_batch_t* const self,
+                      const struct sens_sample_t*  const samples,
+                      const psize                        count);
+
+    /**
+     * Rebuild samples from the columns of the batch.
+     * @param self: A pointer to the batch instance.
+     * @param first: The index of the first sample.
+     * @param count: The number of samples.
+     * @param samples: Where to store the samples.
+     * @returns: The number of samples stored, less than count past the end of the batch.
+     */
+    psize
+    sample_batch_unpack(const struct sample_batch_t* const self,
+                        const psize                        first,
+                        const psize                        count,
+                              struct sens_sample_t*  const samples);
+
+    /**
+     * Copy the values of the samples of a sensor, in batch order.
+     * @param self: A pointer to the batch instance.
+     * @param sens_id: The sensor ID.
+     * @param vals: Where to store the values, room for the batch length is required.
+     * @returns: The number of values stored.
+     */
+    psize
+    sample_batch_gather(const struct sample_batch_t* const self,
+                        const puint8                       sens_id,
+                              puint32*               const vals);
+
+#endif // _SAMPLE_BATCH_H_INCLUDED
@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sample_coalesce.h"
+
+#define SAMPLE_COALESCE_MAX_SENSORS 256 // every value of sens_sample_t.sens_id
+
+struct sample_coalesce_sens_t
+{
+    sample_coalesce_policy policy;
+    psize                  window;
+
+    // current window
+    psize                  count;
+    sens_sample            last;
+    puint32                min_val;
+    puint32                max_val;
+    puint64                sum_val;
+
+    psize                  num_fed;
+    psize                  num_queued;
+    psize                  num_unqueued; // fed since the last queued sample
+};
+
+struct sample_coalesce_t
+{
+    struct sample_coalesce_sens_t sens[SAMPLE_COALESCE_MAX_SENSORS];
+
+    PMutex*                       mutex;
+};
+
+/**
+ * Count a sample as queued and tell the consumer how many samples right before
+ * it were absorbed, so their numbers are not taken for lost samples.
+ */
+static void
+sample_coalesce_mark_queued(struct sample_coalesce_sens_t* const sens,
+                            struct sens_sample_t*          const out)
+{
+    // only a discarded window on a policy change can take it past a full window
+    out->num_absorbed = (sens->num_unqueued - 1 < P_MAXUINT16) ? (puint16) (sens->num_unqueued - 1)
+                                                               : P_MAXUINT16;
+
+    sens->num_unqueued = 0;
+    sens->num_queued++;
+}
+
+static pboolean
+sample_coalesce_close_window(struct sample_coalesce_sens_t* const sens,
+                             struct sens_sample_t*          const out)
+{
+    if (0 == sens->count) {
+        return FALSE;
+    }
+
+    if (SAMPLE_COALESCE_EVERY_NTH == sens->policy)
+    {
+        // the first sample of the window was queued when it was fed
+        sens->count = 0;
+        return FALSE;
+    }
+
+    *out = sens->last;
+
+    switch (sens->policy) {
+    case SAMPLE_COALESCE_MIN:
+        out->val = sens->min_val;
+        break;
+
+    case SAMPLE_COALESCE_MAX:
+        out->val = sens->max_val;
+        break;
+
+    case SAMPLE_COALESCE_MEAN:
+        out->val = (puint32) (sens->sum_val / sens->count);
+        break;
+
+    default:
+        break;
+    }
+
+    sens->count = 0;
+    sample_coalesce_mark_queued(sens, out);
+
+    return TRUE;
+}
+
+struct sample_coalesce_t*
+sample_coalesce_create(void)
+{
+    struct sample_coalesce_t* self = NULL;
+
+    do
+    {
+        self = p_malloc0(sizeof(struct sample_coalesce_t));
+
+        if (NULL == self)
+        {
+            printf("!!! not enough memory to create a coalescing stage !!!\n");
+            break;
+        }
+
+        for (psize sens_id = 0;
+                   sens_id < SAMPLE_COALESCE_MAX_SENSORS;
+                   sens_id++)
+        {
+            self->sens[sens_id].policy = SAMPLE_COALESCE_NONE;
+            self->sens[sens_id].window = 1;
+        }
+
+        self->mutex = p_mutex_new();
+
+        if (NULL == self->mutex)
+        {
+            printf("!!! not enough memory to create a mutex !!!\n");
+            sample_coalesce_destroy(self);
+            self = NULL;
+            break;
+        }
+
+    } while (0);
+
+    return self;
+}
+
+void
+sample_coalesce_destroy(struct sample_coalesce_t* const self)
+{
+    if (NULL == self) {
+        return;
+    }
+
+    if (NULL != self->mutex)
+    {
+        p_mutex_free(self->mutex);
+        self->mutex = NULL;
+    }
+
+    p_free(self);
+}
+
+pboolean
+sample_coalesce_set_policy(      struct sample_coalesce_t* const self,
+                           const puint8                          sens_id,
+                           const sample_coalesce_policy          policy,
+                           const psize                           window)
+{
+    if ((SAMPLE_COALESCE_NONE != policy) &&
+        ((0 == window) || (SAMPLE_COALESCE_MAX_WINDOW < window)))
+    {
+        return FALSE;
+    }
+
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the coalescing stage !!!\n");
+        return FALSE;
+    }
+
+    struct sample_coalesce_sens_t* const sens = &self->sens[sens_id];
+
+    // samples of the discarded window count as absorbed, before the next queued one
+    sens->policy = policy;
+    sens->window = (SAMPLE_COALESCE_NONE == policy) ? 1 : window;
+    sens->count  = 0;
+
+    p_mutex_unlock(self->mutex);
+
+    return TRUE;
+}
+
+pboolean
+sample_coalesce_configure(      struct sample_coalesce_t* const self,
+                          const pchar*                    const spec)
+{
+    static const struct
+    {
+        const pchar*           name;
+        sample_coalesce_policy policy;
+    } names[] = {
+        { "none", SAMPLE_COALESCE_NONE      },
+        { "last", SAMPLE_COALESCE_LAST      },
+        { "min",  SAMPLE_COALESCE_MIN       },
+        { "max",  SAMPLE_COALESCE_MAX       },
+        { "mean", SAMPLE_COALESCE_MEAN      },
+        { "nth",  SAMPLE_COALESCE_EVERY_NTH }
+    };
+
+    pboolean     is_ok = TRUE;
+    const pchar* entry = spec;
+
+    while (is_ok && ('\0' != *entry))
+    {
+        pchar         name[8];
+        unsigned int  sens_id;
+        unsigned long window;
+        int           len = 0;
+
+        if ((3 != sscanf(entry, "%u:%7[a-z]:%lu%n", &sens_id, name, &window, &len)) ||
+            (SAMPLE_COALESCE_MAX_SENSORS <= sens_id))
+        {
+            printf("!!! invalid coalescing policy %s !!!\n", entry);
+            return FALSE;
+        }
+
+        psize idx = 0;
+
+        while ((idx < sizeof(names) / sizeof(names[0])) &&
+               (0 != strcmp(names[idx].name, name)))
+        {
+            idx++;
+        }
+
+        if (idx == sizeof(names) / sizeof(names[0]))
+        {
+            printf("!!! unknown coalescing policy %s !!!\n", name);
+            return FALSE;
+        }
+
+        is_ok = sample_coalesce_set_policy(self, (puint8) sens_id, names[idx].policy, (psize) window);
+
+        entry += len;
+
+        if (',' == *entry) {
+            entry++;
+        }
+    }
+
+    return is_ok;
+}
+
+pboolean
+sample_coalesce_feed(      struct sample_coalesce_t* const self,
+                     const struct sens_sample_t            sample,
+                           struct sens_sample_t*     const out)
+{
+    pboolean is_queued = FALSE;
+
+    if (!p_mutex_lock(self->mutex))
+    {
+        // better queued as is than lost
+        printf("!!! failed to lock the coalescing stage !!!\n");
+        *out = sample;
+        return TRUE;
+    }
+
+    struct sample_coalesce_sens_t* const sens = &self->sens[sample.sens_id];
+
+    sens->num_fed++;
+    sens->num_unqueued++;
+
+    if (0 == sens->count)
+    {
+        sens->min_val = sample.val;
+        sens->max_val = sample.val;
+        sens->sum_val = 0;
+    }
+
+    sens->last     = sample;
+    sens->sum_val += sample.val;
+
+    if (sample.val < sens->min_val) {
+        sens->min_val = sample.val;
+    }
+
+    if (sample.val > sens->max_val) {
+        sens->max_val = sample.val;
+    }
+
+    if (SAMPLE_COALESCE_EVERY_NTH == sens->policy)
+    {
+        // queue the first sample of the window right away so it is not stale
+        if (1 == ++sens->count)
+        {
+            *out = sample;
+            sample_coalesce_mark_queued(sens, out);
+            is_queued = TRUE;
+        }
+
+        if (sens->count == sens->window) {
+            sens->count = 0;
+        }
+    }
+    else if (++sens->count == sens->window)
+    {
+        is_queued = sample_coalesce_close_window(sens, out);
+    }
+
+    p_mutex_unlock(self->mutex);
+
+    return is_queued;
+}
+
+pboolean
+sample_coalesce_flush(      struct sample_coalesce_t* const self,
+                      const puint8                          sens_id,
+                            struct sens_sample_t*     const out)
+{
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the coalescing stage !!!\n");
+        return FALSE;
+    }
+
+    const pboolean is_queued = sample_coalesce_close_window(&self->sens[sens_id], out);
+
+    p_mutex_unlock(self->mutex);
+
+    return is_queued;
+}
+
+psize
+sample_coalesce_get_absorbed(      struct sample_coalesce_t* const self,
+                             const puint8                          sens_id)
+{
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the coalescing stage !!!\n");
+        return 0;
+    }
+
+    const struct sample_coalesce_sens_t* const sens = &self->sens[sens_id];
+    // the open window of SAMPLE_COALESCE_EVERY_NTH has been queued or absorbed already
+    const psize open     = (SAMPLE_COALESCE_EVERY_NTH == sens->policy) ? 0 : sens->count;
+    const psize absorbed = sens->num_fed - sens->num_queued - open;
+
+    p_mutex_unlock(self->mutex);
+
+    return absorbed;
+}
@@ -0,0 +1,110 @@
+#ifndef _SAMPLE_COALESCE_H_INCLUDED
+    #define _SAMPLE_COALESCE_H_INCLUDED
+
+    #include "plibsys.h"
+
+    #include "queue.h"
+
+    /**
+     * How the samples of a sensor are reduced before they reach the queue. Except
+     * for SAMPLE_COALESCE_NONE, every window of samples produces a single sample.
+     * SAMPLE_COALESCE_EVERY_NTH queues the first sample of the window as soon as it
+     * is fed, the other policies queue a sample carrying the number of the last
+     * sample of the window once the window is full. Either way the queued sample
+     * tells in num_absorbed how many samples right before it were absorbed.
+     */
+    typedef enum sample_coalesce_policy_t
+    {
+        SAMPLE_COALESCE_NONE,     // Every sample is queued
+        SAMPLE_COALESCE_LAST,     // The last value of the window wins
+        SAMPLE_COALESCE_MIN,      // The smallest value of the window
+        SAMPLE_COALESCE_MAX,      // The largest value of the window
+        SAMPLE_COALESCE_MEAN,     // The mean value of the window
+        SAMPLE_COALESCE_EVERY_NTH // The first sample of the window, the others are skipped
+    }sample_coalesce_policy;
+
+    /**
+     * Largest window, so the samples absorbed before a queued sample can always be
+     * told in sens_sample_t.num_absorbed.
+     */
+    #define SAMPLE_COALESCE_MAX_WINDOW 65536
+
+    struct sample_coalesce_t;
+
+    /**
+     * Coalescing stage constructor. All sensors start with SAMPLE_COALESCE_NONE.
+     * @returns: A pointer to the stage if successful, NULL otherwise.
+     */
+    struct sample_coalesce_t*
+    sample_coalesce_create(void);
+
+    /**
+     * Coalescing stage destructor.
+     * @param self: A pointer to the stage instance.
+     */
+    void
+    sample_coalesce_destroy(struct sample_coalesce_t* const self);
+
+    /**
+     * Change the policy of a sensor. It may be called while samples are fed from
+     * another thread; a partially filled window is discarded.
+     * @param self: A pointer to the stage instance.
+     * @param sens_id: The sensor ID.
+     * @param policy: The policy.
+     * @param window: The number of samples per window, ignored for SAMPLE_COALESCE_NONE.
+     * @returns: TRUE if successful, FALSE if the window is 0 or above
+     *           SAMPLE_COALESCE_MAX_WINDOW.
+     */
+    pboolean
+    sample_coalesce_set_policy(      struct sample_coalesce_t* const self,
+                               const puint8                          sens_id,
+                               const sample_coalesce_policy          policy,
+                               const psize                           window);
+
+    /**
+     * Set policies from a comma-separated list of sens_id:policy:window entries,
+     * where the policy is one of none, last, min, max, mean or nth, for example
+     * "1:mean:10,3:nth:4".
+     * @param self: A pointer to the stage instance.
+     * @param spec: The list of policies.
+     * @returns: TRUE if every entry was applied, FALSE otherwise.
+     */
+    pboolean
+    sample_coalesce_configure(      struct sample_coalesce_t* const self,
+                              const pchar*                    const spec);
+
+    /**
+     * Feed a collected sample to the stage.
+     * @param self: A pointer to the stage instance.
+     * @param sample: The collected sample.
+     * @param out: Where to store the sample to queue.
+     * @returns: TRUE if a sample has to be queued, FALSE if the sample was absorbed.
+     */
+    pboolean
+    sample_coalesce_feed(      struct sample_coalesce_t* const self,
+                         const struct sens_sample_t            sample,
+                               struct sens_sample_t*     const out);
+
+    /**
+     * Close the partially filled window of a sensor.
+     * @param self: A pointer to the stage instance.
+     * @param sens_id: The sensor ID.
+     * @param out: Where to store the sample to queue.
+     * @returns: TRUE if a sample has to be queued, FALSE if the window was empty.
+     */
+    pboolean
+    sample_coalesce_flush(      struct sample_coalesce_t* const self,
+                          const puint8                          sens_id,
+                                struct sens_sample_t*     const out);
+
+    /**
+     * Get the number of samples of a sensor absorbed by the stage, that is fed
+     * but not turned into a queued sample.
+     * @param self: A pointer to the stage instance.
+     * @param sens_id: The sensor ID.
+     */
+    psize
+    sample_coalesce_get_absorbed(      struct sample_coalesce_t* const self,
+                                 const puint8                          sens_id);
+
+#endif // _SAMPLE_COALESCE_H_INCLUDED
@@ -0,0 +1,464 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sample_index.h"
+
+#define SAMPLE_INDEX_TS_MASK 0x00FFFFFFFFFFFFFFULL
+
+struct sample_index_block_t
+{
+    psize                  count;
+    puint64                keys[SAMPLE_INDEX_BLOCK_LEN];    // searched apart from the records
+    struct sample_record_t records[SAMPLE_INDEX_BLOCK_LEN];
+};
+
+struct sample_index_t
+{
+    struct sample_index_block_t** blocks;
+    puint64*                      fences;     // the first key of every block
+    psize                         num_blocks;
+    psize                         max_blocks;
+    psize                         count;
+};
+
+struct sample_index_order_t
+{
+    puint64 key;
+    psize   idx;
+};
+
+/**
+ * Build the key of a record, the sensor ID in the top byte and the collection
+ * time below it, so that the records of a sensor are contiguous.
+ */
+static puint64
+sample_index_key(const puint8  sens_id,
+                 const puint64 ts)
+{
+    return ((puint64) sens_id << 56) | (ts & SAMPLE_INDEX_TS_MASK);
+}
+
+/**
+ * @returns: The position of the first key above the given one.
+ */
+static psize
+sample_index_upper_bound(const puint64* const keys,
+                         const psize          count,
+                         const puint64        key)
+{
+    psize low  = 0;
+    psize high = count;
+
+    while (low < high)
+    {
+        const psize mid = low + (high - low) / 2;
+
+        if (keys[mid] <= key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * @returns: The position of the first key not below the given one.
+ */
+static psize
+sample_index_lower_bound(const puint64* const keys,
+                         const psize          count,
+                         const puint64        key)
+{
+    psize low  = 0;
+    psize high = count;
+
+    while (low < high)
+    {
+        const psize mid = low + (high - low) / 2;
+
+        if (keys[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * Add an empty block at the given position of the block list.
+ * @returns: The block, NULL if out of memory
+ */
+static struct sample_index_block_t*
+sample_index_add_block(      struct sample_index_t* const self,
+                       const psize                        pos)
+{
+    if (self->num_blocks == self->max_blocks)
+    {
+        const psize max_blocks = (0 == self->max_blocks) ? 16 : self->max_blocks * 2;
+
+        struct sample_index_block_t** const blocks = p_realloc(self->blocks,
+                                                               sizeof(struct sample_index_block_t*) * max_blocks);
+
+        if (NULL == blocks) {
+            return NULL;
+        }
+
+        self->blocks = blocks;
+
+        puint64* const fences = p_realloc(self->fences, sizeof(puint64) * max_blocks);
+
+        if (NULL == fences) {
+            return NULL;
+        }
+
+        self->fences     = fences;
+        self->max_blocks = max_blocks;
+    }
+
+    struct sample_index_block_t* const block = p_malloc(sizeof(struct sample_index_block_t));
+
+    if (NULL == block) {
+        return NULL;
+    }
+
+    block->count = 0;
+
+    memmove(&self->blocks[pos + 1],
+            &self->blocks[pos],
+            sizeof(struct sample_index_block_t*) * (self->num_blocks - pos));
+    memmove(&self->fences[pos + 1],
+            &self->fences[pos],
+            sizeof(puint64) * (self->num_blocks - pos));
+
+    self->blocks[pos] = block;
+    self->fences[pos] = 0;
+    self->num_blocks++;
+
+    return block;
+}
+
+static int
+sample_index_order_compare(const void* const left,
+                           const void* const right)
+{
+    const struct sample_index_order_t* const lhs = left;
+    const struct sample_index_order_t* const rhs = right;
+
+    if (lhs->key != rhs->key) {
+        return (lhs->key < rhs->key) ? -1 : 1;
+    }
+
+    // equal keys keep their input order
+    return (lhs->idx < rhs->idx) ? -1 : (lhs->idx > rhs->idx);
+}
+
+struct sample_index_t*
+sample_index_create(void)
+{
+    struct sample_index_t* const self = p_malloc0(sizeof(struct sample_index_t));
+
+    if (NULL == self) {
+        printf("!!! not enough memory to create a sample index !!!\n");
+    }
+
+    return self;
+}
+
+void
+sample_index_destroy(struct sample_index_t* const self)
+{
+    if (NULL == self) {
+        return;
+    }
+
+    for (psize idx = 0;
+               idx < self->num_blocks;
+               idx++)
+    {
+        p_free(self->blocks[idx]);
+    }
+
+    if (NULL != self->blocks)
+    {
+        p_free(self->blocks);
+        self->blocks = NULL;
+    }
+
+    if (NULL != self->fences)
+    {
+        p_free(self->fences);
+        self->fences = NULL;
+    }
+
+    p_free(self);
+}
+
+pboolean
+sample_index_insert(      struct sample_index_t*  const self,
+                    const struct sample_record_t* const record)
+{
+    const puint64 key = sample_index_key(record->sample.sens_id, record->ts);
+
+    if ((0 == self->num_blocks) &&
+        (NULL == sample_index_add_block(self, 0)))
+    {
+        return FALSE;
+    }
+
+    // the last block starting at or below the key, so equal keys stay in order
+    psize block_idx = sample_index_upper_bound(self->fences, self->num_blocks, key);
+
+    if (0 < block_idx) {
+        block_idx--;
+    }
+
+    struct sample_index_block_t* block = self->blocks[block_idx];
+    psize pos = sample_index_upper_bound(block->keys, block->count, key);
+
+    if (SAMPLE_INDEX_BLOCK_LEN == block->count)
+    {
+        struct sample_index_block_t* const next = sample_index_add_block(self, block_idx + 1);
+
+        if (NULL == next) {
+            return FALSE;
+        }
+
+        if ((SAMPLE_INDEX_BLOCK_LEN == pos) &&
+            (block_idx + 2 == self->num_blocks))
+        {
+            // appending in order leaves full blocks behind
+            block = next;
+            pos   = 0;
+        }
+        else
+        {
+            const psize half = SAMPLE_INDEX_BLOCK_LEN / 2;
+
+            memcpy(next->keys, &block->keys[half], sizeof(puint64) * half);
+            memcpy(next->records, &block->records[half], sizeof(struct sample_record_t) * half);
+            next->count  = half;
+            block->count = half;
+
+            self->fences[block_idx + 1] = next->keys[0];
+
+            if (pos > half)
+            {
+                block = next;
+                pos  -= half;
+            }
+        }
+
+        block_idx = (block == next) ? block_idx + 1 : block_idx;
+    }
+
+    memmove(&block->keys[pos + 1],
+            &block->keys[pos],
+            sizeof(puint64) * (block->count - pos));
+    memmove(&block->records[pos + 1],
+            &block->records[pos],
+            sizeof(struct sample_record_t) * (block->count - pos));
+
+    block->keys[pos]    = key;
+    block->records[pos] = *record;
+    block->count++;
+
+    self->fences[block_idx] = block->keys[0];
+    self->count++;
+
+    return TRUE;
+}
+
+pboolean
+sample_index_bulk_load(      struct sample_index_t*  const self,
+                       const struct sample_record_t* const records,
+                       const psize                         count)
+{
+    if (0 < self->count)
+    {
+        for (psize idx = 0;
+                   idx < count;
+                   idx++)
+        {
+            if (!sample_index_insert(self, &records[idx])) {
+                return FALSE;
+            }
+        }
+
+        return TRUE;
+    }
+
+    if (0 == count) {
+        return TRUE;
+    }
+
+    struct sample_index_order_t* const order = p_malloc(sizeof(struct sample_index_order_t) * count);
+
+    if (NULL == order)
+    {
+        printf("!!! not enough memory to sort %lu samples !!!\n", count);
+        return FALSE;
+    }
+
+    for (psize idx = 0;
+               idx < count;
+               idx++)
+    {
+        order[idx].key = sample_index_key(records[idx].sample.sens_id, records[idx].ts);
+        order[idx].idx = idx;
+    }
+
+    qsort(order, count, sizeof(struct sample_index_order_t), sample_index_order_compare);
+
+    pboolean is_ok = TRUE;
+    struct sample_index_block_t* block = NULL;
+
+    for (psize idx = 0;
+               is_ok && (idx < count);
+               idx++)
+    {
+        if ((NULL == block) ||
+            (SAMPLE_INDEX_BLOCK_LEN == block->count))
+        {
+            block = sample_index_add_block(self, self->num_blocks);
+            is_ok = (NULL != block);
+
+            if (!is_ok) {
+                break;
+            }
+
+            self->fences[self->num_blocks - 1] = order[idx].key;
+        }
+
+        block->keys[block->count]    = order[idx].key;
+        block->records[block->count] = records[order[idx].idx];
+        block->count++;
+        self->count++;
+    }
+
+    p_free(order);
+
+    return is_ok;
+}
+
+pboolean
+sample_index_load_archive(      struct sample_index_t*   const self,
+                          const struct sample_archive_t* const archive,
+                          const puint8                         sens_id)
+{
+    struct sample_archive_block_t block;
+    psize num_records = 0;
+
+    for (psize idx = 0;
+               sample_archive_block_info(archive, idx, &block);
+               idx++)
+    {
+        if ((0 == sens_id) || (block.sens_id == sens_id)) {
+            num_records += block.count;
+        }
+    }
+
+    if (0 == num_records) {
+        return TRUE;
+    }
+
+    struct sample_record_t* const records = p_malloc(sizeof(struct sample_record_t) * num_records);
+
+    if (NULL == records)
+    {
+        printf("!!! not enough memory to load %lu samples !!!\n", num_records);
+        return FALSE;
+    }
+
+    pboolean is_ok = TRUE;
+    psize loaded = 0;
+
+    for (psize idx = 0;
+               is_ok && sample_archive_block_info(archive, idx, &block);
+               idx++)
+    {
+        if ((0 != sens_id) && (block.sens_id != sens_id)) {
+            continue;
+        }
+
+        is_ok = (block.count == sample_archive_decode_block(archive, idx, records + loaded));
+        loaded += block.count;
+    }
+
+    if (is_ok) {
+        is_ok = sample_index_bulk_load(self, records, num_records);
+    }
+
+    p_free(records);
+
+    return is_ok;
+}
+
+psize
+sample_index_count(const struct sample_index_t* const self)
+{
+    return self->count;
+}
+
+psize
+sample_index_range(const struct sample_index_t* const self,
+                   const puint8                       sens_id,
+                   const puint64                      from_ts,
+                   const puint64                      to_ts,
+                   const sample_index_func            func,
+                         ppointer                     data)
+{
+    if ((0 == self->num_blocks) ||
+        (from_ts > to_ts) ||
+        (from_ts > SAMPLE_INDEX_TS_MASK))
+    {
+        return 0;
+    }
+
+    const puint64 from_key = sample_index_key(sens_id, from_ts);
+    const puint64 to_key   = sample_index_key(sens_id, (to_ts < SAMPLE_INDEX_TS_MASK) ? to_ts : SAMPLE_INDEX_TS_MASK);
+
+    // equal keys may spill over from the block before the first fence not below
+    psize block_idx = sample_index_lower_bound(self->fences, self->num_blocks, from_key);
+
+    if (0 < block_idx) {
+        block_idx--;
+    }
+
+    const struct sample_index_block_t* block = self->blocks[block_idx];
+    psize pos = sample_index_lower_bound(block->keys, block->count, from_key);
+    psize num_visited = 0;
+
+    while (TRUE)
+    {
+        if (pos == block->count)
+        {
+            if (++block_idx == self->num_blocks) {
+                break;
+            }
+
+            block = self->blocks[block_idx];
+            pos   = 0;
+        }
+
+        if (block->keys[pos] > to_key) {
+            break;
+        }
+
+        num_visited++;
+
+        if ((NULL != func) &&
+            !func(&block->records[pos], data))
+        {
+            break;
+        }
+
+        pos++;
+    }
+
+    return num_visited;
+}
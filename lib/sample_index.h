@@ -0,0 +1,103 @@
+#ifndef _SAMPLE_INDEX_H_INCLUDED
+    #define _SAMPLE_INDEX_H_INCLUDED
+
+    #include "plibsys.h"
+
+    #include "sample_archive.h"
+
+    /**
+     * Number of records per block of the index, 4 KB of records.
+     */
+    #define SAMPLE_INDEX_BLOCK_LEN 128
+
+    struct sample_index_t;
+
+    /**
+     * Called for every record of a range, in (sensor ID, collection time) order.
+     * @param record: The record.
+     * @param data: The data given to sample_index_range().
+     * @returns: TRUE to go on, FALSE to stop.
+     */
+    typedef pboolean (*sample_index_func)(const struct sample_record_t* const record,
+                                                ppointer                      data);
+
+    /**
+     * Ordered index of sample records by sensor ID and collection time.
+     * Records are kept by value in sorted blocks of SAMPLE_INDEX_BLOCK_LEN, with
+     * the first key of every block in a separate array, so a lookup is two binary
+     * searches over contiguous memory and a range is a sequential scan, instead
+     * of a pointer chase through one allocation per record as with PTree.
+     * Records with the same key are kept in insertion order.
+     * @returns: A pointer to the index if successful, NULL otherwise.
+     */
+    struct sample_index_t*
+    sample_index_create(void);
+
+    /**
+     * Sample index destructor.
+     * @param self: A pointer to the index instance.
+     */
+    void
+    sample_index_destroy(struct sample_index_t* const self);
+
+    /**
+     * Add a record.
+     * @param self: A pointer to the index instance.
+     * @param record: The record, copied into the index.
+     * @returns: TRUE if successful, FALSE if out of memory.
+     */
+    pboolean
+    sample_index_insert(      struct sample_index_t*  const self,
+                        const struct sample_record_t* const record);
+
+    /**
+     * Add many records at once. Into an empty index the records are sorted and
+     * packed into full blocks, otherwise they are inserted one by one.
+     * @param self: A pointer to the index instance.
+     * @param records: The records, in any order.
+     * @param count: The number of records.
+     * @returns: TRUE if successful, FALSE if out of memory.
+     */
+    pboolean
+    sample_index_bulk_load(      struct sample_index_t*  const self,
+                           const struct sample_record_t* const records,
+                           const psize                         count);
+
+    /**
+     * Bulk load the records of an archive.
+     * @param self: A pointer to the index instance.
+     * @param archive: The archive.
+     * @param sens_id: The sensor to load the records of, 0 for all of them.
+     * @returns: TRUE if successful, FALSE otherwise.
+     */
+    pboolean
+    sample_index_load_archive(      struct sample_index_t*   const self,
+                              const struct sample_archive_t* const archive,
+                              const puint8                         sens_id);
+
+    /**
+     * Get the number of records in the index.
+     * @param self: A pointer to the index instance.
+     */
+    psize
+    sample_index_count(const struct sample_index_t* const self);
+
+    /**
+     * Go through the records of a sensor collected within a time range.
+     * @param self: A pointer to the index instance.
+     * @param sens_id: The sensor ID.
+     * @param from_ts: The earliest collection time, included.
+     * @param to_ts: The latest collection time, included.
+     * @param func: The function to call for every record, NULL to only count them.
+     * @param data: The data to pass to func.
+     * @returns: The number of records func was called for.
+     */
+    psize
+    sample_index_range(const struct sample_index_t* const self,
+                       const puint8                       sens_id,
+                       const puint64                      from_ts,
+                       const puint64                      to_ts,
+                       const sample_index_func            func,
+                             ppointer                     data);
+
+#endif // _SAMPLE_INDEX_H_INCLUDED
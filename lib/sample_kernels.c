@@ -0,0 +1,340 @@
+#include <string.h>
+
+#include "sample_kernels.h"
+
+#if defined(P_CC_GNU) && defined(P_CPU_X86)
+    // the vector kernels are compiled for their own target, the rest of the program is not
+    #include <immintrin.h>
+    #define SAMPLE_KERNELS_HAS_X86
+    #define SAMPLE_KERNELS_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+struct sample_kernels_impl_t
+{
+    puint64 (*sum)(const puint32* const vals,
+                   const psize          count);
+    psize   (*count_above)(const puint32* const vals,
+                           const psize          count,
+                           const puint32        threshold);
+    void    (*scale)(const puint32* const vals,
+                     const psize          count,
+                     const pfloat         scale,
+                     const pfloat         offset,
+                           pfloat*  const out);
+};
+
+static puint64
+sample_kernels_sum_scalar(const puint32* const vals,
+                          const psize          count)
+{
+    puint64 sum = 0;
+
+    for (psize idx = 0;
+               idx < count;
+               idx++)
+    {
+        sum += vals[idx];
+    }
+
+    return sum;
+}
+
+static psize
+sample_kernels_count_above_scalar(const puint32* const vals,
+                                  const psize          count,
+                                  const puint32        threshold)
+{
+    psize num_above = 0;
+
+    for (psize idx = 0;
+               idx < count;
+               idx++)
+    {
+        num_above += (vals[idx] > threshold);
+    }
+
+    return num_above;
+}
+
+static void
+sample_kernels_scale_scalar(const puint32* const vals,
+                            const psize          count,
+                            const pfloat         scale,
+                            const pfloat         offset,
+                                  pfloat*  const out)
+{
+    for (psize idx = 0;
+               idx < count;
+               idx++)
+    {
+        // no fused multiply-add, so every implementation rounds the same way
+        const pfloat scaled = (pfloat) vals[idx] * scale;
+
+        out[idx] = scaled + offset;
+    }
+}
+
+#ifdef SAMPLE_KERNELS_HAS_X86
+
+SAMPLE_KERNELS_TARGET("sse2")
+static puint64
+sample_kernels_sum_sse2(const puint32* const vals,
+                        const psize          count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i       acc  = _mm_setzero_si128();
+    psize         idx  = 0;
+
+    for (; idx + 4 <= count; idx += 4)
+    {
+        const __m128i val = _mm_loadu_si128((const __m128i*) &vals[idx]);
+
+        // widened to 64 bits, the sum of 32-bit values would overflow
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(val, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(val, zero));
+    }
+
+    puint64 lanes[2];
+    _mm_storeu_si128((__m128i*) lanes, acc);
+
+    return lanes[0] + lanes[1] + sample_kernels_sum_scalar(&vals[idx], count - idx);
+}
+
+SAMPLE_KERNELS_TARGET("sse2")
+static psize
+sample_kernels_count_above_sse2(const puint32* const vals,
+                                const psize          count,
+                                const puint32        threshold)
+{
+    // there is no unsigned comparison, flipping the sign bit turns it into a signed one
+    const __m128i sign  = _mm_set1_epi32((pint) 0x80000000U);
+    const __m128i limit = _mm_xor_si128(_mm_set1_epi32((pint) threshold), sign);
+    __m128i       acc   = _mm_setzero_si128();
+    psize         idx   = 0;
+
+    for (; idx + 4 <= count; idx += 4)
+    {
+        const __m128i val = _mm_xor_si128(_mm_loadu_si128((const __m128i*) &vals[idx]), sign);
+
+        // a lane of the comparison is -1 when true
+        acc = _mm_sub_epi32(acc, _mm_cmpgt_epi32(val, limit));
+    }
+
+    puint32 lanes[4];
+    _mm_storeu_si128((__m128i*) lanes, acc);
+
+    return (psize) lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           sample_kernels_count_above_scalar(&vals[idx], count - idx, threshold);
+}
+
+SAMPLE_KERNELS_TARGET("sse2")
+static void
+sample_kernels_scale_sse2(const puint32* const vals,
+                          const psize          count,
+                          const pfloat         scale,
+                          const pfloat         offset,
+                                pfloat*  const out)
+{
+    // there is no unsigned conversion, the 16-bit halves are converted exactly and
+    // added with a single rounding, as the scalar conversion does
+    const __m128i low_mask = _mm_set1_epi32(0xFFFF);
+    const __m128  high_mul = _mm_set1_ps(65536.0f);
+    const __m128  mul      = _mm_set1_ps(scale);
+    const __m128  add      = _mm_set1_ps(offset);
+    psize         idx      = 0;
+
+    for (; idx + 4 <= count; idx += 4)
+    {
+        const __m128i val  = _mm_loadu_si128((const __m128i*) &vals[idx]);
+        const __m128  high = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(val, 16)), high_mul);
+        const __m128  low  = _mm_cvtepi32_ps(_mm_and_si128(val, low_mask));
+
+        _mm_storeu_ps(&out[idx], _mm_add_ps(_mm_mul_ps(_mm_add_ps(high, low), mul), add));
+    }
+
+    sample_kernels_scale_scalar(&vals[idx], count - idx, scale, offset, &out[idx]);
+}
+
+SAMPLE_KERNELS_TARGET("avx2")
+static puint64
+sample_kernels_sum_avx2(const puint32* const vals,
+                        const psize          count)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i       acc  = _mm256_setzero_si256();
+    psize         idx  = 0;
+
+    for (; idx + 8 <= count; idx += 8)
+    {
+        const __m256i val = _mm256_loadu_si256((const __m256i*) &vals[idx]);
+
+        acc = _mm256_add_epi64(acc, _mm256_unpacklo_epi32(val, zero));
+        acc = _mm256_add_epi64(acc, _mm256_unpackhi_epi32(val, zero));
+    }
+
+    puint64 lanes[4];
+    _mm256_storeu_si256((__m256i*) lanes, acc);
+
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           sample_kernels_sum_scalar(&vals[idx], count - idx);
+}
+
+SAMPLE_KERNELS_TARGET("avx2")
+static psize
+sample_kernels_count_above_avx2(const puint32* const vals,
+                                const psize          count,
+                                const puint32        threshold)
+{
+    const __m256i sign  = _mm256_set1_epi32((pint) 0x80000000U);
+    const __m256i limit = _mm256_xor_si256(_mm256_set1_epi32((pint) threshold), sign);
+    __m256i       acc   = _mm256_setzero_si256();
+    psize         idx   = 0;
+
+    for (; idx + 8 <= count; idx += 8)
+    {
+        const __m256i val = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*) &vals[idx]), sign);
+
+        acc = _mm256_sub_epi32(acc, _mm256_cmpgt_epi32(val, limit));
+    }
+
+    puint32 lanes[8];
+    _mm256_storeu_si256((__m256i*) lanes, acc);
+
+    psize num_above = 0;
+
+    for (psize lane = 0;
+               lane < 8;
+               lane++)
+    {
+        num_above += lanes[lane];
+    }
+
+    return num_above + sample_kernels_count_above_scalar(&vals[idx], count - idx, threshold);
+}
+
+SAMPLE_KERNELS_TARGET("avx2")
+static void
+sample_kernels_scale_avx2(const puint32* const vals,
+                          const psize          count,
+                          const pfloat         scale,
+                          const pfloat         offset,
+                                pfloat*  const out)
+{
+    const __m256i low_mask = _mm256_set1_epi32(0xFFFF);
+    const __m256  high_mul = _mm256_set1_ps(65536.0f);
+    const __m256  mul      = _mm256_set1_ps(scale);
+    const __m256  add      = _mm256_set1_ps(offset);
+    psize         idx      = 0;
+
+    for (; idx + 8 <= count; idx += 8)
+    {
+        const __m256i val  = _mm256_loadu_si256((const __m256i*) &vals[idx]);
+        const __m256  high = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(val, 16)), high_mul);
+        const __m256  low  = _mm256_cvtepi32_ps(_mm256_and_si256(val, low_mask));
+
+        _mm256_storeu_ps(&out[idx], _mm256_add_ps(_mm256_mul_ps(_mm256_add_ps(high, low), mul), add));
+    }
+
+    sample_kernels_scale_scalar(&vals[idx], count - idx, scale, offset, &out[idx]);
+}
+
+#endif // SAMPLE_KERNELS_HAS_X86
+
+static const struct sample_kernels_impl_t sample_kernels_impls[] = {
+    { sample_kernels_sum_scalar, sample_kernels_count_above_scalar, sample_kernels_scale_scalar },
+#ifdef SAMPLE_KERNELS_HAS_X86
+    { sample_kernels_sum_sse2,   sample_kernels_count_above_sse2,   sample_kernels_scale_sse2   },
+    { sample_kernels_sum_avx2,   sample_kernels_count_above_avx2,   sample_kernels_scale_avx2   }
+#endif
+};
+
+static const pchar* const sample_kernels_names[] = { "scalar", "sse2", "avx2" };
+
+static sample_kernels_level                sample_kernels_level_in_use = SAMPLE_KERNELS_SCALAR;
+static const struct sample_kernels_impl_t* sample_kernels_impl         = &sample_kernels_impls[SAMPLE_KERNELS_SCALAR];
+
+sample_kernels_level
+sample_kernels_detect(void)
+{
+#ifdef SAMPLE_KERNELS_HAS_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) {
+        return SAMPLE_KERNELS_AVX2;
+    }
+
+    if (__builtin_cpu_supports("sse2")) {
+        return SAMPLE_KERNELS_SSE2;
+    }
+#endif
+
+    return SAMPLE_KERNELS_SCALAR;
+}
+
+pboolean
+sample_kernels_select(const sample_kernels_level level)
+{
+    if (level > sample_kernels_detect()) {
+        return FALSE;
+    }
+
+    sample_kernels_level_in_use = level;
+    sample_kernels_impl         = &sample_kernels_impls[level];
+
+    return TRUE;
+}
+
+sample_kernels_level
+sample_kernels_get_level(void)
+{
+    return sample_kernels_level_in_use;
+}
+
+const pchar*
+sample_kernels_level_name(const sample_kernels_level level)
+{
+    return sample_kernels_names[level];
+}
+
+pboolean
+sample_kernels_level_from_name(const pchar*                const name,
+                                     sample_kernels_level* const level)
+{
+    for (psize idx = 0;
+               idx < sizeof(sample_kernels_names) / sizeof(sample_kernels_names[0]);
+               idx++)
+    {
+        if (0 == strcmp(sample_kernels_names[idx], name))
+        {
+            *level = (sample_kernels_level) idx;
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+puint64
+sample_kernels_sum(const puint32* const vals,
+                   const psize          count)
+{
+    return sample_kernels_impl->sum(vals, count);
+}
+
+psize
+sample_kernels_count_above(const puint32* const vals,
+                           const psize          count,
+                           const puint32        threshold)
+{
+    return sample_kernels_impl->count_above(vals, count, threshold);
+}
+
+void
+sample_kernels_scale(const puint32* const vals,
+                     const psize          count,
+                     const pfloat         scale,
+                     const pfloat         offset,
+                           pfloat*  const out)
+{
+    sample_kernels_impl->scale(vals, count, scale, offset, out);
+}
@@ -0,0 +1,93 @@
+#ifndef _SAMPLE_KERNELS_H_INCLUDED
+    #define _SAMPLE_KERNELS_H_INCLUDED
+
+    #include "plibsys.h"
+
+    /**
+     * Instruction sets the kernels are implemented with.
+     */
+    typedef enum sample_kernels_level_t
+    {
+        SAMPLE_KERNELS_SCALAR, // Plain C, always available
+        SAMPLE_KERNELS_SSE2,   // 4 values per instruction
+        SAMPLE_KERNELS_AVX2    // 8 values per instruction
+    }sample_kernels_level;
+
+    /**
+     * Get the best instruction set supported by the CPU.
+     */
+    sample_kernels_level
+    sample_kernels_detect(void);
+
+    /**
+     * Choose the implementation of the kernels, SAMPLE_KERNELS_SCALAR until this
+     * is called. It must not be called while a kernel runs.
+     * @param level: The instruction set.
+     * @returns: TRUE if successful, FALSE if the CPU does not support it.
+     */
+    pboolean
+    sample_kernels_select(const sample_kernels_level level);
+
+    /**
+     * Get the instruction set of the kernels in use.
+     */
+    sample_kernels_level
+    sample_kernels_get_level(void);
+
+    /**
+     * Get the name of an instruction set.
+     * @param level: The instruction set.
+     * @returns: "scalar", "sse2" or "avx2".
+     */
+    const pchar*
+    sample_kernels_level_name(const sample_kernels_level level);
+
+    /**
+     * Find an instruction set by name.
+     * @param name: The name, as returned by sample_kernels_level_name().
+     * @param level: Where to store the instruction set.
+     * @returns: TRUE if successful, FALSE if the name is unknown.
+     */
+    pboolean
+    sample_kernels_level_from_name(const pchar*                const name,
+                                         sample_kernels_level* const level);
+
+    /**
+     * Add up sample values.
+     * @param vals: The values.
+     * @param count: The number of values.
+     * @returns: The sum.
+     */
+    puint64
+    sample_kernels_sum(const puint32* const vals,
+                       const psize          count);
+
+    /**
+     * Count the sample values above a threshold.
+     * @param vals: The values.
+     * @param count: The number of values.
+     * @param threshold: The threshold.
+     * @returns: The number of values greater than threshold.
+     */
+    psize
+    sample_kernels_count_above(const puint32* const vals,
+                               const psize          count,
+                               const puint32        threshold);
+
+    /**
+     * Convert sample values to floating point with a linear scale, out = val * scale + offset.
+     * The result does not depend on the instruction set.
+     * @param vals: The values.
+     * @param count: The number of values.
+     * @param scale: The factor.
+     * @param offset: The value added after scaling.
+     * @param out: Where to store the count results, may not overlap vals.
+     */
+    void
+    sample_kernels_scale(const puint32* const vals,
+                         const psize          count,
+                         const pfloat         scale,
+                         const pfloat         offset,
+                               pfloat*  const out);
+
+#endif // _SAMPLE_KERNELS_H_INCLUDED
@@ -0,0 +1,721 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sample_spill.h"
+
+#define SAMPLE_SPILL_MAGIC   0x53504350 // "PCPS"
+#define SAMPLE_SPILL_VERSION 2
+
+/**
+ * On-disk segment header. The cursors stored here are the committed ones, the
+ * records between next_out and next_in are replayed after a restart. The
+ * records are a ring: cursor c refers to record c % capacity, next_out is below
+ * capacity and next_in at most capacity records ahead of it.
+ */
+struct sample_spill_hdr_t
+{
+    puint32 magic;
+    puint32 version;
+    puint64 capacity;
+    puint64 next_in;
+    puint64 next_out;
+    puint8  reserved[32];
+};
+
+/**
+ * On-disk record, laid out explicitly so the segment does not depend on the
+ * padding of struct sens_sample_t.
+ */
+struct sample_spill_rec_t
+{
+    puint16 sens_id;
+    puint16 num_absorbed;
+    puint32 val;
+    puint64 num;
+};
+
+/**
+ * Record of a version 1 segment, of the same size as the current one, so the
+ * records of such a segment are converted in place.
+ */
+struct sample_spill_rec_v1_t
+{
+    puint32 sens_id;
+    puint32 val;
+    puint64 num;
+};
+
+struct sample_spill_t
+{
+    int                        fd;
+    puint8*                    map;
+    psize                      map_len;
+
+    struct sample_spill_hdr_t* hdr;
+    struct sample_spill_rec_t* recs;
+    psize                      capacity;
+    psize                      next_in;
+    psize                      next_out;
+
+    psize                      dirty_from; // cursor of the first record written since the last commit
+    psize                      uncommitted;
+
+    PMutex*                    mutex;        // guards the cursors, never held while writing to disk
+    PMutex*                    commit_mutex; // serializes the commits, taken before mutex
+
+    PCondVariable*             flush_cond;   // wakes the flusher up, with mutex
+    PUThread*                  flush_th;
+    pboolean                   is_closing;
+};
+
+static psize
+sample_spill_page_floor(psize offset)
+{
+    const psize page_size = (psize) sysconf(_SC_PAGESIZE);
+
+    return offset - (offset % page_size);
+}
+
+static struct sample_spill_rec_t*
+sample_spill_rec(const struct sample_spill_t* const self,
+                 const psize                        cursor)
+{
+    return &self->recs[cursor % self->capacity];
+}
+
+/**
+ * Flush the records between two cursors, in two parts if they wrap around.
+ * @returns: TRUE if successful, FALSE otherwise
+ */
+static pboolean
+sample_spill_flush_recs(const struct sample_spill_t* const self,
+                              psize                        from,
+                        const psize                        to)
+{
+    while (from < to)
+    {
+        const psize idx = from % self->capacity;
+        const psize len = (to - from < self->capacity - idx) ? to - from : self->capacity - idx;
+
+        const psize begin = sample_spill_page_floor(sizeof(struct sample_spill_hdr_t) +
+                                                    idx * sizeof(struct sample_spill_rec_t));
+        const psize end   = sizeof(struct sample_spill_hdr_t) +
+                            (idx + len) * sizeof(struct sample_spill_rec_t);
+
+        if (0 != msync(self->map + begin, end - begin, MS_SYNC))
+        {
+            printf("!!! failed to flush the spill records !!!\n");
+            return FALSE;
+        }
+
+        from += len;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Flush the records written since the last commit, then the cursors.
+ * Called with commit_mutex locked, or before the flusher starts. The cursors are only locked while they are
+ * read and written, appends and takes go on while the disk is written.
+ * @returns: TRUE if successful, FALSE otherwise
+ */
+static pboolean
+sample_spill_commit_locked(struct sample_spill_t* const self)
+{
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the spill segment !!!\n");
+        return FALSE;
+    }
+
+    // The records already taken again do not need to go out.
+    const psize from = (self->dirty_from > self->next_out) ? self->dirty_from : self->next_out;
+    const psize to   = self->next_in;
+
+    self->dirty_from  = to;
+    self->uncommitted = 0;
+
+    p_mutex_unlock(self->mutex);
+
+    // Records go out first so the header never points past unsynced data.
+    const pboolean is_flushed = sample_spill_flush_recs(self, from, to);
+
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the spill segment !!!\n");
+        return FALSE;
+    }
+
+    if (!is_flushed)
+    {
+        self->dirty_from = from;
+        p_mutex_unlock(self->mutex);
+        return FALSE;
+    }
+
+    // The records appended meanwhile are left to the next commit, but some of
+    // them may have been taken already.
+    const psize out = (self->next_out < to) ? self->next_out : to;
+
+    // Keep the cursors small, in whole turns of the ring.
+    const psize turns = out - out % self->capacity;
+
+    self->next_out   -= turns;
+    self->next_in    -= turns;
+    self->dirty_from -= turns;
+
+    self->hdr->next_in  = to - turns;
+    self->hdr->next_out = out - turns;
+
+    p_mutex_unlock(self->mutex);
+
+    if (0 != msync(self->map, sizeof(struct sample_spill_hdr_t), MS_SYNC))
+    {
+        printf("!!! failed to flush the spill header !!!\n");
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ * Commit whenever a group of records has been appended or taken, so the
+ * threads appending and taking never wait for the disk.
+ */
+static ppointer
+sample_spill_flush_task(ppointer arg)
+{
+    struct sample_spill_t* const self = (struct sample_spill_t*) arg;
+
+    while (TRUE)
+    {
+        if (!p_mutex_lock(self->mutex))
+        {
+            printf("!!! failed to lock the spill segment !!!\n");
+            break;
+        }
+
+        pboolean is_waited = TRUE;
+
+        while (!self->is_closing &&
+               (SAMPLE_SPILL_GROUP_COMMIT > self->uncommitted) &&
+               is_waited)
+        {
+            is_waited = p_cond_variable_wait(self->flush_cond, self->mutex);
+        }
+
+        const pboolean is_closing = self->is_closing;
+
+        p_mutex_unlock(self->mutex);
+
+        if (!is_waited) {
+            printf("!!! failed to wait for spill records, only committing on close !!!\n");
+        }
+
+        if (is_closing || !is_waited) {
+            break;
+        }
+
+        if (!p_mutex_lock(self->commit_mutex))
+        {
+            printf("!!! failed to lock the spill segment !!!\n");
+            break;
+        }
+
+        sample_spill_commit_locked(self);
+        p_mutex_unlock(self->commit_mutex);
+    }
+
+    return NULL;
+}
+
+/**
+ * Count an appended or taken record, waking the flusher up once a group of
+ * them is ready. Called with mutex locked.
+ */
+static void
+sample_spill_count_uncommitted(struct sample_spill_t* const self)
+{
+    self->uncommitted++;
+
+    if (SAMPLE_SPILL_GROUP_COMMIT == self->uncommitted) {
+        p_cond_variable_signal(self->flush_cond);
+    }
+}
+
+/**
+ * Convert the pending records of a version 1 segment, which have no
+ * num_absorbed, and commit the segment as the current version. A crash before
+ * the header is committed converts them again on the next open, which reads
+ * the already converted ones the same on a little-endian host.
+ * @returns: TRUE if successful, FALSE otherwise
+ */
+static pboolean
+sample_spill_migrate_v1(struct sample_spill_t* const self)
+{
+    for (psize idx = self->next_out;
+               idx < self->next_in;
+               idx++)
+    {
+        struct sample_spill_rec_t* const   rec    = sample_spill_rec(self, idx);
+        const struct sample_spill_rec_v1_t rec_v1 = *(const struct sample_spill_rec_v1_t*) rec;
+
+        rec->sens_id      = (puint16) rec_v1.sens_id;
+        rec->num_absorbed = 0;
+        rec->val          = rec_v1.val;
+        rec->num          = rec_v1.num;
+    }
+
+    // Rewrite the pending records, then the header with the new version.
+    self->dirty_from = self->next_out;
+
+    if (!sample_spill_commit_locked(self)) {
+        return FALSE;
+    }
+
+    self->hdr->version = SAMPLE_SPILL_VERSION;
+
+    if (0 != msync(self->map, sizeof(struct sample_spill_hdr_t), MS_SYNC))
+    {
+        printf("!!! failed to flush the spill header !!!\n");
+        return FALSE;
+    }
+
+    printf("### %ld spilled samples migrated from version 1 ###\n",
+           self->next_in - self->next_out);
+
+    return TRUE;
+}
+
+struct sample_spill_t*
+sample_spill_open(const pchar* const path,
+                  const psize        capacity)
+{
+    struct sample_spill_t* self = NULL;
+
+    do
+    {
+        self = p_malloc0(sizeof(struct sample_spill_t));
+
+        if (NULL == self)
+        {
+            printf("!!! not enough memory to create a spill segment !!!\n");
+            break;
+        }
+
+        self->fd           = -1;
+        self->mutex        = p_mutex_new();
+        self->commit_mutex = p_mutex_new();
+        self->flush_cond   = p_cond_variable_new();
+
+        if ((NULL == self->mutex) ||
+            (NULL == self->commit_mutex) ||
+            (NULL == self->flush_cond))
+        {
+            printf("!!! not enough memory to create the spill segment locks !!!\n");
+            sample_spill_close(self);
+            self = NULL;
+            break;
+        }
+
+        self->fd = open(path, O_RDWR | O_CREAT, 0644);
+
+        if (-1 == self->fd)
+        {
+            printf("!!! failed to open the spill segment %s !!!\n", path);
+            sample_spill_close(self);
+            self = NULL;
+            break;
+        }
+
+        struct stat st;
+
+        if (0 != fstat(self->fd, &st))
+        {
+            printf("!!! failed to stat the spill segment %s !!!\n", path);
+            sample_spill_close(self);
+            self = NULL;
+            break;
+        }
+
+        struct sample_spill_hdr_t hdr;
+        pboolean                  is_resumed = FALSE;
+
+        memset(&hdr, 0, sizeof(hdr));
+
+        if ((0 != st.st_size) &&
+            (((psize) st.st_size < sizeof(hdr)) ||
+             (sizeof(hdr) != (psize) pread(self->fd, &hdr, sizeof(hdr), 0))))
+        {
+            printf("!!! failed to read the spill segment header of %s !!!\n", path);
+            sample_spill_close(self);
+            self = NULL;
+            break;
+        }
+
+        // A zero header was never committed: the segment was being created.
+        if (0 != hdr.magic)
+        {
+            // Refuse rather than overwrite records that cannot be read back.
+            if (SAMPLE_SPILL_MAGIC != hdr.magic)
+            {
+                printf("!!! %s is not a spill segment !!!\n", path);
+                sample_spill_close(self);
+                self = NULL;
+                break;
+            }
+
+            if ((1 != hdr.version) &&
+                (SAMPLE_SPILL_VERSION != hdr.version))
+            {
+                printf("!!! spill segment %s has the unsupported version %u !!!\n", path, hdr.version);
+                sample_spill_close(self);
+                self = NULL;
+                break;
+            }
+
+            if (((psize) st.st_size != sizeof(hdr) + hdr.capacity * sizeof(struct sample_spill_rec_t)) ||
+                (hdr.next_out > hdr.capacity) ||
+                (hdr.next_out > hdr.next_in) ||
+                (hdr.next_in - hdr.next_out > hdr.capacity))
+            {
+                printf("!!! spill segment %s is corrupted !!!\n", path);
+                sample_spill_close(self);
+                self = NULL;
+                break;
+            }
+
+            is_resumed = TRUE;
+        }
+        else
+        {
+            memset(&hdr, 0, sizeof(hdr));
+            hdr.magic    = SAMPLE_SPILL_MAGIC;
+            hdr.version  = SAMPLE_SPILL_VERSION;
+            hdr.capacity = capacity;
+        }
+
+        self->capacity = (psize) hdr.capacity;
+        self->map_len  = sizeof(hdr) + self->capacity * sizeof(struct sample_spill_rec_t);
+
+        if (0 == self->capacity ||
+            (!is_resumed && 0 != ftruncate(self->fd, (off_t) self->map_len)))
+        {
+            printf("!!! failed to size the spill segment %s !!!\n", path);
+            sample_spill_close(self);
+            self = NULL;
+            break;
+        }
+
+        void* map = mmap(NULL,
+                         self->map_len,
+                         PROT_READ | PROT_WRITE,
+                         MAP_SHARED,
+                         self->fd,
+                         0);
+
+        if (MAP_FAILED == map)
+        {
+            printf("!!! failed to map the spill segment %s !!!\n", path);
+            sample_spill_close(self);
+            self = NULL;
+            break;
+        }
+
+        self->map  = (puint8*) map;
+        self->hdr  = (struct sample_spill_hdr_t*) self->map;
+        self->recs = (struct sample_spill_rec_t*) (self->map + sizeof(hdr));
+
+        // Records are written and replayed strictly front to back.
+        madvise(self->map, self->map_len, MADV_SEQUENTIAL);
+
+        if (!is_resumed) {
+            *self->hdr = hdr;
+        }
+
+        self->next_in    = (psize) self->hdr->next_in;
+        self->next_out   = (psize) self->hdr->next_out;
+        self->dirty_from = self->next_in;
+
+        if (is_resumed &&
+            (SAMPLE_SPILL_VERSION != self->hdr->version) &&
+            !sample_spill_migrate_v1(self))
+        {
+            printf("!!! failed to migrate the spill segment %s !!!\n", path);
+            sample_spill_close(self);
+            self = NULL;
+            break;
+        }
+
+        self->flush_th = p_uthread_create(sample_spill_flush_task, self, TRUE);
+
+        if (NULL == self->flush_th)
+        {
+            printf("!!! failed to start the spill flusher thread !!!\n");
+            sample_spill_close(self);
+            self = NULL;
+            break;
+        }
+
+        if (is_resumed)
+        {
+            printf("### %ld spilled samples will be replayed from %s ###\n",
+                   self->next_in - self->next_out,
+                   path);
+        }
+
+    } while (0);
+
+    return self;
+}
+
+void
+sample_spill_close(struct sample_spill_t* const self)
+{
+    if (NULL == self) {
+        return;
+    }
+
+    if (NULL != self->flush_th)
+    {
+        if (p_mutex_lock(self->mutex))
+        {
+            self->is_closing = TRUE;
+            p_cond_variable_signal(self->flush_cond);
+            p_mutex_unlock(self->mutex);
+        }
+        else
+        {
+            printf("!!! failed to lock the spill segment !!!\n");
+        }
+
+        p_uthread_join(self->flush_th);
+        p_uthread_unref(self->flush_th);
+        self->flush_th = NULL;
+    }
+
+    if (NULL != self->map)
+    {
+        sample_spill_commit_locked(self);
+        munmap(self->map, self->map_len);
+        self->map  = NULL;
+        self->hdr  = NULL;
+        self->recs = NULL;
+    }
+
+    if (-1 != self->fd) {
+        close(self->fd);
+    }
+
+    if (NULL != self->flush_cond)
+    {
+        p_cond_variable_free(self->flush_cond);
+        self->flush_cond = NULL;
+    }
+
+    if (NULL != self->commit_mutex)
+    {
+        p_mutex_free(self->commit_mutex);
+        self->commit_mutex = NULL;
+    }
+
+    if (NULL != self->mutex)
+    {
+        p_mutex_free(self->mutex);
+        self->mutex = NULL;
+    }
+
+    p_free(self);
+}
+
+pboolean
+sample_spill_append(      struct sample_spill_t* const self,
+                    const struct sens_sample_t         sample)
+{
+    pboolean is_appended = FALSE;
+
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the spill segment !!!\n");
+        return FALSE;
+    }
+
+    if (self->next_in - self->next_out < self->capacity)
+    {
+        struct sample_spill_rec_t* const rec = sample_spill_rec(self, self->next_in);
+
+        rec->sens_id      = sample.sens_id;
+        rec->num_absorbed = sample.num_absorbed;
+        rec->val          = sample.val;
+        rec->num          = sample.num;
+
+        self->next_in++;
+        sample_spill_count_uncommitted(self);
+
+        is_appended = TRUE;
+    }
+
+    p_mutex_unlock(self->mutex);
+
+    return is_appended;
+}
+
+psize
+sample_spill_prepend(      struct sample_spill_t* const self,
+                     const struct sens_sample_t*  const samples,
+                     const psize                        count)
+{
+    if (!p_mutex_lock(self->commit_mutex))
+    {
+        printf("!!! failed to lock the spill segment !!!\n");
+        return 0;
+    }
+
+    // The records go to free slots behind next_out and the header moves next_out
+    // back only once they are on disk, so a crash never exposes half of them.
+    // Taken records are freed on disk first, their slots may be reused here.
+    if (!sample_spill_commit_locked(self))
+    {
+        p_mutex_unlock(self->commit_mutex);
+        return 0;
+    }
+
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the spill segment !!!\n");
+        p_mutex_unlock(self->commit_mutex);
+        return 0;
+    }
+
+    const psize pending = self->next_in - self->next_out;
+    const psize room    = self->capacity - pending;
+    const psize kept    = (count < room) ? count : room;
+    const psize skipped = count - kept;
+
+    if (self->next_out < kept)
+    {
+        self->next_out += self->capacity;
+        self->next_in  += self->capacity;
+    }
+
+    self->next_out -= kept;
+
+    for (psize idx = 0;
+               idx < kept;
+               idx++)
+    {
+        struct sample_spill_rec_t* const rec = sample_spill_rec(self, self->next_out + idx);
+
+        rec->sens_id      = samples[skipped + idx].sens_id;
+        rec->num_absorbed = samples[skipped + idx].num_absorbed;
+        rec->val          = samples[skipped + idx].val;
+        rec->num          = samples[skipped + idx].num;
+    }
+
+    self->dirty_from = self->next_out;
+
+    p_mutex_unlock(self->mutex);
+
+    sample_spill_commit_locked(self);
+
+    p_mutex_unlock(self->commit_mutex);
+
+    return kept;
+}
+
+pboolean
+sample_spill_take(struct sample_spill_t* const self,
+                  struct sens_sample_t*  const sample)
+{
+    pboolean is_taken = FALSE;
+
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the spill segment !!!\n");
+        return FALSE;
+    }
+
+    if (self->next_out < self->next_in)
+    {
+        const struct sample_spill_rec_t* const rec = sample_spill_rec(self, self->next_out);
+
+        sample->sens_id      = (puint8) rec->sens_id;
+        sample->num_absorbed = rec->num_absorbed;
+        sample->val          = rec->val;
+        sample->num          = (psize) rec->num;
+        sample->ts           = 0; // the collection time is not persisted
+
+        self->next_out++;
+        sample_spill_count_uncommitted(self);
+
+        is_taken = TRUE;
+    }
+
+    p_mutex_unlock(self->mutex);
+
+    return is_taken;
+}
+
+pboolean
+sample_spill_commit(struct sample_spill_t* const self)
+{
+    if (!p_mutex_lock(self->commit_mutex))
+    {
+        printf("!!! failed to lock the spill segment !!!\n");
+        return FALSE;
+    }
+
+    const pboolean is_committed = sample_spill_commit_locked(self);
+
+    p_mutex_unlock(self->commit_mutex);
+
+    return is_committed;
+}
+
+psize
+sample_spill_pending(struct sample_spill_t* const self)
+{
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the spill segment !!!\n");
+        return 0;
+    }
+
+    const psize pending = self->next_in - self->next_out;
+
+    p_mutex_unlock(self->mutex);
+
+    return pending;
+}
+
+psize
+sample_spill_pending_for(      struct sample_spill_t* const self,
+                         const puint8                       sens_id)
+{
+    psize pending = 0;
+
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the spill segment !!!\n");
+        return 0;
+    }
+
+    for (psize idx = self->next_out;
+               idx < self->next_in;
+               idx++)
+    {
+        if (sens_id == sample_spill_rec(self, idx)->sens_id) {
+            pending++;
+        }
+    }
+
+    p_mutex_unlock(self->mutex);
+
+    return pending;
+}
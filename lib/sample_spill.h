@@ -0,0 +1,102 @@
+#ifndef _SAMPLE_SPILL_H_INCLUDED
+    #define _SAMPLE_SPILL_H_INCLUDED
+
+    #include "plibsys.h"
+
+    #include "queue.h"
+
+    /**
+     * Number of appended or taken records after which a background thread flushes
+     * the segment to disk, so appending and taking never wait for the disk.
+     * Records are only visible to a restarted process once they have been
+     * committed, so a crash loses about one group of appends, plus those made
+     * while the group was written, and replays as many already taken records.
+     */
+    #define SAMPLE_SPILL_GROUP_COMMIT 32
+
+    struct sample_spill_t;
+
+    /**
+     * Spill segment constructor.
+     * Opens the memory-mapped segment file at the given path, creating it if it
+     * does not exist. Records left in an existing segment by a previous run are
+     * kept and can be replayed with sample_spill_take(); those of a version 1
+     * segment are converted first. A file which is not a segment, is corrupted
+     * or has a newer version is left untouched.
+     * @param path: The path of the segment file.
+     * @param capacity: The number of records the segment can hold if it is created.
+     * @returns: A pointer to the spill segment if successful, NULL otherwise.
+     */
+    struct sample_spill_t*
+    sample_spill_open(const pchar* const path,
+                      const psize        capacity);
+
+    /**
+     * Spill segment destructor.
+     * Commits the pending records and cursors before unmapping the segment.
+     * @param self: A pointer to the spill segment instance.
+     */
+    void
+    sample_spill_close(struct sample_spill_t* const self);
+
+    /**
+     * Append a sample at the end of the segment.
+     * @param self: A pointer to the spill segment instance.
+     * @param sample: The sample to append.
+     * @returns: TRUE if the sample was appended, FALSE if the segment is full.
+     */
+    pboolean
+    sample_spill_append(      struct sample_spill_t* const self,
+                        const struct sens_sample_t         sample);
+
+    /**
+     * Put samples in front of the records waiting in the segment, so they are
+     * taken before them. Used for samples that are older than the pending records.
+     * If the segment cannot hold all of them, the oldest ones are left out.
+     * The segment is committed before returning.
+     * @param self: A pointer to the spill segment instance.
+     * @param samples: The samples to put in front, oldest first.
+     * @param count: The number of samples.
+     * @returns: The number of samples put in the segment, taken from the end of
+     *           the array.
+     */
+    psize
+    sample_spill_prepend(      struct sample_spill_t* const self,
+                         const struct sens_sample_t*  const samples,
+                         const psize                        count);
+
+    /**
+     * Take the oldest sample from the segment.
+     * @param self: A pointer to the spill segment instance.
+     * @param sample: Where to store the sample.
+     * @returns: TRUE if a sample was taken, FALSE if the segment is empty.
+     */
+    pboolean
+    sample_spill_take(struct sample_spill_t* const self,
+                      struct sens_sample_t*  const sample);
+
+    /**
+     * Flush the appended records and both cursors to disk.
+     * @param self: A pointer to the spill segment instance.
+     * @returns: TRUE if successful, FALSE otherwise.
+     */
+    pboolean
+    sample_spill_commit(struct sample_spill_t* const self);
+
+    /**
+     * Get the number of samples waiting in the segment.
+     * @param self: A pointer to the spill segment instance.
+     */
+    psize
+    sample_spill_pending(struct sample_spill_t* const self);
+
+    /**
+     * Get the number of samples from a single sensor waiting in the segment.
+     * @param self: A pointer to the spill segment instance.
+     * @param sens_id: The sensor ID.
+     */
+    psize
+    sample_spill_pending_for(      struct sample_spill_t* const self,
+                             const puint8                       sens_id);
+
+#endif // _SAMPLE_SPILL_H_INCLUDED
@@ -0,0 +1,418 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sample_window.h"
+
+#define SAMPLE_WINDOW_MAX_SENSORS 256 // every value of sens_sample_t.sens_id
+
+struct sample_window_sens_t
+{
+    sample_window_kind kind;
+    psize              size;
+
+    // one array per field instead of an array of samples, so rescans stream through memory
+    puint32*           vals;     // the last size values, vals[seq % size]
+    puint64*           min_seqs; // sequence numbers of ascending values, the first is the minimum
+    puint64*           max_seqs; // sequence numbers of descending values, the first is the maximum
+    puint32*           sorted;   // scratch space for the percentiles
+
+    puint64            num_fed;  // the sequence number of the next value
+    psize              count;
+    psize              min_first;
+    psize              min_len;
+    psize              max_first;
+    psize              max_len;
+    puint64            sum;
+    pdouble            mean;
+    pdouble            m2;       // the sum of squared differences from the mean
+    psize              num_evicted;
+};
+
+struct sample_window_t
+{
+    struct sample_window_sens_t sens[SAMPLE_WINDOW_MAX_SENSORS];
+
+    PMutex*                     mutex;
+};
+
+static void
+sample_window_reset(struct sample_window_sens_t* const sens)
+{
+    sens->num_fed     = 0;
+    sens->count       = 0;
+    sens->min_first   = 0;
+    sens->min_len     = 0;
+    sens->max_first   = 0;
+    sens->max_len     = 0;
+    sens->sum         = 0;
+    sens->mean        = 0;
+    sens->m2          = 0;
+    sens->num_evicted = 0;
+}
+
+/**
+ * Recompute the mean and the squared differences from the values, to drop the
+ * rounding errors piled up by removing values one by one.
+ */
+static void
+sample_window_refresh(struct sample_window_sens_t* const sens)
+{
+    pdouble m2 = 0;
+
+    sens->mean = (pdouble) sens->sum / sens->count;
+
+    for (psize idx = 0;
+               idx < sens->count;
+               idx++)
+    {
+        const pdouble diff = sens->vals[idx] - sens->mean;
+
+        m2 += diff * diff;
+    }
+
+    sens->m2 = m2;
+}
+
+/**
+ * Append a sequence number to a monotonic deque of the window, dropping the
+ * ones it makes useless.
+ */
+static void
+sample_window_deque_push(const struct sample_window_sens_t* const sens,
+                               puint64*                     const seqs,
+                         const psize                              first,
+                               psize*                       const len,
+                         const puint64                            seq,
+                         const pboolean                           is_min)
+{
+    const puint32 val = sens->vals[seq % sens->size];
+
+    while (0 < *len)
+    {
+        const puint32 last = sens->vals[seqs[(first + *len - 1) % sens->size] % sens->size];
+
+        if (is_min ? (last < val) : (last > val)) {
+            break;
+        }
+
+        (*len)--;
+    }
+
+    seqs[(first + *len) % sens->size] = seq;
+    (*len)++;
+}
+
+static int
+sample_window_compare(const void* const left,
+                      const void* const right)
+{
+    const puint32 lhs = *(const puint32*) left;
+    const puint32 rhs = *(const puint32*) right;
+
+    return (lhs < rhs) ? -1 : (lhs > rhs);
+}
+
+static void
+sample_window_stats_get(const struct sample_window_sens_t*  const sens,
+                              struct sample_window_stats_t* const stats)
+{
+    stats->count    = sens->count;
+    stats->min      = sens->vals[sens->min_seqs[sens->min_first] % sens->size];
+    stats->max      = sens->vals[sens->max_seqs[sens->max_first] % sens->size];
+    stats->sum      = sens->sum;
+    stats->mean     = (pdouble) sens->sum / sens->count;
+    stats->variance = (sens->m2 > 0) ? sens->m2 / sens->count : 0;
+
+    // the window is always the first count values of vals, in some order
+    memcpy(sens->sorted, sens->vals, sizeof(puint32) * sens->count);
+    qsort(sens->sorted, sens->count, sizeof(puint32), sample_window_compare);
+
+    // nearest rank
+    stats->p50 = sens->sorted[(sens->count * 50 + 99) / 100 - 1];
+    stats->p90 = sens->sorted[(sens->count * 90 + 99) / 100 - 1];
+    stats->p99 = sens->sorted[(sens->count * 99 + 99) / 100 - 1];
+}
+
+struct sample_window_t*
+sample_window_create(void)
+{
+    struct sample_window_t* self = NULL;
+
+    do
+    {
+        self = p_malloc0(sizeof(struct sample_window_t));
+
+        if (NULL == self)
+        {
+            printf("!!! not enough memory to create a window stage !!!\n");
+            break;
+        }
+
+        self->mutex = p_mutex_new();
+
+        if (NULL == self->mutex)
+        {
+            printf("!!! not enough memory to create a mutex !!!\n");
+            sample_window_destroy(self);
+            self = NULL;
+            break;
+        }
+
+    } while (0);
+
+    return self;
+}
+
+void
+sample_window_destroy(struct sample_window_t* const self)
+{
+    if (NULL == self) {
+        return;
+    }
+
+    for (psize sens_id = 0;
+               sens_id < SAMPLE_WINDOW_MAX_SENSORS;
+               sens_id++)
+    {
+        if (NULL != self->sens[sens_id].min_seqs) {
+            p_free(self->sens[sens_id].min_seqs);
+        }
+    }
+
+    if (NULL != self->mutex)
+    {
+        p_mutex_free(self->mutex);
+        self->mutex = NULL;
+    }
+
+    p_free(self);
+}
+
+pboolean
+sample_window_set(      struct sample_window_t* const self,
+                  const puint8                        sens_id,
+                  const sample_window_kind            kind,
+                  const psize                         size)
+{
+    if ((SAMPLE_WINDOW_NONE != kind) &&
+        (0 == size))
+    {
+        return FALSE;
+    }
+
+    puint64* storage = NULL;
+
+    if (SAMPLE_WINDOW_NONE != kind)
+    {
+        // min_seqs, max_seqs, vals and sorted in a single allocation
+        storage = p_malloc0(size * (2 * sizeof(puint64) + 2 * sizeof(puint32)));
+
+        if (NULL == storage)
+        {
+            printf("!!! not enough memory for a window of %lu samples !!!\n", size);
+            return FALSE;
+        }
+    }
+
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the window stage !!!\n");
+        p_free(storage);
+        return FALSE;
+    }
+
+    struct sample_window_sens_t* const sens = &self->sens[sens_id];
+
+    puint64* const old_storage = sens->min_seqs;
+
+    sens->kind     = kind;
+    sens->size     = (SAMPLE_WINDOW_NONE == kind) ? 0 : size;
+    sens->min_seqs = storage;
+    sens->max_seqs = (NULL == storage) ? NULL : storage + size;
+    sens->vals     = (NULL == storage) ? NULL : (puint32*) (storage + 2 * size);
+    sens->sorted   = (NULL == storage) ? NULL : sens->vals + size;
+
+    sample_window_reset(sens);
+
+    p_mutex_unlock(self->mutex);
+
+    if (NULL != old_storage) {
+        p_free(old_storage);
+    }
+
+    return TRUE;
+}
+
+pboolean
+sample_window_configure(      struct sample_window_t* const self,
+                        const pchar*                  const spec)
+{
+    static const struct
+    {
+        const pchar*       name;
+        sample_window_kind kind;
+    } names[] = {
+        { "none",     SAMPLE_WINDOW_NONE     },
+        { "tumbling", SAMPLE_WINDOW_TUMBLING },
+        { "sliding",  SAMPLE_WINDOW_SLIDING  }
+    };
+
+    pboolean     is_ok = TRUE;
+    const pchar* entry = spec;
+
+    while (is_ok && ('\0' != *entry))
+    {
+        pchar         name[16];
+        unsigned int  sens_id;
+        unsigned long size;
+        int           len = 0;
+
+        if ((3 != sscanf(entry, "%u:%15[a-z]:%lu%n", &sens_id, name, &size, &len)) ||
+            (SAMPLE_WINDOW_MAX_SENSORS <= sens_id))
+        {
+            printf("!!! invalid window %s !!!\n", entry);
+            return FALSE;
+        }
+
+        psize idx = 0;
+
+        while ((idx < sizeof(names) / sizeof(names[0])) &&
+               (0 != strcmp(names[idx].name, name)))
+        {
+            idx++;
+        }
+
+        if (idx == sizeof(names) / sizeof(names[0]))
+        {
+            printf("!!! unknown window kind %s !!!\n", name);
+            return FALSE;
+        }
+
+        is_ok = sample_window_set(self, (puint8) sens_id, names[idx].kind, (psize) size);
+
+        entry += len;
+
+        if (',' == *entry) {
+            entry++;
+        }
+    }
+
+    return is_ok;
+}
+
+pboolean
+sample_window_feed(      struct sample_window_t*       const self,
+                   const struct sens_sample_t                  sample,
+                         struct sample_window_stats_t* const stats)
+{
+    pboolean is_closed = FALSE;
+
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the window stage !!!\n");
+        return FALSE;
+    }
+
+    struct sample_window_sens_t* const sens = &self->sens[sample.sens_id];
+
+    if (SAMPLE_WINDOW_NONE == sens->kind)
+    {
+        p_mutex_unlock(self->mutex);
+        return FALSE;
+    }
+
+    const puint64 seq = sens->num_fed++;
+
+    if (sens->count == sens->size)
+    {
+        // only a sliding window is ever full here, its oldest value leaves
+        const puint32 old_val = sens->vals[seq % sens->size];
+
+        sens->sum -= old_val;
+        sens->count--;
+
+        if (0 == sens->count)
+        {
+            sens->mean = 0;
+            sens->m2   = 0;
+        }
+        else
+        {
+            const pdouble diff = old_val - sens->mean;
+
+            sens->mean -= diff / sens->count;
+            sens->m2   -= diff * (old_val - sens->mean);
+        }
+
+        if (sens->min_seqs[sens->min_first] + sens->size == seq)
+        {
+            sens->min_first = (sens->min_first + 1) % sens->size;
+            sens->min_len--;
+        }
+
+        if (sens->max_seqs[sens->max_first] + sens->size == seq)
+        {
+            sens->max_first = (sens->max_first + 1) % sens->size;
+            sens->max_len--;
+        }
+
+        sens->num_evicted++;
+    }
+
+    sens->vals[seq % sens->size] = sample.val;
+    sens->sum += sample.val;
+    sens->count++;
+
+    // Welford's update
+    const pdouble diff = sample.val - sens->mean;
+
+    sens->mean += diff / sens->count;
+    sens->m2   += diff * (sample.val - sens->mean);
+
+    sample_window_deque_push(sens, sens->min_seqs, sens->min_first, &sens->min_len, seq, TRUE);
+    sample_window_deque_push(sens, sens->max_seqs, sens->max_first, &sens->max_len, seq, FALSE);
+
+    if (SAMPLE_WINDOW_SLIDING == sens->kind)
+    {
+        // once per window length, so it stays constant time per sample
+        if (sens->num_evicted == sens->size)
+        {
+            sample_window_refresh(sens);
+            sens->num_evicted = 0;
+        }
+    }
+    else if (sens->count == sens->size)
+    {
+        sample_window_stats_get(sens, stats);
+        sample_window_reset(sens);
+        is_closed = TRUE;
+    }
+
+    p_mutex_unlock(self->mutex);
+
+    return is_closed;
+}
+
+pboolean
+sample_window_get(      struct sample_window_t*       const self,
+                  const puint8                              sens_id,
+                        struct sample_window_stats_t* const stats)
+{
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! failed to lock the window stage !!!\n");
+        return FALSE;
+    }
+
+    const struct sample_window_sens_t* const sens = &self->sens[sens_id];
+    const pboolean is_known = (SAMPLE_WINDOW_NONE != sens->kind) && (0 < sens->count);
+
+    if (is_known) {
+        sample_window_stats_get(sens, stats);
+    }
+
+    p_mutex_unlock(self->mutex);
+
+    return is_known;
+}
@@ -0,0 +1,105 @@
+#ifndef _SAMPLE_WINDOW_H_INCLUDED
+    #define _SAMPLE_WINDOW_H_INCLUDED
+
+    #include "plibsys.h"
+
+    #include "queue.h"
+
+    /**
+     * How the handled samples of a sensor are grouped for statistics.
+     */
+    typedef enum sample_window_kind_t
+    {
+        SAMPLE_WINDOW_NONE,     // No statistics
+        SAMPLE_WINDOW_TUMBLING, // Consecutive windows of N samples, each reported once full
+        SAMPLE_WINDOW_SLIDING   // The last N samples
+    }sample_window_kind;
+
+    /**
+     * Statistics of the samples of a window.
+     */
+    typedef struct sample_window_stats_t
+    {
+        psize   count;    // The number of samples
+        puint32 min;      // The smallest value
+        puint32 max;      // The largest value
+        puint64 sum;      // The sum of the values
+        pdouble mean;     // The mean value
+        pdouble variance; // The population variance of the values
+        puint32 p50;      // The median value
+        puint32 p90;      // The 90th percentile value
+        puint32 p99;      // The 99th percentile value
+    }sample_window_stats;
+
+    struct sample_window_t;
+
+    /**
+     * Window stage constructor. All sensors start with SAMPLE_WINDOW_NONE.
+     * @returns: A pointer to the stage if successful, NULL otherwise.
+     */
+    struct sample_window_t*
+    sample_window_create(void);
+
+    /**
+     * Window stage destructor.
+     * @param self: A pointer to the stage instance.
+     */
+    void
+    sample_window_destroy(struct sample_window_t* const self);
+
+    /**
+     * Change the window of a sensor. It may be called while samples are fed from
+     * another thread; the samples of the previous window are discarded.
+     * @param self: A pointer to the stage instance.
+     * @param sens_id: The sensor ID.
+     * @param kind: The kind of window.
+     * @param size: The number of samples per window, ignored for SAMPLE_WINDOW_NONE.
+     * @returns: TRUE if successful, FALSE if the size is 0 or out of memory.
+     */
+    pboolean
+    sample_window_set(      struct sample_window_t* const self,
+                      const puint8                        sens_id,
+                      const sample_window_kind            kind,
+                      const psize                         size);
+
+    /**
+     * Set windows from a comma-separated list of sens_id:kind:size entries,
+     * where the kind is one of none, tumbling or sliding, for example
+     * "1:sliding:100,3:tumbling:20".
+     * @param self: A pointer to the stage instance.
+     * @param spec: The list of windows.
+     * @returns: TRUE if every entry was applied, FALSE otherwise.
+     */
+    pboolean
+    sample_window_configure(      struct sample_window_t* const self,
+                            const pchar*                  const spec);
+
+    /**
+     * Add a handled sample to the window of its sensor. Count, sum, mean,
+     * variance, min and max are updated in constant amortized time; percentiles
+     * are only computed when a tumbling window closes or sample_window_get() is
+     * called.
+     * @param self: A pointer to the stage instance.
+     * @param sample: The sample.
+     * @param stats: Where to store the statistics of a closed tumbling window.
+     * @returns: TRUE if the sample closed a tumbling window, FALSE otherwise.
+     */
+    pboolean
+    sample_window_feed(      struct sample_window_t*       const self,
+                       const struct sens_sample_t                  sample,
+                             struct sample_window_stats_t* const stats);
+
+    /**
+     * Get the statistics of the current window of a sensor, the last N samples
+     * of a sliding window or the samples of a tumbling window not yet closed.
+     * @param self: A pointer to the stage instance.
+     * @param sens_id: The sensor ID.
+     * @param stats: Where to store the statistics.
+     * @returns: TRUE if successful, FALSE if the sensor has no window or it is empty.
+     */
+    pboolean
+    sample_window_get(      struct sample_window_t*       const self,
+                      const puint8                              sens_id,
+                            struct sample_window_stats_t* const stats);
+
+#endif // _SAMPLE_WINDOW_H_INCLUDED
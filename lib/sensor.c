@@ -3,16 +3,20 @@
 #include <stdlib.h>
 
 #include "sensor.h"
+#include "sensor_timer.h"
 
 struct sensor_t
 {
     puint32 val;
     pboolean val_hdld;
     psize num_samples;
+    psize num_overwritten;
     pboolean done;
     puint8 sensor_id;
     PMutex *mutex;
     PUThread *prod_th;
+    puint64 period_ns;
+    struct sensor_jitter_t jitter;
 };
 
 static ppointer
@@ -24,36 +28,60 @@ sensor_task(ppointer arg)
 
     puint32 prev_val = 1;
 
+    // comment off these coding of the random-generating sample
+    //    const puint32 rand_sleep_timeout = (rand() % 800) + 200;
+    // fixed frequency is the sensor generating a sample every period (200 milliseconds
+    // by default) to lead to the data accumulation
+    struct timespec deadline;
+    sensor_timer_now(&deadline);
+
     while (TRUE)
     {
-        // comment off these coding of the random-generating sample
-        //    const puint32 rand_sleep_timeout = (rand() % 800) + 200;
-        //    printf("### Sensor %d will sleep %d ###\n",
-        //           self->sensor_id,
-        //           rand_sleep_timeout);
-        // fixed frequency is the sensor generating a sample every 200 milliseconds
-        // to lead to the data accumulation
-        const puint32 rand_sleep_timeout = 200;
-
-        for (psize idx = 0;
-                   idx < rand_sleep_timeout / 100;
-                   idx++)
-        {
-            assert(p_uthread_sleep(100) == 0);
+        // the next deadline is derived from the previous one, not from the time
+        // the previous sample was emitted, so the period does not drift
+        sensor_timer_add_ns(&deadline, self->period_ns);
 
-            if (self->done)
-            {
-                p_uthread_exit(0);
-                return NULL;
-            }
+        if (!sensor_timer_wait_until(&self->done, &deadline))
+        {
+            p_uthread_exit(0);
+            return NULL;
         }
 
+        struct timespec now;
+        sensor_timer_now(&now);
+
+        const puint64 late_ns = (puint64) sensor_timer_diff_ns(&now, &deadline);
+
         assert(p_mutex_lock(self->mutex) == TRUE);
 
+        if ((0 == self->jitter.num_wakeups) ||
+            (late_ns < self->jitter.min_late_ns))
+        {
+            self->jitter.min_late_ns = late_ns;
+        }
+
+        if (late_ns > self->jitter.max_late_ns) {
+            self->jitter.max_late_ns = late_ns;
+        }
+
+        self->jitter.sum_late_ns += late_ns;
+        self->jitter.num_wakeups++;
+
+        if (late_ns >= self->period_ns)
+        {
+            // skip the deadlines that have already passed instead of bursting
+            const puint64 num_missed = late_ns / self->period_ns;
+
+            self->jitter.num_overruns += num_missed;
+            sensor_timer_add_ns(&deadline, num_missed * self->period_ns);
+        }
+
         if (!self->val_hdld)
         {
             printf("[SENS %d] Dropped reading\n",
                    self->sensor_id);
+
+            self->num_overwritten++;
         }
 
         self->val_hdld = FALSE;
@@ -77,12 +105,28 @@ sensor_task(ppointer arg)
 struct sensor_t*
 sensor_create(const puint8 id)
 {
+    return sensor_create_full(id, SENSOR_DEFAULT_PERIOD_US);
+}
+
+struct sensor_t*
+sensor_create_full(const puint8  id,
+                   const puint32 period_us)
+{
+    if (period_us == 0) {
+        return NULL;
+    }
+
     struct sensor_t* self = p_malloc0(sizeof(struct sensor_t));
 
     if (self == NULL) {
         return NULL;
     }
 
+    // the sensor task reads these as soon as it starts
+    self->sensor_id = id;
+    self->val_hdld = TRUE;
+    self->period_ns = (puint64) period_us * 1000;
+
     self->mutex = p_mutex_new();
 
     if (self->mutex == NULL) {
@@ -99,9 +143,6 @@ sensor_create(const puint8 id)
         return NULL;
     }
 
-    self->sensor_id = id;
-    self->val_hdld = TRUE;
-
     return self;
 }
 
@@ -153,3 +194,18 @@ psize
 sensor_get_num_samples(const struct sensor_t *const self) {
     return self->num_samples;
 }
+
+psize
+sensor_get_num_overwritten(const struct sensor_t *const self) {
+    return self->num_overwritten;
+}
+
+void
+sensor_get_jitter(const struct sensor_t *const self,
+                  struct sensor_jitter_t *const jitter)
+{
+    assert(p_mutex_lock(self->mutex) == TRUE);
+
+    *jitter = self->jitter;
+    p_mutex_unlock(self->mutex);
+}
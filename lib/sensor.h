@@ -3,6 +3,23 @@
 
     #include "plibsys.h"
 
+    /**
+     * Default emission period of a sensor in microseconds.
+     */
+    #define SENSOR_DEFAULT_PERIOD_US 200000
+
+    /**
+     * Wake-up statistics of a sensor, measured against its emission deadlines.
+     */
+    typedef struct sensor_jitter_t
+    {
+        psize   num_wakeups;  // The number of deadlines reached
+        puint64 min_late_ns;  // The smallest wake-up delay after a deadline
+        puint64 max_late_ns;  // The largest wake-up delay after a deadline
+        puint64 sum_late_ns;  // The sum of the wake-up delays, for the mean
+        psize   num_overruns; // The number of deadlines skipped because the sensor woke up too late
+    }sensor_jitter;
+
     struct sensor_t;
 
     /**
@@ -13,6 +30,18 @@
     struct sensor_t*
     sensor_create(const puint8 id);
 
+    /**
+     * Sensor constructor with a custom emission period.
+     * Samples are emitted on absolute deadlines, so the period does not drift with
+     * the time spent emitting.
+     * @param id: The ID of the sensor.
+     * @param period_us: The emission period in microseconds.
+     * @returns: A pointer to the sensor if successful, NULL otherwise.
+     */
+    struct sensor_t*
+    sensor_create_full(const puint8  id,
+                       const puint32 period_us);
+
     /**
      * Sensor destructor.
      * @param self: A pointer to the sensor instance.
@@ -49,4 +78,20 @@
     psize
     sensor_get_num_samples(const struct sensor_t* const self);
 
+    /**
+     * Get the number of samples overwritten by the next one before they were read.
+     * @param self: A pointer to the sensor instance.
+     */
+    psize
+    sensor_get_num_overwritten(const struct sensor_t* const self);
+
+    /**
+     * Get the wake-up statistics of the sensor.
+     * @param self: A pointer to the sensor instance.
+     * @param jitter: Where to store the statistics.
+     */
+    void
+    sensor_get_jitter(const struct sensor_t* const self,
+                      struct sensor_jitter_t* const jitter);
+
 #endif // _SENSOR_H_INCLUDED
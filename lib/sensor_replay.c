@@ -0,0 +1,436 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sample_archive.h"
+#include "sample_index.h"
+#include "sensor.h"
+#include "sensor_timer.h"
+
+/*
+ * Replay implementation of the sensor interface.
+ *
+ * Instead of generating readings, every sensor emits the samples recorded for
+ * its ID in the archive named by the PCP_REPLAY_FILE environment variable (see
+ * PCP_RECORD_FILE). PCP_REPLAY_SPEED selects the pace:
+ *   unset or 1  the original collection times
+ *   N           N times faster than recorded
+ *   0 or max    as fast as possible: the next sample is emitted as soon as the
+ *               previous one has been read, so no reading is ever dropped
+ * PCP_REPLAY_FROM_MS and PCP_REPLAY_TO_MS restrict the replay to a window of the
+ * trace, in milliseconds from its start, looked up in a sample index.
+ * The input is identical on every run, which makes runs comparable.
+ * The period given to sensor_create_full() is ignored, the trace sets the pace.
+ */
+
+struct sensor_t
+{
+    puint32 val;
+    pboolean val_hdld;
+    psize num_samples;
+    psize num_overwritten;
+    pboolean done;
+    puint8 sensor_id;
+    PMutex *mutex;
+    PCondVariable *hdld_cond; // signalled when the value is read or the sensor stops
+    PUThread *prod_th;
+
+    struct sample_record_t *records;
+    psize num_records;
+    puint64 origin_ts; // the start of the replayed window
+    pdouble speed;     // 0 for as fast as possible
+    struct sensor_jitter_t jitter;
+};
+
+static ppointer
+sensor_task(ppointer arg)
+{
+    struct sensor_t* self = (struct sensor_t*)arg;
+
+    struct timespec start;
+    sensor_timer_now(&start);
+
+    for (psize idx = 0;
+               idx < self->num_records;
+               idx++)
+    {
+        const struct sample_record_t *const rec = &self->records[idx];
+
+        if (0 < self->speed)
+        {
+            struct timespec deadline = start;
+            sensor_timer_add_ns(&deadline,
+                                (puint64) ((pdouble) (rec->ts - self->origin_ts) * 1000 / self->speed));
+
+            if (!sensor_timer_wait_until(&self->done, &deadline)) {
+                break;
+            }
+
+            struct timespec now;
+            sensor_timer_now(&now);
+
+            const puint64 late_ns = (puint64) sensor_timer_diff_ns(&now, &deadline);
+
+            if (!p_mutex_lock(self->mutex))
+            {
+                printf("!!! [SENS %d] locking the sensor failed !!!\n", self->sensor_id);
+                break;
+            }
+
+            if ((0 == self->jitter.num_wakeups) ||
+                (late_ns < self->jitter.min_late_ns))
+            {
+                self->jitter.min_late_ns = late_ns;
+            }
+
+            if (late_ns > self->jitter.max_late_ns) {
+                self->jitter.max_late_ns = late_ns;
+            }
+
+            self->jitter.sum_late_ns += late_ns;
+            self->jitter.num_wakeups++;
+
+            p_mutex_unlock(self->mutex);
+        }
+        else
+        {
+            // sleep until collect_task reads the previous value
+            if (!p_mutex_lock(self->mutex))
+            {
+                printf("!!! [SENS %d] locking the sensor failed !!!\n", self->sensor_id);
+                break;
+            }
+
+            pboolean is_waited = TRUE;
+
+            while (!self->val_hdld && !self->done && is_waited) {
+                is_waited = p_cond_variable_wait(self->hdld_cond, self->mutex);
+            }
+
+            p_mutex_unlock(self->mutex);
+
+            if (!is_waited)
+            {
+                printf("!!! [SENS %d] waiting for the consumer failed !!!\n", self->sensor_id);
+                break;
+            }
+
+            if (self->done) {
+                break;
+            }
+        }
+
+        if (!p_mutex_lock(self->mutex))
+        {
+            printf("!!! [SENS %d] locking the sensor failed !!!\n", self->sensor_id);
+            break;
+        }
+
+        if (!self->val_hdld)
+        {
+            printf("[SENS %d] Dropped reading\n",
+                   self->sensor_id);
+
+            self->num_overwritten++;
+        }
+
+        self->val_hdld = FALSE;
+        self->val = rec->sample.val;
+        self->num_samples++;
+
+        printf("[SENS %d] Sample num %ld ready: %d\n",
+               self->sensor_id,
+               self->num_samples,
+               self->val);
+
+        p_mutex_unlock(self->mutex);
+    }
+
+    if (!self->done)
+    {
+        printf("[SENS %d] Trace finished after %ld samples\n",
+               self->sensor_id,
+               self->num_samples);
+
+        while (!self->done) {
+            p_uthread_sleep(100);
+        }
+    }
+
+    p_uthread_exit(0);
+
+    return NULL;
+}
+
+struct sensor_replay_copy_t
+{
+    struct sample_record_t *records;
+    psize num_records;
+};
+
+static pboolean
+sensor_replay_copy(const struct sample_record_t *const record,
+                         ppointer                      data)
+{
+    struct sensor_replay_copy_t *const copy = (struct sensor_replay_copy_t*)data;
+
+    copy->records[copy->num_records++] = *record;
+
+    return TRUE;
+}
+
+/**
+ * Read a bound of the replay window.
+ * @returns: The bound in milliseconds, def_ms if the variable is unset
+ */
+static puint64
+sensor_replay_window_ms(const char *const name,
+                        const puint64     def_ms)
+{
+    const char *const value = getenv(name);
+
+    if ((NULL == value) || ('\0' == *value)) {
+        return def_ms;
+    }
+
+    return (puint64) strtoull(value, NULL, 10);
+}
+
+/**
+ * Load the samples recorded for a sensor, in collection order.
+ * @returns: TRUE if successful, FALSE otherwise
+ */
+static pboolean
+sensor_load_trace(struct sensor_t *const self)
+{
+    const char *const path = getenv("PCP_REPLAY_FILE");
+
+    if (NULL == path)
+    {
+        printf("!!! PCP_REPLAY_FILE is not set !!!\n");
+        return FALSE;
+    }
+
+    const char *const speed = getenv("PCP_REPLAY_SPEED");
+
+    if ((NULL == speed) || ('\0' == *speed)) {
+        self->speed = 1.0;
+    } else if (0 == strcmp(speed, "max")) {
+        self->speed = 0.0;
+    } else {
+        self->speed = atof(speed);
+    }
+
+    if (0 > self->speed)
+    {
+        printf("!!! invalid PCP_REPLAY_SPEED %s !!!\n", speed);
+        return FALSE;
+    }
+
+    struct sample_archive_t *const archive = sample_archive_open(path);
+
+    if (NULL == archive) {
+        return FALSE;
+    }
+
+    struct sample_archive_block_t block;
+    puint64 trace_ts = 0;
+
+    for (psize idx = 0;
+               sample_archive_block_info(archive, idx, &block);
+               idx++)
+    {
+        if ((0 == idx) || (block.first_ts < trace_ts)) {
+            trace_ts = block.first_ts;
+        }
+    }
+
+    // the window is given in milliseconds from the start of the whole trace
+    self->origin_ts = trace_ts + sensor_replay_window_ms("PCP_REPLAY_FROM_MS", 0) * 1000;
+
+    const puint64 to_ms = sensor_replay_window_ms("PCP_REPLAY_TO_MS", P_MAXUINT64);
+    const puint64 to_ts = (P_MAXUINT64 == to_ms) ? P_MAXUINT64 : trace_ts + to_ms * 1000;
+
+    struct sample_index_t *const index = sample_index_create();
+    pboolean is_ok = (NULL != index) &&
+                     sample_index_load_archive(index, archive, self->sensor_id);
+
+    if (is_ok)
+    {
+        self->num_records = sample_index_range(index, self->sensor_id, self->origin_ts, to_ts, NULL, NULL);
+
+        if (0 < self->num_records)
+        {
+            self->records = p_malloc0(sizeof(struct sample_record_t) * self->num_records);
+            is_ok = (NULL != self->records);
+        }
+    }
+
+    if (is_ok && (0 < self->num_records))
+    {
+        struct sensor_replay_copy_t copy = {self->records, 0};
+
+        sample_index_range(index, self->sensor_id, self->origin_ts, to_ts, sensor_replay_copy, &copy);
+    }
+
+    sample_index_destroy(index);
+    sample_archive_close(archive);
+
+    if (!is_ok) {
+        printf("!!! failed to load the trace of sensor %d !!!\n", self->sensor_id);
+    }
+
+    return is_ok;
+}
+
+struct sensor_t*
+sensor_create(const puint8 id)
+{
+    return sensor_create_full(id, SENSOR_DEFAULT_PERIOD_US);
+}
+
+struct sensor_t*
+sensor_create_full(const puint8  id,
+                   const puint32 period_us)
+{
+    P_UNUSED(period_us);
+
+    struct sensor_t* self = p_malloc0(sizeof(struct sensor_t));
+
+    if (self == NULL) {
+        return NULL;
+    }
+
+    self->sensor_id = id;
+    self->val_hdld = TRUE;
+
+    if (!sensor_load_trace(self)) {
+        sensor_destroy(self);
+        return NULL;
+    }
+
+    self->mutex = p_mutex_new();
+    self->hdld_cond = p_cond_variable_new();
+
+    if ((self->mutex == NULL) ||
+        (self->hdld_cond == NULL)) {
+        sensor_destroy(self);
+        return NULL;
+    }
+
+    self->prod_th = p_uthread_create(sensor_task,
+                                     self,
+                                     TRUE);
+
+    if (self->prod_th == NULL) {
+        sensor_destroy(self);
+        return NULL;
+    }
+
+    return self;
+}
+
+void
+sensor_destroy(struct sensor_t* self)
+{
+    if (self == NULL) {
+        return;
+    }
+
+    if (self->prod_th != NULL) {
+        sensor_stop(self);
+    }
+
+    if (self->hdld_cond != NULL)
+    {
+        p_cond_variable_free(self->hdld_cond);
+        self->hdld_cond = NULL;
+    }
+
+    if (self->mutex != NULL)
+    {
+        p_mutex_free(self->mutex);
+        self->mutex = NULL;
+    }
+
+    if (self->records != NULL)
+    {
+        p_free(self->records);
+        self->records = NULL;
+    }
+
+    p_free(self);
+}
+
+void
+sensor_stop(struct sensor_t *const self)
+{
+    const pboolean is_locked = p_mutex_lock(self->mutex);
+
+    if (!is_locked) {
+        printf("!!! [SENS %d] locking the sensor failed !!!\n", self->sensor_id);
+    }
+
+    self->done = TRUE;
+
+    if (!p_cond_variable_broadcast(self->hdld_cond)) {
+        printf("!!! [SENS %d] waking up the replay failed !!!\n", self->sensor_id);
+    }
+
+    if (is_locked) {
+        p_mutex_unlock(self->mutex);
+    }
+
+    p_uthread_join(self->prod_th);
+}
+
+puint32
+sensor_read(struct sensor_t *const self)
+{
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! [SENS %d] locking the sensor failed !!!\n", self->sensor_id);
+        return self->val;
+    }
+
+    self->val_hdld = TRUE;
+    puint32 val = self->val;
+
+    if (!p_cond_variable_signal(self->hdld_cond)) {
+        printf("!!! [SENS %d] waking up the replay failed !!!\n", self->sensor_id);
+    }
+
+    p_mutex_unlock(self->mutex);
+
+    return val;
+}
+
+pboolean
+sensor_sample_rdy(const struct sensor_t *const self) {
+    return !self->val_hdld;
+}
+
+psize
+sensor_get_num_samples(const struct sensor_t *const self) {
+    return self->num_samples;
+}
+
+psize
+sensor_get_num_overwritten(const struct sensor_t *const self) {
+    return self->num_overwritten;
+}
+
+void
+sensor_get_jitter(const struct sensor_t *const self,
+                  struct sensor_jitter_t *const jitter)
+{
+    if (!p_mutex_lock(self->mutex))
+    {
+        printf("!!! [SENS %d] locking the sensor failed !!!\n", self->sensor_id);
+        memset(jitter, 0, sizeof(*jitter));
+        return;
+    }
+
+    *jitter = self->jitter;
+    p_mutex_unlock(self->mutex);
+}
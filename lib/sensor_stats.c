@@ -0,0 +1,318 @@
+#include <stdio.h>
+
+#include "sensor_stats.h"
+
+struct sensor_stats_stripe_t
+{
+    PMutex*     mutex;
+    PHashTable* table; // sens_id -> struct sensor_stats_entry_t*
+    pchar       pad[64 - sizeof(PMutex*) - sizeof(PHashTable*)]; // one cache line per stripe
+};
+
+struct sensor_stats_t
+{
+    struct sensor_stats_stripe_t* stripes;
+    psize                         num_stripes;
+};
+
+static struct sensor_stats_stripe_t*
+sensor_stats_stripe(const struct sensor_stats_t* const self,
+                    const puint32                      sens_id)
+{
+    // Fibonacci hashing spreads consecutive IDs over the stripes
+    return &self->stripes[((sens_id * 2654435761U) >> 16) % self->num_stripes];
+}
+
+/**
+ * Lock the stripe of a sensor.
+ * @returns: The locked stripe, NULL if it could not be locked
+ */
+static struct sensor_stats_stripe_t*
+sensor_stats_lock(const struct sensor_stats_t* const self,
+                  const puint32                      sens_id)
+{
+    struct sensor_stats_stripe_t* const stripe = sensor_stats_stripe(self, sens_id);
+
+    if (!p_mutex_lock(stripe->mutex))
+    {
+        printf("!!! failed to lock sensor %u statistics !!!\n", sens_id);
+        return NULL;
+    }
+
+    return stripe;
+}
+
+/**
+ * Free an entry, for p_list_foreach().
+ */
+static void
+sensor_stats_free_entry(ppointer entry, ppointer user_data)
+{
+    P_UNUSED(user_data);
+
+    p_free(entry);
+}
+
+/**
+ * Find the entry of a sensor, adding it if it is new.
+ * Called with the stripe locked.
+ * @returns: The entry, NULL if out of memory
+ */
+static struct sensor_stats_entry_t*
+sensor_stats_find(      struct sensor_stats_stripe_t* const stripe,
+                  const puint32                             sens_id)
+{
+    struct sensor_stats_entry_t* entry = p_hash_table_lookup(stripe->table,
+                                                             PUINT_TO_POINTER(sens_id));
+
+    if ((ppointer) -1 != entry) {
+        return entry;
+    }
+
+    entry = p_malloc0(sizeof(struct sensor_stats_entry_t));
+
+    if (NULL == entry)
+    {
+        printf("!!! not enough memory to add sensor %u statistics !!!\n", sens_id);
+        return NULL;
+    }
+
+    p_hash_table_insert(stripe->table, PUINT_TO_POINTER(sens_id), entry);
+
+    if (entry != p_hash_table_lookup(stripe->table, PUINT_TO_POINTER(sens_id)))
+    {
+        printf("!!! not enough memory to add sensor %u statistics !!!\n", sens_id);
+        p_free(entry);
+        return NULL;
+    }
+
+    return entry;
+}
+
+struct sensor_stats_t*
+sensor_stats_create(const psize num_stripes)
+{
+    struct sensor_stats_t* self = NULL;
+
+    do
+    {
+        self = p_malloc0(sizeof(struct sensor_stats_t));
+
+        if (NULL == self)
+        {
+            printf("!!! not enough memory to create sensor statistics !!!\n");
+            break;
+        }
+
+        self->stripes = p_malloc0(sizeof(struct sensor_stats_stripe_t) * num_stripes);
+
+        if (NULL == self->stripes)
+        {
+            printf("!!! not enough memory to create sensor statistics stripes !!!\n");
+            sensor_stats_destroy(self);
+            self = NULL;
+            break;
+        }
+
+        self->num_stripes = num_stripes;
+
+        for (psize idx = 0;
+                   idx < num_stripes;
+                   idx++)
+        {
+            self->stripes[idx].mutex = p_mutex_new();
+            self->stripes[idx].table = p_hash_table_new();
+
+            if ((NULL == self->stripes[idx].mutex) ||
+                (NULL == self->stripes[idx].table))
+            {
+                printf("!!! not enough memory to create a sensor statistics stripe !!!\n");
+                sensor_stats_destroy(self);
+                self = NULL;
+                break;
+            }
+        }
+
+    } while (0);
+
+    return self;
+}
+
+void
+sensor_stats_destroy(struct sensor_stats_t* const self)
+{
+    if (NULL == self) {
+        return;
+    }
+
+    for (psize idx = 0;
+               (NULL != self->stripes) && (idx < self->num_stripes);
+               idx++)
+    {
+        struct sensor_stats_stripe_t* const stripe = &self->stripes[idx];
+
+        if (NULL != stripe->table)
+        {
+            PList* const entries = p_hash_table_values(stripe->table);
+
+            p_list_foreach(entries, sensor_stats_free_entry, NULL);
+            p_list_free(entries);
+
+            p_hash_table_free(stripe->table);
+            stripe->table = NULL;
+        }
+
+        if (NULL != stripe->mutex)
+        {
+            p_mutex_free(stripe->mutex);
+            stripe->mutex = NULL;
+        }
+    }
+
+    if (NULL != self->stripes)
+    {
+        p_free(self->stripes);
+        self->stripes = NULL;
+    }
+
+    p_free(self);
+}
+
+psize
+sensor_stats_processed(      struct sensor_stats_t* const self,
+                       const puint32                      sens_id,
+                       const puint32                      val)
+{
+    struct sensor_stats_stripe_t* const stripe = sensor_stats_lock(self, sens_id);
+    psize num_proc = 0;
+
+    if (NULL == stripe) {
+        return 0;
+    }
+
+    struct sensor_stats_entry_t* const entry = sensor_stats_find(stripe, sens_id);
+
+    if (NULL != entry)
+    {
+        entry->last_val = val;
+        num_proc        = ++entry->num_proc;
+    }
+
+    p_mutex_unlock(stripe->mutex);
+
+    return num_proc;
+}
+
+pboolean
+sensor_stats_latency(      struct sensor_stats_t* const self,
+                     const puint32                      sens_id,
+                     const puint64                      latency_us)
+{
+    struct sensor_stats_stripe_t* const stripe = sensor_stats_lock(self, sens_id);
+
+    if (NULL == stripe) {
+        return FALSE;
+    }
+
+    struct sensor_stats_entry_t* const entry = sensor_stats_find(stripe, sens_id);
+
+    if (NULL != entry)
+    {
+        if ((0 == entry->num_latency) ||
+            (latency_us < entry->min_latency_us))
+        {
+            entry->min_latency_us = latency_us;
+        }
+
+        if (latency_us > entry->max_latency_us) {
+            entry->max_latency_us = latency_us;
+        }
+
+        entry->sum_latency_us += latency_us;
+        entry->num_latency++;
+    }
+
+    p_mutex_unlock(stripe->mutex);
+
+    return NULL != entry;
+}
+
+psize
+sensor_stats_sequence(      struct sensor_stats_t* const self,
+                      const puint32                      sens_id,
+                      const psize                        num,
+                      const psize                        num_absorbed)
+{
+    struct sensor_stats_stripe_t* const stripe = sensor_stats_lock(self, sens_id);
+    psize num_missing = 0;
+
+    if (NULL == stripe) {
+        return 0;
+    }
+
+    struct sensor_stats_entry_t* const entry = sensor_stats_find(stripe, sens_id);
+
+    if (NULL != entry)
+    {
+        // a number not above the previous one is a new sequence, counted from 1
+        const psize prev_num = (num > entry->last_num) ? entry->last_num : 0;
+
+        if ((FALSE == entry->is_restarted) &&
+            (num > prev_num + num_absorbed + 1))
+        {
+            num_missing = num - prev_num - num_absorbed - 1;
+            entry->num_missing += num_missing;
+            entry->num_gaps++;
+        }
+
+        entry->last_num     = num;
+        entry->is_restarted = FALSE;
+    }
+
+    p_mutex_unlock(stripe->mutex);
+
+    return num_missing;
+}
+
+void
+sensor_stats_sequence_restart(      struct sensor_stats_t* const self,
+                              const puint32                      sens_id)
+{
+    struct sensor_stats_stripe_t* const stripe = sensor_stats_lock(self, sens_id);
+
+    if (NULL == stripe) {
+        return;
+    }
+
+    struct sensor_stats_entry_t* const entry = sensor_stats_find(stripe, sens_id);
+
+    if (NULL != entry) {
+        entry->is_restarted = TRUE;
+    }
+
+    p_mutex_unlock(stripe->mutex);
+}
+
+pboolean
+sensor_stats_get(      struct sensor_stats_t*      const self,
+                 const puint32                           sens_id,
+                       struct sensor_stats_entry_t* const entry)
+{
+    struct sensor_stats_stripe_t* const stripe = sensor_stats_lock(self, sens_id);
+
+    if (NULL == stripe) {
+        return FALSE;
+    }
+
+    const struct sensor_stats_entry_t* const found = p_hash_table_lookup(stripe->table,
+                                                                         PUINT_TO_POINTER(sens_id));
+    const pboolean is_known = ((ppointer) -1 != found);
+
+    if (is_known) {
+        *entry = *found;
+    }
+
+    p_mutex_unlock(stripe->mutex);
+
+    return is_known;
+}
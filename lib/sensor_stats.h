@@ -0,0 +1,113 @@
+#ifndef _SENSOR_STATS_H_INCLUDED
+    #define _SENSOR_STATS_H_INCLUDED
+
+    #include "plibsys.h"
+
+    /**
+     * Default number of independently locked stripes of the map.
+     */
+    #define SENSOR_STATS_STRIPES 16
+
+    /**
+     * State and statistics of a sensor.
+     */
+    typedef struct sensor_stats_entry_t
+    {
+        psize    num_proc;       // The number of processed samples
+        puint32  last_val;       // The value of the last processed sample
+        psize    num_latency;    // The number of samples with a known latency
+        puint64  min_latency_us; // The shortest time from collection to processing
+        puint64  max_latency_us; // The longest time from collection to processing
+        puint64  sum_latency_us; // The sum of the latencies
+        psize    last_num;       // The number of the last sample seen in sequence, 0 if none
+        pboolean is_restarted;   // The next sample starts a new sequence without a gap
+        psize    num_missing;    // The number of samples skipped in the sequence
+        psize    num_gaps;       // The number of times samples were skipped
+    }sensor_stats_entry;
+
+    struct sensor_stats_t;
+
+    /**
+     * Concurrent per-sensor statistics map constructor.
+     * Sensors are spread over stripes, each with its own lock and hash table, so
+     * threads updating different sensors rarely contend.
+     * @param num_stripes: The number of stripes.
+     * @returns: A pointer to the map if successful, NULL otherwise.
+     */
+    struct sensor_stats_t*
+    sensor_stats_create(const psize num_stripes);
+
+    /**
+     * Concurrent per-sensor statistics map destructor.
+     * @param self: A pointer to the map instance.
+     */
+    void
+    sensor_stats_destroy(struct sensor_stats_t* const self);
+
+    /**
+     * Count a processed sample of a sensor, adding the sensor if it is new.
+     * @param self: A pointer to the map instance.
+     * @param sens_id: The sensor ID.
+     * @param val: The sample value.
+     * @returns: The number of processed samples of the sensor, 0 on failure.
+     */
+    psize
+    sensor_stats_processed(      struct sensor_stats_t* const self,
+                           const puint32                      sens_id,
+                           const puint32                      val);
+
+    /**
+     * Account the time a sample of a sensor waited between its collection and
+     * its processing, adding the sensor if it is new.
+     * @param self: A pointer to the map instance.
+     * @param sens_id: The sensor ID.
+     * @param latency_us: The latency in microseconds.
+     * @returns: TRUE if successful, FALSE on failure.
+     */
+    pboolean
+    sensor_stats_latency(      struct sensor_stats_t* const self,
+                         const puint32                      sens_id,
+                         const puint64                      latency_us);
+
+    /**
+     * Check the number of a sample of a sensor against the previous one to
+     * detect the samples lost on the way, adding the sensor if it is new.
+     * Sample numbers start at 1, so a number which does not follow the previous
+     * one starts a new sequence counted from 1.
+     * @param self: A pointer to the map instance.
+     * @param sens_id: The sensor ID.
+     * @param num: The sample number.
+     * @param num_absorbed: The number of samples right before this one that were
+     *                      left out on purpose, e.g. by coalescing.
+     * @returns: The number of samples missing right before this one.
+     */
+    psize
+    sensor_stats_sequence(      struct sensor_stats_t* const self,
+                          const puint32                      sens_id,
+                          const psize                        num,
+                          const psize                        num_absorbed);
+
+    /**
+     * Start a new sequence of a sensor at the next sample checked, without
+     * counting any sample missing before it, e.g. where the samples replayed from
+     * a spill segment end or begin.
+     * @param self: A pointer to the map instance.
+     * @param sens_id: The sensor ID.
+     */
+    void
+    sensor_stats_sequence_restart(      struct sensor_stats_t* const self,
+                                  const puint32                      sens_id);
+
+    /**
+     * Get a consistent copy of the statistics of a sensor.
+     * @param self: A pointer to the map instance.
+     * @param sens_id: The sensor ID.
+     * @param entry: Where to store the statistics.
+     * @returns: TRUE if the sensor is known, FALSE otherwise.
+     */
+    pboolean
+    sensor_stats_get(      struct sensor_stats_t*      const self,
+                     const puint32                           sens_id,
+                           struct sensor_stats_entry_t* const entry);
+
+#endif // _SENSOR_STATS_H_INCLUDED
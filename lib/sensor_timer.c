@@ -0,0 +1,58 @@
+#include <errno.h>
+
+#include "sensor_timer.h"
+
+void
+sensor_timer_now(struct timespec* const ts)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+}
+
+void
+sensor_timer_add_ns(      struct timespec* const ts,
+                    const puint64                ns)
+{
+    ts->tv_sec  += (time_t) (ns / 1000000000);
+    ts->tv_nsec += (long) (ns % 1000000000);
+
+    if (ts->tv_nsec >= 1000000000)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
+}
+
+pint64
+sensor_timer_diff_ns(const struct timespec* const a,
+                     const struct timespec* const b)
+{
+    return ((pint64) a->tv_sec - (pint64) b->tv_sec) * 1000000000 +
+           ((pint64) a->tv_nsec - (pint64) b->tv_nsec);
+}
+
+pboolean
+sensor_timer_wait_until(const pboolean*        const done,
+                        const struct timespec* const deadline)
+{
+    while (!*done)
+    {
+        struct timespec now;
+        sensor_timer_now(&now);
+
+        if (0 <= sensor_timer_diff_ns(&now, deadline)) {
+            return TRUE;
+        }
+
+        struct timespec slice = now;
+        sensor_timer_add_ns(&slice, SENSOR_TIMER_SLICE_NS);
+
+        if (0 < sensor_timer_diff_ns(&slice, deadline)) {
+            slice = *deadline;
+        }
+
+        while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &slice, NULL)) {
+        }
+    }
+
+    return FALSE;
+}
@@ -0,0 +1,51 @@
+#ifndef _SENSOR_TIMER_H_INCLUDED
+    #define _SENSOR_TIMER_H_INCLUDED
+
+    #include <time.h>
+
+    #include "plibsys.h"
+
+    /**
+     * Longest single sleep of sensor_timer_wait_until(), which bounds how long a
+     * stopped sensor keeps sleeping.
+     */
+    #define SENSOR_TIMER_SLICE_NS 10000000
+
+    /**
+     * Read the monotonic clock the sensor deadlines are based on.
+     * @param ts: Where to store the current time.
+     */
+    void
+    sensor_timer_now(struct timespec* const ts);
+
+    /**
+     * Move a point in time forward.
+     * @param ts: The time to move.
+     * @param ns: The number of nanoseconds to add.
+     */
+    void
+    sensor_timer_add_ns(      struct timespec* const ts,
+                        const puint64                ns);
+
+    /**
+     * Get the signed distance between two points in time.
+     * @param a: The later time.
+     * @param b: The earlier time.
+     * @returns: a - b in nanoseconds.
+     */
+    pint64
+    sensor_timer_diff_ns(const struct timespec* const a,
+                         const struct timespec* const b);
+
+    /**
+     * Sleep until an absolute deadline of the monotonic clock, so the wake-up
+     * time does not depend on how long the caller worked since the last one.
+     * @param done: The stop flag, checked at least every SENSOR_TIMER_SLICE_NS.
+     * @param deadline: The time to wake up at.
+     * @returns: TRUE once the deadline is reached, FALSE if the stop flag was raised.
+     */
+    pboolean
+    sensor_timer_wait_until(const pboolean*        const done,
+                            const struct timespec* const deadline);
+
+#endif // _SENSOR_TIMER_H_INCLUDED
@@ -0,0 +1,259 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "config_store.h"
+
+#include "pcp_test.h"
+
+#define TEST_MAX_FREED     64
+#define TEST_NUM_READERS   2
+#define TEST_NUM_PUBLISHED 20000
+
+// every block carries its size in front, the freed ones are poisoned
+#define TEST_BLOCK_HDR 16
+
+static ppointer         freed[TEST_MAX_FREED];
+static volatile pint    num_freed = 0;
+static volatile pint    publish_done = FALSE;
+static volatile pint    num_torn = 0;
+
+static ppointer
+test_malloc(psize n_bytes)
+{
+    pchar* const block = malloc(n_bytes + TEST_BLOCK_HDR);
+
+    if (NULL == block) {
+        return NULL;
+    }
+
+    *(psize*) block = n_bytes;
+
+    return block + TEST_BLOCK_HDR;
+}
+
+static ppointer
+test_realloc(ppointer mem, psize n_bytes)
+{
+    if (NULL == mem) {
+        return test_malloc(n_bytes);
+    }
+
+    pchar* const block = realloc((pchar*) mem - TEST_BLOCK_HDR, n_bytes + TEST_BLOCK_HDR);
+
+    if (NULL == block) {
+        return NULL;
+    }
+
+    *(psize*) block = n_bytes;
+
+    return block + TEST_BLOCK_HDR;
+}
+
+static void
+test_free(ppointer mem)
+{
+    if (NULL == mem) {
+        return;
+    }
+
+    pchar* const block = (pchar*) mem - TEST_BLOCK_HDR;
+
+    const pint idx = p_atomic_int_add(&num_freed, 1);
+
+    if (idx < TEST_MAX_FREED) {
+        freed[idx] = mem;
+    }
+
+    // a reader still using the block sees garbage
+    memset(mem, 0xA5, *(psize*) block);
+    free(block);
+}
+
+/**
+ * Check whether a block was freed since the log was last cleared.
+ * @param mem: The block.
+ * @returns: TRUE if it was freed, FALSE otherwise.
+ */
+static pboolean
+is_freed(const void* const mem)
+{
+    const pint count = p_atomic_int_get(&num_freed);
+
+    for (pint idx = 0;
+              idx < count && idx < TEST_MAX_FREED;
+              idx++)
+    {
+        if (freed[idx] == mem) {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static void
+clear_freed(void) {
+    p_atomic_int_set(&num_freed, 0);
+}
+
+/**
+ * Publish a configuration whose timeout tells the version it gets.
+ * @param store: The store.
+ * @param version: The version the configuration gets.
+ * @returns: TRUE if successful, FALSE otherwise.
+ */
+static pboolean
+publish_version(struct config_store_t* const store,
+                const puint64                version)
+{
+    static struct config_t cfg;
+
+    cfg.fetch_timeout_us = version * 1000;
+
+    return config_store_publish(store, &cfg);
+}
+
+static void
+test_reclaim_after_unlock(void)
+{
+    struct config_t initial;
+    memset(&initial, 0, sizeof(initial));
+    initial.fetch_timeout_us = 1000;
+
+    struct config_store_t* const store = config_store_create(&initial);
+    PCP_TEST_CHECK(NULL != store);
+
+    const pint reader = config_store_register_reader(store);
+    PCP_TEST_CHECK(0 <= reader);
+
+    const struct config_t* const held = config_store_read_lock(store, reader);
+    PCP_TEST_CHECK(1 == held->version);
+
+    clear_freed();
+
+    // the replaced snapshot stays intact while the reader is inside its section
+    PCP_TEST_CHECK(publish_version(store, 2));
+    PCP_TEST_CHECK(publish_version(store, 3));
+    PCP_TEST_CHECK(!is_freed(held));
+    PCP_TEST_CHECK(1 == held->version);
+    PCP_TEST_CHECK(1000 == held->fetch_timeout_us);
+
+    config_store_read_unlock(store, reader);
+
+    // reclaimed by the next publication, not by the unlock
+    PCP_TEST_CHECK(!is_freed(held));
+    PCP_TEST_CHECK(publish_version(store, 4));
+    PCP_TEST_CHECK(is_freed(held));
+
+    // a reader entering after a publication gets the new snapshot
+    const struct config_t* const current = config_store_read_lock(store, reader);
+    PCP_TEST_CHECK(4 == current->version);
+    PCP_TEST_CHECK(4000 == current->fetch_timeout_us);
+
+    clear_freed();
+    PCP_TEST_CHECK(publish_version(store, 5));
+    PCP_TEST_CHECK(!is_freed(current));
+    PCP_TEST_CHECK(4 == current->version);
+
+    config_store_read_unlock(store, reader);
+
+    PCP_TEST_CHECK(publish_version(store, 6));
+    PCP_TEST_CHECK(is_freed(current));
+
+    config_store_unregister_reader(store, reader);
+    config_store_destroy(store);
+}
+
+static ppointer
+reader_task(ppointer arg)
+{
+    struct config_store_t* const store = (struct config_store_t*) arg;
+
+    const pint reader = config_store_register_reader(store);
+
+    if (0 > reader)
+    {
+        p_atomic_int_inc(&num_torn);
+        return NULL;
+    }
+
+    while (!p_atomic_int_get(&publish_done))
+    {
+        const struct config_t* const cfg = config_store_read_lock(store, reader);
+
+        const puint64 version = cfg->version;
+
+        // give the publisher time to replace the snapshot under the reader
+        for (volatile pint spin = 0; spin < 100; spin++);
+
+        if ((version != cfg->version) ||
+            (version * 1000 != cfg->fetch_timeout_us))
+        {
+            p_atomic_int_inc(&num_torn);
+        }
+
+        config_store_read_unlock(store, reader);
+    }
+
+    config_store_unregister_reader(store, reader);
+
+    return NULL;
+}
+
+static void
+test_concurrent_readers(void)
+{
+    struct config_t initial;
+    memset(&initial, 0, sizeof(initial));
+    initial.fetch_timeout_us = 1000;
+
+    struct config_store_t* const store = config_store_create(&initial);
+    PCP_TEST_CHECK(NULL != store);
+
+    PUThread* readers[TEST_NUM_READERS];
+
+    for (psize idx = 0;
+               idx < TEST_NUM_READERS;
+               idx++)
+    {
+        readers[idx] = p_uthread_create(reader_task, store, TRUE);
+        PCP_TEST_CHECK(NULL != readers[idx]);
+    }
+
+    for (puint64 version = 2;
+                 version < TEST_NUM_PUBLISHED + 2;
+                 version++)
+    {
+        PCP_TEST_CHECK(publish_version(store, version));
+    }
+
+    p_atomic_int_set(&publish_done, TRUE);
+
+    for (psize idx = 0;
+               idx < TEST_NUM_READERS;
+               idx++)
+    {
+        p_uthread_join(readers[idx]);
+        p_uthread_unref(readers[idx]);
+    }
+
+    // a snapshot freed under a reader would be poisoned
+    PCP_TEST_CHECK(0 == p_atomic_int_get(&num_torn));
+
+    config_store_destroy(store);
+}
+
+int
+main(void)
+{
+    const PMemVTable vtable = { test_malloc, test_realloc, test_free };
+
+    p_libsys_init_full(&vtable);
+
+    test_reclaim_after_unlock();
+    test_concurrent_readers();
+
+    p_libsys_shutdown();
+
+    return (TRUE == pcp_test_failed) ? 1 : 0;
+}
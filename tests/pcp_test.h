@@ -0,0 +1,26 @@
+#ifndef _PCP_TEST_H_INCLUDED
+    #define _PCP_TEST_H_INCLUDED
+
+    #include <stdio.h>
+
+    #include "plibsys.h"
+
+    /**
+     * Check a condition, report it and mark the test as failed if it does not hold.
+     * The test keeps running so one run reports every failed check.
+     * @param cond: The condition to check.
+     */
+    #define PCP_TEST_CHECK(cond)                                              \
+        do                                                                    \
+        {                                                                     \
+            if (!(cond))                                                      \
+            {                                                                 \
+                printf("!!! %s:%d: check failed: %s !!!\n",                   \
+                       __FILE__, __LINE__, #cond);                            \
+                pcp_test_failed = TRUE;                                       \
+            }                                                                 \
+        } while (0)
+
+    static pboolean pcp_test_failed = FALSE;
+
+#endif // _PCP_TEST_H_INCLUDED
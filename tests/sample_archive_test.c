@@ -0,0 +1,115 @@
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "sample_archive.h"
+
+#include "pcp_test.h"
+
+#define TEST_ARCHIVE_PATH "pcp_sample_archive_test.arc"
+
+// Samples recorded per sensor, several blocks each with a partially filled last one
+#define TEST_NUM_SAMPLES 1050
+#define TEST_BLOCK_LEN   100
+
+int
+main(void)
+{
+    p_libsys_init();
+
+    static struct sample_record_t recorded[3][TEST_NUM_SAMPLES];
+    psize                         num_recorded[3] = { 0, 0, 0 };
+
+    struct sample_recorder_t* recorder = sample_recorder_create(TEST_ARCHIVE_PATH, TEST_BLOCK_LEN);
+    PCP_TEST_CHECK(NULL != recorder);
+
+    srand(3);
+
+    puint64 ts = 1700000000000000ULL;
+
+    for (psize idx = 0;
+               num_recorded[0] + num_recorded[1] + num_recorded[2] < 3 * TEST_NUM_SAMPLES;
+               idx++)
+    {
+        const puint8 sens_id = (puint8) (1 + rand() % 3);
+
+        // jittered period, and sensor overwrites skipping sample numbers now and then
+        ts += 100000 + rand() % 50;
+
+        psize* const num = &num_recorded[sens_id - 1];
+
+        if (TEST_NUM_SAMPLES == *num) {
+            continue;
+        }
+
+        struct sens_sample_t sample = { 0 };
+
+        sample.sens_id = sens_id;
+        sample.num     = ((0 == *num) ? 0 : recorded[sens_id - 1][*num - 1].sample.num) + 1 + (0 == rand() % 10);
+        sample.val     = (0 == idx % 7) ? (puint32) rand() : (puint32) (idx * 3);
+        sample.ts      = ts;
+
+        PCP_TEST_CHECK(TRUE == sample_recorder_write(recorder, sample, ts));
+
+        recorded[sens_id - 1][*num].ts     = ts;
+        recorded[sens_id - 1][*num].sample = sample;
+        (*num)++;
+    }
+
+    sample_recorder_destroy(recorder);
+
+    struct sample_archive_t* archive = sample_archive_open(TEST_ARCHIVE_PATH);
+    PCP_TEST_CHECK(NULL != archive);
+
+    if (NULL != archive)
+    {
+        PCP_TEST_CHECK(num_recorded[0] + num_recorded[1] + num_recorded[2] == sample_archive_sample_count(archive));
+
+        static struct sample_record_t decoded[TEST_BLOCK_LEN];
+        psize                         num_decoded[3] = { 0, 0, 0 };
+
+        for (psize block_idx = 0;
+                   block_idx < sample_archive_block_count(archive);
+                   block_idx++)
+        {
+            struct sample_archive_block_t block;
+
+            PCP_TEST_CHECK(TRUE == sample_archive_block_info(archive, block_idx, &block));
+            PCP_TEST_CHECK((1 <= block.sens_id) && (block.sens_id <= 3));
+
+            const psize count = sample_archive_decode_block(archive, block_idx, decoded);
+            PCP_TEST_CHECK(count == block.count);
+
+            for (psize idx = 0;
+                       (idx < count) && (num_decoded[block.sens_id - 1] < num_recorded[block.sens_id - 1]);
+                       idx++)
+            {
+                const struct sample_record_t* const expected = &recorded[block.sens_id - 1][num_decoded[block.sens_id - 1]++];
+
+                PCP_TEST_CHECK(expected->ts == decoded[idx].ts);
+                PCP_TEST_CHECK(expected->sample.sens_id == decoded[idx].sample.sens_id);
+                PCP_TEST_CHECK(expected->sample.val == decoded[idx].sample.val);
+                PCP_TEST_CHECK(expected->sample.num == decoded[idx].sample.num);
+                PCP_TEST_CHECK(expected->sample.ts == decoded[idx].sample.ts);
+            }
+
+            PCP_TEST_CHECK(block.first_ts == decoded[0].ts);
+            PCP_TEST_CHECK(block.last_ts == decoded[count - 1].ts);
+            PCP_TEST_CHECK(block.first_num == decoded[0].sample.num);
+        }
+
+        for (puint8 sens_id = 1;
+                    sens_id <= 3;
+                    sens_id++)
+        {
+            PCP_TEST_CHECK(num_recorded[sens_id - 1] == num_decoded[sens_id - 1]);
+        }
+
+        sample_archive_close(archive);
+    }
+
+    unlink(TEST_ARCHIVE_PATH);
+
+    p_libsys_shutdown();
+
+    return (TRUE == pcp_test_failed) ? 1 : 0;
+}
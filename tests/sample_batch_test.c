@@ -0,0 +1,94 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sample_batch.h"
+
+#include "pcp_test.h"
+
+#define TEST_BATCH_LEN 256
+
+int
+main(void)
+{
+    p_libsys_init();
+
+    static struct sens_sample_t samples[TEST_BATCH_LEN + 10];
+    static struct sens_sample_t unpacked[TEST_BATCH_LEN + 10];
+
+    srand(2);
+
+    for (psize idx = 0;
+               idx < TEST_BATCH_LEN + 10;
+               idx++)
+    {
+        samples[idx].sens_id      = (puint8) (1 + rand() % 3);
+        samples[idx].num_absorbed = (puint16) (rand() % 4);
+        samples[idx].val          = (puint32) rand();
+        samples[idx].num          = idx + 1;
+        samples[idx].ts           = (puint64) rand() * 1000;
+    }
+
+    struct sample_batch_t* batch = sample_batch_create(TEST_BATCH_LEN);
+    PCP_TEST_CHECK(NULL != batch);
+
+    // packing stops at the capacity of the batch
+    PCP_TEST_CHECK(100 == sample_batch_pack(batch, samples, 100));
+    PCP_TEST_CHECK(TEST_BATCH_LEN - 100 == sample_batch_pack(batch, &samples[100], TEST_BATCH_LEN));
+    PCP_TEST_CHECK(0 == sample_batch_pack(batch, samples, 1));
+    PCP_TEST_CHECK(TEST_BATCH_LEN == batch->len);
+
+    // unpacking stops at the end of the batch
+    memset(unpacked, 0, sizeof(unpacked));
+
+    PCP_TEST_CHECK(TEST_BATCH_LEN == sample_batch_unpack(batch, 0, TEST_BATCH_LEN + 5, unpacked));
+    PCP_TEST_CHECK(0 == sample_batch_unpack(batch, TEST_BATCH_LEN, 1, &unpacked[TEST_BATCH_LEN]));
+
+    for (psize idx = 0;
+               idx < TEST_BATCH_LEN;
+               idx++)
+    {
+        PCP_TEST_CHECK(samples[idx].sens_id == unpacked[idx].sens_id);
+        PCP_TEST_CHECK(samples[idx].num_absorbed == unpacked[idx].num_absorbed);
+        PCP_TEST_CHECK(samples[idx].val == unpacked[idx].val);
+        PCP_TEST_CHECK(samples[idx].num == unpacked[idx].num);
+        PCP_TEST_CHECK(samples[idx].ts == unpacked[idx].ts);
+    }
+
+    PCP_TEST_CHECK(3 == sample_batch_unpack(batch, 10, 3, unpacked));
+    PCP_TEST_CHECK(samples[12].num == unpacked[2].num);
+
+    // gathering keeps the values of one sensor in batch order
+    static puint32 vals[TEST_BATCH_LEN];
+
+    for (puint8 sens_id = 1;
+                sens_id <= 4;
+                sens_id++)
+    {
+        const psize count = sample_batch_gather(batch, sens_id, vals);
+        psize       pos   = 0;
+
+        for (psize idx = 0;
+                   idx < TEST_BATCH_LEN;
+                   idx++)
+        {
+            if (sens_id == samples[idx].sens_id)
+            {
+                PCP_TEST_CHECK((pos < count) && (samples[idx].val == vals[pos]));
+                pos++;
+            }
+        }
+
+        PCP_TEST_CHECK(pos == count);
+    }
+
+    sample_batch_clear(batch);
+    PCP_TEST_CHECK(0 == batch->len);
+    PCP_TEST_CHECK(0 == sample_batch_gather(batch, 1, vals));
+    PCP_TEST_CHECK(0 == sample_batch_unpack(batch, 0, 1, unpacked));
+
+    sample_batch_destroy(batch);
+
+    p_libsys_shutdown();
+
+    return (TRUE == pcp_test_failed) ? 1 : 0;
+}
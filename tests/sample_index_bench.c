@@ -0,0 +1,259 @@
+#include <stdlib.h>
+
+#include "sample_index.h"
+
+#include "pcp_test.h"
+
+// the size the numbers of the sample index were taken at
+#define BENCH_NUM_RECORDS 1000000
+#define BENCH_NUM_SENSORS 3
+
+#define BENCH_NUM_RANGES      20
+#define BENCH_NUM_MANY_RANGES 100000
+
+// about 100 records of a sensor
+#define BENCH_RANGE_US 100000
+
+#define BENCH_TS_BASE 1000000
+#define BENCH_TS_STEP 1000
+
+struct bench_range_t
+{
+    puint64 from_key;
+    puint64 to_key;
+    psize   count;
+    puint64 sum;
+};
+
+static struct sample_record_t records[BENCH_NUM_RECORDS];
+static struct sample_record_t shuffled[BENCH_NUM_RECORDS];
+
+static puint64
+bench_key(const struct sample_record_t* const record)
+{
+    return ((puint64) record->sample.sens_id << 56) | record->ts;
+}
+
+static pint
+bench_key_compare(pconstpointer left,
+                  pconstpointer right)
+{
+    const puint64 lhs = (puint64) (psize) left;
+    const puint64 rhs = (puint64) (psize) right;
+
+    return (lhs < rhs) ? -1 : (lhs > rhs);
+}
+
+/**
+ * Walk a PTree in order to the end of a range, as it has no range lookup.
+ */
+static pboolean
+bench_tree_range(ppointer key,
+                 ppointer value,
+                 ppointer data)
+{
+    struct bench_range_t* const range = data;
+    const puint64               k     = (puint64) (psize) key;
+
+    if (k > range->to_key) {
+        return TRUE;
+    }
+
+    if (k >= range->from_key)
+    {
+        range->count++;
+        range->sum += ((struct sample_record_t*) value)->sample.val;
+    }
+
+    return FALSE;
+}
+
+static pboolean
+bench_index_range(const struct sample_record_t* const record,
+                        ppointer                      data)
+{
+    struct bench_range_t* const range = data;
+
+    range->count++;
+    range->sum += record->sample.val;
+
+    return TRUE;
+}
+
+static puint64
+bench_random_from_ts(void)
+{
+    return BENCH_TS_BASE + (puint64) (rand() % (BENCH_NUM_RECORDS / BENCH_NUM_SENSORS)) * BENCH_TS_STEP;
+}
+
+/**
+ * Insert the records into a PTree keyed by sensor ID and collection time, and
+ * run range queries on it.
+ * @param type: The tree type.
+ * @param name: The tree name to print.
+ * @param input: The records in insertion order.
+ * @param order: The insertion order to print.
+ */
+static void
+bench_tree(const PTreeType                     type,
+           const pchar*                  const name,
+           const struct sample_record_t* const input,
+           const pchar*                  const order)
+{
+    PTimeProfiler* const profiler = p_time_profiler_new();
+    PTree* const         tree     = p_tree_new(type, bench_key_compare);
+
+    for (psize idx = 0;
+               idx < BENCH_NUM_RECORDS;
+               idx++)
+    {
+        p_tree_insert(tree, (ppointer) (psize) bench_key(&input[idx]), (ppointer) &input[idx]);
+    }
+
+    const puint64 insert_us = p_time_profiler_elapsed_usecs(profiler);
+    p_time_profiler_reset(profiler);
+
+    struct bench_range_t range = { 0, 0, 0, 0 };
+
+    for (psize idx = 0;
+               idx < BENCH_NUM_RANGES;
+               idx++)
+    {
+        const puint64 from_ts = bench_random_from_ts();
+
+        range.from_key = ((puint64) 2 << 56) | from_ts;
+        range.to_key   = ((puint64) 2 << 56) | (from_ts + BENCH_RANGE_US);
+
+        p_tree_foreach(tree, bench_tree_range, &range);
+    }
+
+    printf("PTree %s, %s: insert %.3f s, %d ranges %.3f ms (%lu records)\n",
+           name,
+           order,
+           insert_us / 1e6,
+           BENCH_NUM_RANGES,
+           p_time_profiler_elapsed_usecs(profiler) / 1e3,
+           range.count);
+
+    p_tree_free(tree);
+    p_time_profiler_free(profiler);
+}
+
+/**
+ * Insert the records into a sample index one by one, and run range queries on it.
+ * @param input: The records in insertion order.
+ * @param order: The insertion order to print.
+ */
+static void
+bench_index(const struct sample_record_t* const input,
+            const pchar*                  const order)
+{
+    PTimeProfiler* const         profiler = p_time_profiler_new();
+    struct sample_index_t* const index    = sample_index_create();
+
+    for (psize idx = 0;
+               idx < BENCH_NUM_RECORDS;
+               idx++)
+    {
+        PCP_TEST_CHECK(sample_index_insert(index, &input[idx]));
+    }
+
+    const puint64 insert_us = p_time_profiler_elapsed_usecs(profiler);
+    p_time_profiler_reset(profiler);
+
+    struct bench_range_t range = { 0, 0, 0, 0 };
+
+    for (psize idx = 0;
+               idx < BENCH_NUM_RANGES;
+               idx++)
+    {
+        const puint64 from_ts = bench_random_from_ts();
+
+        sample_index_range(index, 2, from_ts, from_ts + BENCH_RANGE_US, bench_index_range, &range);
+    }
+
+    const puint64 ranges_us = p_time_profiler_elapsed_usecs(profiler);
+    p_time_profiler_reset(profiler);
+
+    for (psize idx = 0;
+               idx < BENCH_NUM_MANY_RANGES;
+               idx++)
+    {
+        const puint64 from_ts = bench_random_from_ts();
+
+        sample_index_range(index, 2, from_ts, from_ts + BENCH_RANGE_US, bench_index_range, &range);
+    }
+
+    printf("sample index, %s: insert %.3f s, %d ranges %.3f ms, %d ranges %.3f s (%lu records)\n",
+           order,
+           insert_us / 1e6,
+           BENCH_NUM_RANGES,
+           ranges_us / 1e3,
+           BENCH_NUM_MANY_RANGES,
+           p_time_profiler_elapsed_usecs(profiler) / 1e6,
+           range.count);
+
+    sample_index_destroy(index);
+    p_time_profiler_free(profiler);
+}
+
+/**
+ * Compare the sample index with PTree on 1M records of 3 sensors. Not run as a
+ * test, build it in release mode and run it by hand.
+ */
+int
+main(void)
+{
+    p_libsys_init();
+
+    srand(1);
+
+    for (psize idx = 0;
+               idx < BENCH_NUM_RECORDS;
+               idx++)
+    {
+        records[idx].ts             = BENCH_TS_BASE + (idx / BENCH_NUM_SENSORS) * BENCH_TS_STEP + idx % BENCH_NUM_SENSORS;
+        records[idx].sample.sens_id = (puint8) (1 + idx % BENCH_NUM_SENSORS);
+        records[idx].sample.val     = (puint32) rand();
+        records[idx].sample.num     = idx / BENCH_NUM_SENSORS + 1;
+        records[idx].sample.ts      = records[idx].ts;
+
+        shuffled[idx] = records[idx];
+    }
+
+    for (psize idx = BENCH_NUM_RECORDS - 1;
+               idx > 0;
+               idx--)
+    {
+        const psize other = (psize) rand() % (idx + 1);
+        const struct sample_record_t tmp = shuffled[idx];
+
+        shuffled[idx]   = shuffled[other];
+        shuffled[other] = tmp;
+    }
+
+    bench_tree(P_TREE_TYPE_RB, "RB", records, "in order");
+    bench_tree(P_TREE_TYPE_AVL, "AVL", records, "in order");
+    bench_index(records, "in order");
+
+    bench_tree(P_TREE_TYPE_RB, "RB", shuffled, "random");
+    bench_tree(P_TREE_TYPE_AVL, "AVL", shuffled, "random");
+    bench_index(shuffled, "random");
+
+    PTimeProfiler* const         profiler = p_time_profiler_new();
+    struct sample_index_t* const index    = sample_index_create();
+
+    PCP_TEST_CHECK(sample_index_bulk_load(index, shuffled, BENCH_NUM_RECORDS));
+
+    printf("sample index, bulk load of random records: %.3f s\n",
+           p_time_profiler_elapsed_usecs(profiler) / 1e6);
+
+    PCP_TEST_CHECK(BENCH_NUM_RECORDS == sample_index_count(index));
+
+    sample_index_destroy(index);
+    p_time_profiler_free(profiler);
+
+    p_libsys_shutdown();
+
+    return (TRUE == pcp_test_failed) ? 1 : 0;
+}
@@ -0,0 +1,406 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "sample_index.h"
+
+#include "pcp_test.h"
+
+// many blocks per sensor, so inserts split full blocks all over the index
+#define TEST_NUM_RECORDS 6300
+#define TEST_NUM_SENSORS 3
+
+// every (sensor, time) key occurs this many times
+#define TEST_NUM_DUPS    3
+
+// more records with one key than fit into a block
+#define TEST_NUM_SAME    (SAMPLE_INDEX_BLOCK_LEN * 2 + 5)
+
+#define TEST_NUM_RANGES  2000
+
+// collection times are spaced out so there are gaps between them
+#define TEST_TS_BASE     1000
+#define TEST_TS_STEP     10
+
+static struct sample_record_t records[TEST_NUM_RECORDS];
+static struct sample_record_t inserted[TEST_NUM_RECORDS];
+static struct sample_record_t expected[TEST_NUM_RECORDS];
+
+struct visit_t
+{
+    const struct sample_record_t* expected;
+    psize                         count;
+    psize                         num_visited;
+    pboolean                      is_ok;
+};
+
+/**
+ * Order records by sensor ID and collection time, then by sample number, which
+ * tells the order they were added in.
+ */
+static int
+record_compare(const void* const left,
+               const void* const right)
+{
+    const struct sample_record_t* const lhs = left;
+    const struct sample_record_t* const rhs = right;
+
+    if (lhs->sample.sens_id != rhs->sample.sens_id) {
+        return (lhs->sample.sens_id < rhs->sample.sens_id) ? -1 : 1;
+    }
+
+    if (lhs->ts != rhs->ts) {
+        return (lhs->ts < rhs->ts) ? -1 : 1;
+    }
+
+    return (lhs->sample.num < rhs->sample.num) ? -1 : (lhs->sample.num > rhs->sample.num);
+}
+
+static pboolean
+visit_record(const struct sample_record_t* const record,
+                   ppointer                      data)
+{
+    struct visit_t* const visit = data;
+
+    if ((visit->num_visited >= visit->count) ||
+        (0 != memcmp(record, &visit->expected[visit->num_visited], sizeof(*record))))
+    {
+        visit->is_ok = FALSE;
+    }
+
+    visit->num_visited++;
+
+    return TRUE;
+}
+
+static pboolean
+stop_at_first(const struct sample_record_t* const record,
+                    ppointer                      data)
+{
+    P_UNUSED(record);
+
+    (*(psize*) data)++;
+
+    return FALSE;
+}
+
+/**
+ * Fill the records, each key TEST_NUM_DUPS times, in order.
+ */
+static void
+make_records(void)
+{
+    memset(records, 0, sizeof(records));
+
+    for (psize idx = 0;
+               idx < TEST_NUM_RECORDS;
+               idx++)
+    {
+        const psize key_idx = idx / TEST_NUM_DUPS;
+
+        records[idx].sample.sens_id = (puint8) (1 + key_idx % TEST_NUM_SENSORS);
+        records[idx].sample.val     = (puint32) rand();
+        records[idx].ts             = TEST_TS_BASE + (key_idx / TEST_NUM_SENSORS) * TEST_TS_STEP;
+        records[idx].sample.ts      = records[idx].ts;
+    }
+}
+
+static void
+shuffle_records(void)
+{
+    for (psize idx = TEST_NUM_RECORDS - 1;
+               idx > 0;
+               idx--)
+    {
+        const psize other = (psize) rand() % (idx + 1);
+        const struct sample_record_t tmp = records[idx];
+
+        records[idx]   = records[other];
+        records[other] = tmp;
+    }
+}
+
+/**
+ * Number the records in the order they are added, and sort a copy of them the
+ * way the index has to return them.
+ * @param count: The number of records.
+ */
+static void
+number_records(const psize count)
+{
+    for (psize idx = 0;
+               idx < count;
+               idx++)
+    {
+        records[idx].sample.num = idx;
+    }
+
+    memcpy(inserted, records, sizeof(struct sample_record_t) * count);
+    memcpy(expected, records, sizeof(struct sample_record_t) * count);
+    qsort(expected, count, sizeof(struct sample_record_t), record_compare);
+}
+
+/**
+ * Check a range of the index against a scan over the expected records.
+ * @param index: The index.
+ * @param count: The number of expected records.
+ * @param sens_id: The sensor ID of the range.
+ * @param from_ts: The earliest collection time of the range.
+ * @param to_ts: The latest collection time of the range.
+ */
+static void
+check_range(const struct sample_index_t* const index,
+            const psize                        count,
+            const puint8                       sens_id,
+            const puint64                      from_ts,
+            const puint64                      to_ts)
+{
+    psize first = 0;
+
+    while ((first < count) &&
+           ((expected[first].sample.sens_id < sens_id) ||
+            ((expected[first].sample.sens_id == sens_id) && (expected[first].ts < from_ts))))
+    {
+        first++;
+    }
+
+    psize last = first;
+
+    while ((last < count) &&
+           (expected[last].sample.sens_id == sens_id) &&
+           (expected[last].ts <= to_ts))
+    {
+        last++;
+    }
+
+    struct visit_t visit = { &expected[first], last - first, 0, TRUE };
+
+    const psize num_visited = sample_index_range(index, sens_id, from_ts, to_ts, visit_record, &visit);
+
+    if (!visit.is_ok ||
+        (num_visited != last - first) ||
+        (visit.num_visited != last - first))
+    {
+        printf("!!! sensor %u from %lu to %lu: %lu records, expected %lu !!!\n",
+               sens_id,
+               from_ts,
+               to_ts,
+               num_visited,
+               last - first);
+
+        pcp_test_failed = TRUE;
+    }
+
+    PCP_TEST_CHECK(num_visited == sample_index_range(index, sens_id, from_ts, to_ts, NULL, NULL));
+}
+
+/**
+ * Check every sensor as a whole, and random ranges with boundaries on, next to
+ * and between the collection times of the records.
+ * @param index: The index.
+ * @param count: The number of expected records.
+ */
+static void
+check_index(const struct sample_index_t* const index,
+            const psize                        count)
+{
+    PCP_TEST_CHECK(count == sample_index_count(index));
+
+    for (puint8 sens_id = 1;
+                sens_id <= TEST_NUM_SENSORS;
+                sens_id++)
+    {
+        check_range(index, count, sens_id, 0, ~0ULL);
+    }
+
+    const puint64 max_ts = TEST_TS_BASE + (TEST_NUM_RECORDS / TEST_NUM_DUPS / TEST_NUM_SENSORS) * TEST_TS_STEP;
+
+    for (psize idx = 0;
+               idx < TEST_NUM_RANGES;
+               idx++)
+    {
+        const puint8  sens_id = (puint8) (1 + rand() % TEST_NUM_SENSORS);
+        const puint64 from_ts = TEST_TS_BASE - TEST_TS_STEP + (puint64) rand() % (max_ts - TEST_TS_BASE + 2 * TEST_TS_STEP);
+        const puint64 to_ts   = from_ts + (puint64) rand() % (40 * TEST_TS_STEP);
+
+        check_range(index, count, sens_id, from_ts, to_ts);
+    }
+}
+
+static void
+test_insert_sorted(void)
+{
+    make_records();
+    number_records(TEST_NUM_RECORDS);
+
+    struct sample_index_t* const index = sample_index_create();
+    PCP_TEST_CHECK(NULL != index);
+
+    for (psize idx = 0;
+               idx < TEST_NUM_RECORDS;
+               idx++)
+    {
+        PCP_TEST_CHECK(sample_index_insert(index, &inserted[idx]));
+    }
+
+    check_index(index, TEST_NUM_RECORDS);
+
+    sample_index_destroy(index);
+}
+
+static void
+test_insert_random(void)
+{
+    make_records();
+    shuffle_records();
+    number_records(TEST_NUM_RECORDS);
+
+    struct sample_index_t* const index = sample_index_create();
+    PCP_TEST_CHECK(NULL != index);
+
+    for (psize idx = 0;
+               idx < TEST_NUM_RECORDS;
+               idx++)
+    {
+        PCP_TEST_CHECK(sample_index_insert(index, &inserted[idx]));
+
+        // check while the blocks are still being split
+        if (0 == (idx + 1) % (TEST_NUM_RECORDS / 4)) {
+            memcpy(expected, inserted, sizeof(struct sample_record_t) * (idx + 1));
+            qsort(expected, idx + 1, sizeof(struct sample_record_t), record_compare);
+            check_index(index, idx + 1);
+        }
+    }
+
+    sample_index_destroy(index);
+}
+
+static void
+test_same_key(void)
+{
+    struct sample_index_t* const index = sample_index_create();
+    PCP_TEST_CHECK(NULL != index);
+
+    memset(records, 0, sizeof(records));
+
+    // a neighbour on each side, then a run of equal keys across several blocks
+    for (psize idx = 0;
+               idx < TEST_NUM_SAME + 2;
+               idx++)
+    {
+        records[idx].sample.sens_id = 2;
+        records[idx].sample.val     = (puint32) idx;
+        records[idx].ts             = TEST_TS_BASE;
+    }
+
+    records[TEST_NUM_SAME].ts     = TEST_TS_BASE - 1;
+    records[TEST_NUM_SAME + 1].ts = TEST_TS_BASE + 1;
+
+    number_records(TEST_NUM_SAME + 2);
+
+    for (psize idx = 0;
+               idx < TEST_NUM_SAME + 2;
+               idx++)
+    {
+        PCP_TEST_CHECK(sample_index_insert(index, &inserted[idx]));
+    }
+
+    check_range(index, TEST_NUM_SAME + 2, 2, TEST_TS_BASE, TEST_TS_BASE);
+    check_range(index, TEST_NUM_SAME + 2, 2, 0, ~0ULL);
+    PCP_TEST_CHECK(TEST_NUM_SAME == sample_index_range(index, 2, TEST_TS_BASE, TEST_TS_BASE, NULL, NULL));
+
+    sample_index_destroy(index);
+}
+
+static void
+test_bulk_load(void)
+{
+    make_records();
+    shuffle_records();
+    number_records(TEST_NUM_RECORDS);
+
+    // into an empty index the records are sorted and packed
+    struct sample_index_t* const index = sample_index_create();
+    PCP_TEST_CHECK(NULL != index);
+
+    PCP_TEST_CHECK(sample_index_bulk_load(index, inserted, 0));
+    PCP_TEST_CHECK(0 == sample_index_count(index));
+
+    PCP_TEST_CHECK(sample_index_bulk_load(index, inserted, TEST_NUM_RECORDS));
+    check_index(index, TEST_NUM_RECORDS);
+
+    sample_index_destroy(index);
+
+    // into a filled one they are inserted one by one
+    struct sample_index_t* const filled = sample_index_create();
+    PCP_TEST_CHECK(NULL != filled);
+
+    PCP_TEST_CHECK(sample_index_bulk_load(filled, inserted, TEST_NUM_RECORDS / 3));
+    PCP_TEST_CHECK(sample_index_bulk_load(filled,
+                                          inserted + TEST_NUM_RECORDS / 3,
+                                          TEST_NUM_RECORDS - TEST_NUM_RECORDS / 3));
+    check_index(filled, TEST_NUM_RECORDS);
+
+    sample_index_destroy(filled);
+}
+
+static void
+test_boundaries(void)
+{
+    make_records();
+    number_records(TEST_NUM_RECORDS);
+
+    struct sample_index_t* const index = sample_index_create();
+    PCP_TEST_CHECK(NULL != index);
+
+    // nothing to find in an empty index
+    PCP_TEST_CHECK(0 == sample_index_range(index, 1, 0, ~0ULL, NULL, NULL));
+
+    PCP_TEST_CHECK(sample_index_bulk_load(index, inserted, TEST_NUM_RECORDS));
+
+    const puint64 last_ts = TEST_TS_BASE + (TEST_NUM_RECORDS / TEST_NUM_DUPS / TEST_NUM_SENSORS - 1) * TEST_TS_STEP;
+
+    // both ends are included
+    PCP_TEST_CHECK(TEST_NUM_DUPS == sample_index_range(index, 1, TEST_TS_BASE, TEST_TS_BASE, NULL, NULL));
+    PCP_TEST_CHECK(2 * TEST_NUM_DUPS == sample_index_range(index, 1, TEST_TS_BASE, TEST_TS_BASE + TEST_TS_STEP, NULL, NULL));
+    PCP_TEST_CHECK(TEST_NUM_DUPS == sample_index_range(index, 1, TEST_TS_BASE + 1, TEST_TS_BASE + TEST_TS_STEP, NULL, NULL));
+    PCP_TEST_CHECK(TEST_NUM_DUPS == sample_index_range(index, 1, TEST_TS_BASE, TEST_TS_BASE + TEST_TS_STEP - 1, NULL, NULL));
+    PCP_TEST_CHECK(TEST_NUM_DUPS == sample_index_range(index, TEST_NUM_SENSORS, last_ts, ~0ULL, NULL, NULL));
+
+    // a range does not run into the next or the previous sensor
+    check_range(index, TEST_NUM_RECORDS, 2, last_ts, ~0ULL);
+    check_range(index, TEST_NUM_RECORDS, 2, 0, TEST_TS_BASE);
+
+    // empty ranges
+    PCP_TEST_CHECK(0 == sample_index_range(index, 1, TEST_TS_BASE + 1, TEST_TS_BASE + TEST_TS_STEP - 1, NULL, NULL));
+    PCP_TEST_CHECK(0 == sample_index_range(index, 1, 0, TEST_TS_BASE - 1, NULL, NULL));
+    PCP_TEST_CHECK(0 == sample_index_range(index, 1, last_ts + 1, ~0ULL, NULL, NULL));
+    PCP_TEST_CHECK(0 == sample_index_range(index, 1, TEST_TS_BASE + TEST_TS_STEP, TEST_TS_BASE, NULL, NULL));
+    PCP_TEST_CHECK(0 == sample_index_range(index, 0, 0, ~0ULL, NULL, NULL));
+    PCP_TEST_CHECK(0 == sample_index_range(index, TEST_NUM_SENSORS + 1, 0, ~0ULL, NULL, NULL));
+    PCP_TEST_CHECK(0 == sample_index_range(index, 1, ~0ULL, ~0ULL, NULL, NULL));
+
+    // the walk stops as soon as the function asks to
+    psize num_called = 0;
+    PCP_TEST_CHECK(1 == sample_index_range(index, 1, 0, ~0ULL, stop_at_first, &num_called));
+    PCP_TEST_CHECK(1 == num_called);
+
+    sample_index_destroy(index);
+}
+
+int
+main(void)
+{
+    p_libsys_init();
+
+    srand(7);
+
+    test_insert_sorted();
+    test_insert_random();
+    test_same_key();
+    test_bulk_load();
+    test_boundaries();
+
+    p_libsys_shutdown();
+
+    return (TRUE == pcp_test_failed) ? 1 : 0;
+}
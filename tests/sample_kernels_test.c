@@ -0,0 +1,146 @@
+#include <string.h>
+
+#include "sample_kernels.h"
+
+#include "pcp_test.h"
+
+// enough for a few full AVX2 blocks and every partial tail
+#define TEST_MAX_COUNT 67
+
+#define TEST_SCALE  0.001f
+#define TEST_OFFSET (-3.5f)
+
+static const puint32 edge_vals[] = { 0x00000000, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF };
+
+static puint32 vals[TEST_MAX_COUNT + 1];
+static pfloat  scaled[TEST_MAX_COUNT];
+static pfloat  scaled_ref[TEST_MAX_COUNT];
+
+/**
+ * Compare the kernels of an instruction set with a plain loop over the values.
+ * @param level: The instruction set.
+ * @param vals: The values.
+ * @param count: The number of values.
+ * @param threshold: The threshold of sample_kernels_count_above().
+ */
+static void
+check_kernels(const sample_kernels_level       level,
+              const puint32*             const vals,
+              const psize                      count,
+              const puint32                    threshold)
+{
+    puint64 sum       = 0;
+    psize   num_above = 0;
+
+    for (psize idx = 0;
+               idx < count;
+               idx++)
+    {
+        sum       += vals[idx];
+        num_above += (vals[idx] > threshold);
+        scaled_ref[idx] = (pfloat) vals[idx] * TEST_SCALE + TEST_OFFSET;
+    }
+
+    PCP_TEST_CHECK(sample_kernels_select(level));
+
+    const puint64 level_sum       = sample_kernels_sum(vals, count);
+    const psize   level_num_above = sample_kernels_count_above(vals, count, threshold);
+
+    sample_kernels_scale(vals, count, TEST_SCALE, TEST_OFFSET, scaled);
+
+    if ((sum != level_sum) ||
+        (num_above != level_num_above) ||
+        (0 != memcmp(scaled, scaled_ref, count * sizeof(pfloat))))
+    {
+        printf("!!! %s kernels differ: %lu values, threshold 0x%08X, sum %lu/%lu, above %lu/%lu !!!\n",
+               sample_kernels_level_name(level),
+               count,
+               threshold,
+               level_sum,
+               sum,
+               level_num_above,
+               num_above);
+
+        pcp_test_failed = TRUE;
+    }
+}
+
+/**
+ * Run the checks on every instruction set the CPU supports and every count up
+ * to TEST_MAX_COUNT, from an aligned and a misaligned start.
+ * @param threshold: The threshold of sample_kernels_count_above().
+ */
+static void
+check_all_levels(const puint32 threshold)
+{
+    for (sample_kernels_level level = SAMPLE_KERNELS_SCALAR;
+                              level <= sample_kernels_detect();
+                              level++)
+    {
+        for (psize count = 0;
+                   count <= TEST_MAX_COUNT;
+                   count++)
+        {
+            check_kernels(level, vals, count, threshold);
+
+            if (count < TEST_MAX_COUNT) {
+                check_kernels(level, vals + 1, count, threshold);
+            }
+        }
+    }
+}
+
+int
+main(void)
+{
+    p_libsys_init();
+
+    sample_kernels_level level;
+
+    PCP_TEST_CHECK(sample_kernels_level_from_name("scalar", &level));
+    PCP_TEST_CHECK(SAMPLE_KERNELS_SCALAR == level);
+    PCP_TEST_CHECK(!sample_kernels_level_from_name("avx512", &level));
+
+    printf("Checking the kernels up to %s\n", sample_kernels_level_name(sample_kernels_detect()));
+
+    // the edge values, in every lane
+    for (psize idx = 0;
+               idx <= TEST_MAX_COUNT;
+               idx++)
+    {
+        vals[idx] = edge_vals[(idx * 3 + idx / 4) % 4];
+    }
+
+    for (psize edge = 0;
+               edge < sizeof(edge_vals) / sizeof(edge_vals[0]);
+               edge++)
+    {
+        check_all_levels(edge_vals[edge]);
+    }
+
+    // every value of a run is at the threshold or one off, around each edge
+    for (psize edge = 0;
+               edge < sizeof(edge_vals) / sizeof(edge_vals[0]);
+               edge++)
+    {
+        const puint32 threshold = edge_vals[edge];
+
+        for (psize idx = 0;
+                   idx <= TEST_MAX_COUNT;
+                   idx++)
+        {
+            // wraps around at 0 and 0xFFFFFFFF, giving the other edge
+            vals[idx] = threshold + (puint32) (idx % 3) - 1;
+        }
+
+        check_all_levels(threshold);
+        check_all_levels(threshold - 1);
+        check_all_levels(threshold + 1);
+    }
+
+    PCP_TEST_CHECK(sample_kernels_select(SAMPLE_KERNELS_SCALAR));
+
+    p_libsys_shutdown();
+
+    return (TRUE == pcp_test_failed) ? 1 : 0;
+}
@@ -0,0 +1,417 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sample_spill.h"
+
+#include "pcp_test.h"
+
+#define TEST_SPILL_PATH "pcp_sample_spill_test.seg"
+
+// samples appended by one thread while another one takes them, across many commits
+#define TEST_NUM_CONCURRENT 100000
+
+/**
+ * Take every sample left in a segment and check that each sensor's samples come
+ * out in increasing num order.
+ * @param spill: A pointer to the spill segment instance.
+ * @param last_num: The last num seen for every sensor, updated while taking.
+ * @returns: The number of samples taken.
+ */
+static psize
+take_in_order(struct sample_spill_t* const spill,
+              psize*                 const last_num)
+{
+    struct sens_sample_t sample;
+    psize                num_taken = 0;
+
+    while (sample_spill_take(spill, &sample))
+    {
+        PCP_TEST_CHECK(last_num[sample.sens_id - 1] < sample.num);
+
+        last_num[sample.sens_id - 1] = sample.num;
+        num_taken++;
+    }
+
+    return num_taken;
+}
+
+static ppointer
+append_task(ppointer arg)
+{
+    struct sample_spill_t* const spill = (struct sample_spill_t*) arg;
+
+    for (psize num = 1;
+               num <= TEST_NUM_CONCURRENT;
+               num++)
+    {
+        const struct sens_sample_t sample = { .sens_id = 1, .val = (puint32) num, .num = num };
+
+        while (!sample_spill_append(spill, sample)) {
+            p_uthread_yield();
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Write a segment file laid out as a version 1 segment, full of records of
+ * sensor 2 numbered from 1.
+ * @param version: The version stored in the header.
+ * @param capacity: The number of records.
+ * @param next_in: The next_in cursor stored in the header.
+ * @param taken: The next_out cursor stored in the header.
+ */
+static void
+write_v1_segment(const puint32 version,
+                 const puint64 capacity,
+                 const puint64 next_in,
+                 const puint64 taken)
+{
+    const struct
+    {
+        puint32 magic;
+        puint32 version;
+        puint64 capacity;
+        puint64 next_in;
+        puint64 next_out;
+        puint8  reserved[32];
+    } hdr = { 0x53504350, version, capacity, next_in, taken, { 0 } };
+
+    FILE* const file = fopen(TEST_SPILL_PATH, "wb");
+    PCP_TEST_CHECK(NULL != file);
+    PCP_TEST_CHECK(1 == fwrite(&hdr, sizeof(hdr), 1, file));
+
+    for (puint64 idx = 0;
+                 idx < capacity;
+                 idx++)
+    {
+        const struct
+        {
+            puint32 sens_id;
+            puint32 val;
+            puint64 num;
+        } rec = { 2, (puint32) (1000 + idx), 1 + idx };
+
+        PCP_TEST_CHECK(1 == fwrite(&rec, sizeof(rec), 1, file));
+    }
+
+    fclose(file);
+}
+
+/**
+ * Run one stop: the sensors produce samples 'first' to 'first + count - 1', the
+ * consumer handles 'handled' of them from the queue, the queue holds the next
+ * 'queued' ones when collection stops and the rest went to the spill segment.
+ * As at shutdown, the queue backlog is then put in front of the pending records.
+ */
+static void
+stop_with_backlog(struct sample_spill_t* const spill,
+                  const psize                  first,
+                  const psize                  count,
+                  const psize                  handled,
+                  const psize                  queued)
+{
+    struct sens_sample_t backlog[3 * 64];
+    psize                backlog_len = 0;
+
+    for (psize num = first;
+               num < first + count;
+               num++)
+    {
+        for (puint8 sens_id = 1;
+                    sens_id <= 3;
+                    sens_id++)
+        {
+            const struct sens_sample_t sample = { .sens_id = sens_id, .val = (puint32) num, .num = num };
+
+            if (num < first + handled) {
+                continue;
+            }
+
+            if (num < first + handled + queued) {
+                backlog[backlog_len++] = sample;
+            } else {
+                PCP_TEST_CHECK(TRUE == sample_spill_append(spill, sample));
+            }
+        }
+    }
+
+    PCP_TEST_CHECK(backlog_len == sample_spill_prepend(spill, backlog, backlog_len));
+}
+
+int
+main(void)
+{
+    p_libsys_init();
+
+    unlink(TEST_SPILL_PATH);
+
+    psize last_num[3] = {0, 0, 0};
+
+    // first run: the backlog goes in front of the records spilled after it
+    struct sample_spill_t* spill = sample_spill_open(TEST_SPILL_PATH, 256);
+    PCP_TEST_CHECK(NULL != spill);
+
+    stop_with_backlog(spill, 1, 40, 5, 10);
+    PCP_TEST_CHECK(3 * 35 == sample_spill_pending(spill));
+    sample_spill_close(spill);
+
+    // second run: replay part of it and stop again
+    spill = sample_spill_open(TEST_SPILL_PATH, 256);
+    PCP_TEST_CHECK(NULL != spill);
+    PCP_TEST_CHECK(3 * 35 == sample_spill_pending(spill));
+
+    struct sens_sample_t sample;
+
+    for (psize idx = 0;
+               idx < 3 * 20;
+               idx++)
+    {
+        PCP_TEST_CHECK(TRUE == sample_spill_take(spill, &sample));
+        PCP_TEST_CHECK(last_num[sample.sens_id - 1] < sample.num);
+
+        last_num[sample.sens_id - 1] = sample.num;
+    }
+
+    sample_spill_close(spill);
+
+    // third run: the rest is replayed in order
+    spill = sample_spill_open(TEST_SPILL_PATH, 256);
+    PCP_TEST_CHECK(NULL != spill);
+    PCP_TEST_CHECK(3 * 15 == take_in_order(spill, last_num));
+    sample_spill_close(spill);
+
+    for (puint8 sens_id = 1;
+                sens_id <= 3;
+                sens_id++)
+    {
+        PCP_TEST_CHECK(40 == last_num[sens_id - 1]);
+    }
+
+    unlink(TEST_SPILL_PATH);
+
+    // samples put in front reuse the room of the records already taken
+    spill = sample_spill_open(TEST_SPILL_PATH, 8);
+    PCP_TEST_CHECK(NULL != spill);
+
+    for (psize num = 5;
+               num <= 10;
+               num++)
+    {
+        PCP_TEST_CHECK(TRUE == sample_spill_append(spill, (struct sens_sample_t) { .sens_id = 1, .val = (puint32) num, .num = num }));
+    }
+
+    PCP_TEST_CHECK(TRUE == sample_spill_take(spill, &sample));
+    PCP_TEST_CHECK(TRUE == sample_spill_take(spill, &sample));
+
+    const struct sens_sample_t front[2] = { { .sens_id = 1, .val = 3, .num = 3, .num_absorbed = 2 },
+                                            { .sens_id = 1, .val = 4, .num = 4 } };
+
+    PCP_TEST_CHECK(2 == sample_spill_prepend(spill, front, 2));
+    sample_spill_close(spill);
+
+    spill = sample_spill_open(TEST_SPILL_PATH, 8);
+    PCP_TEST_CHECK(NULL != spill);
+    PCP_TEST_CHECK(TRUE == sample_spill_take(spill, &sample));
+    PCP_TEST_CHECK(3 == sample.num);
+    PCP_TEST_CHECK(2 == sample.num_absorbed);
+    PCP_TEST_CHECK(TRUE == sample_spill_take(spill, &sample));
+    PCP_TEST_CHECK(4 == sample.num);
+    PCP_TEST_CHECK(TRUE == sample_spill_take(spill, &sample));
+    PCP_TEST_CHECK(7 == sample.num);
+    sample_spill_close(spill);
+
+    unlink(TEST_SPILL_PATH);
+
+    // a backlog larger than the room left keeps its newest samples only
+    spill = sample_spill_open(TEST_SPILL_PATH, 8);
+    PCP_TEST_CHECK(NULL != spill);
+
+    struct sens_sample_t backlog[8];
+
+    for (psize num = 1;
+               num <= 8;
+               num++)
+    {
+        backlog[num - 1] = (struct sens_sample_t) { .sens_id = 1, .val = (puint32) num, .num = num };
+    }
+
+    PCP_TEST_CHECK(TRUE == sample_spill_append(spill, (struct sens_sample_t) { .sens_id = 1, .val = 9, .num = 9 }));
+    PCP_TEST_CHECK(TRUE == sample_spill_append(spill, (struct sens_sample_t) { .sens_id = 1, .val = 10, .num = 10 }));
+    PCP_TEST_CHECK(6 == sample_spill_prepend(spill, backlog, 8));
+    sample_spill_close(spill);
+
+    spill = sample_spill_open(TEST_SPILL_PATH, 8);
+    PCP_TEST_CHECK(NULL != spill);
+
+    last_num[0] = 2;
+    PCP_TEST_CHECK(8 == take_in_order(spill, last_num));
+    PCP_TEST_CHECK(10 == last_num[0]);
+    sample_spill_close(spill);
+
+    unlink(TEST_SPILL_PATH);
+
+    // the records taken free their slots while others are pending, the ring wraps around
+    spill = sample_spill_open(TEST_SPILL_PATH, 8);
+    PCP_TEST_CHECK(NULL != spill);
+
+    psize next_num = 1;
+
+    for (psize round = 0;
+               round < 5;
+               round++)
+    {
+        while (sample_spill_append(spill, (struct sens_sample_t) { .sens_id = 3, .val = (puint32) next_num, .num = next_num })) {
+            next_num++;
+        }
+
+        PCP_TEST_CHECK(8 == sample_spill_pending(spill));
+
+        for (psize idx = 0;
+                   idx < 5;
+                   idx++)
+        {
+            PCP_TEST_CHECK(TRUE == sample_spill_take(spill, &sample));
+            PCP_TEST_CHECK(3 == sample.sens_id);
+            PCP_TEST_CHECK(next_num - 8 + idx == sample.num);
+        }
+    }
+
+    sample_spill_close(spill);
+
+    spill = sample_spill_open(TEST_SPILL_PATH, 8);
+    PCP_TEST_CHECK(NULL != spill);
+    PCP_TEST_CHECK(3 == sample_spill_pending(spill));
+
+    last_num[2] = next_num - 4;
+    PCP_TEST_CHECK(3 == take_in_order(spill, last_num));
+    PCP_TEST_CHECK(next_num - 1 == last_num[2]);
+    sample_spill_close(spill);
+
+    unlink(TEST_SPILL_PATH);
+
+    // a full group is committed in the background, without a call to commit
+    spill = sample_spill_open(TEST_SPILL_PATH, 256);
+    PCP_TEST_CHECK(NULL != spill);
+
+    for (psize num = 1;
+               num <= 2 * SAMPLE_SPILL_GROUP_COMMIT;
+               num++)
+    {
+        PCP_TEST_CHECK(TRUE == sample_spill_append(spill, (struct sens_sample_t) { .sens_id = 1, .val = (puint32) num, .num = num }));
+    }
+
+    puint64 committed_next_in = 0;
+
+    for (psize attempt = 0;
+               (attempt < 100) && (2 * SAMPLE_SPILL_GROUP_COMMIT != committed_next_in);
+               attempt++)
+    {
+        p_uthread_sleep(10);
+
+        FILE* const file = fopen(TEST_SPILL_PATH, "rb");
+        PCP_TEST_CHECK(NULL != file);
+        PCP_TEST_CHECK(0 == fseek(file, 16, SEEK_SET)); // next_in, after magic, version and capacity
+        PCP_TEST_CHECK(1 == fread(&committed_next_in, sizeof(committed_next_in), 1, file));
+        fclose(file);
+    }
+
+    PCP_TEST_CHECK(2 * SAMPLE_SPILL_GROUP_COMMIT == committed_next_in);
+    sample_spill_close(spill);
+
+    unlink(TEST_SPILL_PATH);
+
+    // the flusher commits while samples are appended and taken, the segment
+    // reopened afterwards holds exactly the samples not taken
+    spill = sample_spill_open(TEST_SPILL_PATH, 64);
+    PCP_TEST_CHECK(NULL != spill);
+
+    PUThread* const append_th = p_uthread_create(append_task, spill, TRUE);
+    PCP_TEST_CHECK(NULL != append_th);
+
+    psize num_taken = 0;
+    last_num[0]     = 0;
+
+    while (num_taken < TEST_NUM_CONCURRENT - 10)
+    {
+        if (!sample_spill_take(spill, &sample))
+        {
+            p_uthread_yield();
+            continue;
+        }
+
+        PCP_TEST_CHECK(last_num[0] + 1 == sample.num);
+
+        last_num[0] = sample.num;
+        num_taken++;
+    }
+
+    p_uthread_join(append_th);
+    p_uthread_unref(append_th);
+    sample_spill_close(spill);
+
+    spill = sample_spill_open(TEST_SPILL_PATH, 64);
+    PCP_TEST_CHECK(NULL != spill);
+    PCP_TEST_CHECK(10 == sample_spill_pending(spill));
+    PCP_TEST_CHECK(10 == take_in_order(spill, last_num));
+    PCP_TEST_CHECK(TEST_NUM_CONCURRENT == last_num[0]);
+    sample_spill_close(spill);
+
+    unlink(TEST_SPILL_PATH);
+
+    // the pending records of a version 1 segment are migrated, not dropped
+    write_v1_segment(1, 8, 6, 2);
+
+    spill = sample_spill_open(TEST_SPILL_PATH, 8);
+    PCP_TEST_CHECK(NULL != spill);
+    PCP_TEST_CHECK(4 == sample_spill_pending(spill));
+    PCP_TEST_CHECK(TRUE == sample_spill_take(spill, &sample));
+    PCP_TEST_CHECK(2 == sample.sens_id);
+    PCP_TEST_CHECK(1002 == sample.val);
+    PCP_TEST_CHECK(3 == sample.num);
+    PCP_TEST_CHECK(0 == sample.num_absorbed);
+    sample_spill_close(spill);
+
+    spill = sample_spill_open(TEST_SPILL_PATH, 8);
+    PCP_TEST_CHECK(NULL != spill);
+    PCP_TEST_CHECK(3 == sample_spill_pending(spill));
+
+    last_num[1] = 3;
+    PCP_TEST_CHECK(3 == take_in_order(spill, last_num));
+    PCP_TEST_CHECK(6 == last_num[1]);
+    sample_spill_close(spill);
+
+    // a segment of an unknown version or with broken cursors is left alone
+    write_v1_segment(3, 8, 6, 2);
+    PCP_TEST_CHECK(NULL == sample_spill_open(TEST_SPILL_PATH, 8));
+
+    write_v1_segment(2, 8, 11, 2);
+    PCP_TEST_CHECK(NULL == sample_spill_open(TEST_SPILL_PATH, 8));
+
+    // and so is a file that is not a segment at all
+    static const pchar text[] = "not a spill segment, but somebody's notes\n"
+                                "which are longer than a segment header\n";
+
+    FILE* file = fopen(TEST_SPILL_PATH, "wb");
+    PCP_TEST_CHECK(NULL != file);
+    PCP_TEST_CHECK(1 == fwrite(text, sizeof(text), 1, file));
+    fclose(file);
+
+    PCP_TEST_CHECK(NULL == sample_spill_open(TEST_SPILL_PATH, 8));
+
+    pchar read_back[sizeof(text)] = { 0 };
+
+    file = fopen(TEST_SPILL_PATH, "rb");
+    PCP_TEST_CHECK(NULL != file);
+    PCP_TEST_CHECK(1 == fread(read_back, sizeof(read_back), 1, file));
+    PCP_TEST_CHECK(0 == memcmp(text, read_back, sizeof(text)));
+    fclose(file);
+
+    unlink(TEST_SPILL_PATH);
+
+    p_libsys_shutdown();
+
+    return (TRUE == pcp_test_failed) ? 1 : 0;
+}
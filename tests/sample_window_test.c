@@ -0,0 +1,148 @@
+#include <math.h>
+#include <stdlib.h>
+
+#include "sample_window.h"
+
+#include "pcp_test.h"
+
+#define TEST_NUM_SAMPLES 200000
+#define TEST_SLIDING_LEN 100
+#define TEST_TUMBLE_LEN  37
+
+static int
+compare_vals(const void* a, const void* b)
+{
+    const puint32 x = *(const puint32*) a;
+    const puint32 y = *(const puint32*) b;
+
+    return (x < y) ? -1 : (x > y);
+}
+
+/**
+ * Recompute the statistics of a run of values from scratch and compare them
+ * with the ones of the window stage.
+ * @param vals: The values of the window, oldest first.
+ * @param count: The number of values.
+ * @param stats: The statistics of the window stage.
+ */
+static void
+check_stats(const puint32*                      const vals,
+            const psize                               count,
+            const struct sample_window_stats_t* const stats)
+{
+    static puint32 sorted[TEST_SLIDING_LEN];
+    puint64        sum = 0;
+
+    for (psize idx = 0;
+               idx < count;
+               idx++)
+    {
+        sorted[idx] = vals[idx];
+        sum        += vals[idx];
+    }
+
+    qsort(sorted, count, sizeof(puint32), compare_vals);
+
+    const pdouble mean = (pdouble) sum / (pdouble) count;
+    pdouble       m2   = 0.0;
+
+    for (psize idx = 0;
+               idx < count;
+               idx++)
+    {
+        m2 += ((pdouble) vals[idx] - mean) * ((pdouble) vals[idx] - mean);
+    }
+
+    PCP_TEST_CHECK(count == stats->count);
+    PCP_TEST_CHECK(sorted[0] == stats->min);
+    PCP_TEST_CHECK(sorted[count - 1] == stats->max);
+    PCP_TEST_CHECK(sum == stats->sum);
+    PCP_TEST_CHECK(fabs(mean - stats->mean) <= 1e-6 * (1.0 + mean));
+    PCP_TEST_CHECK(fabs(m2 / (pdouble) count - stats->variance) <= 1e-6 * (1.0 + m2 / (pdouble) count));
+
+    // nearest rank
+    PCP_TEST_CHECK(sorted[(count * 50 + 99) / 100 - 1] == stats->p50);
+    PCP_TEST_CHECK(sorted[(count * 90 + 99) / 100 - 1] == stats->p90);
+    PCP_TEST_CHECK(sorted[(count * 99 + 99) / 100 - 1] == stats->p99);
+}
+
+int
+main(void)
+{
+    p_libsys_init();
+
+    struct sample_window_t* window = sample_window_create();
+    PCP_TEST_CHECK(NULL != window);
+
+    char spec[64];
+    snprintf(spec, sizeof(spec), "1:sliding:%d,2:tumbling:%d,3:sliding:1", TEST_SLIDING_LEN, TEST_TUMBLE_LEN);
+    PCP_TEST_CHECK(TRUE == sample_window_configure(window, spec));
+
+    static puint32 history[3][TEST_NUM_SAMPLES];
+    psize          num_fed[3]  = { 0, 0, 0 };
+    psize          num_closed  = 0;
+
+    srand(5);
+
+    for (psize idx = 0;
+               idx < TEST_NUM_SAMPLES;
+               idx++)
+    {
+        struct sens_sample_t         sample = { 0 };
+        struct sample_window_stats_t stats;
+
+        // mostly small values with large outliers, to stress the running variance
+        sample.sens_id = (puint8) (1 + idx % 3);
+        sample.val     = (0 == idx % 7) ? (puint32) rand() : (puint32) (rand() % 1000);
+        sample.num     = idx / 3 + 1;
+
+        const pboolean is_closed = sample_window_feed(window, sample, &stats);
+        const psize    sens_idx  = sample.sens_id - 1;
+
+        history[sens_idx][num_fed[sens_idx]++] = sample.val;
+
+        switch (sample.sens_id) {
+        case 1:
+            PCP_TEST_CHECK(FALSE == is_closed);
+
+            if (0 == idx % 97)
+            {
+                const psize count = (num_fed[0] < TEST_SLIDING_LEN) ? num_fed[0] : TEST_SLIDING_LEN;
+
+                PCP_TEST_CHECK(TRUE == sample_window_get(window, 1, &stats));
+                check_stats(&history[0][num_fed[0] - count], count, &stats);
+            }
+            break;
+
+        case 2:
+            PCP_TEST_CHECK(is_closed == (0 == num_fed[1] % TEST_TUMBLE_LEN));
+
+            if (is_closed)
+            {
+                check_stats(&history[1][num_fed[1] - TEST_TUMBLE_LEN], TEST_TUMBLE_LEN, &stats);
+                num_closed++;
+            }
+            break;
+
+        default:
+            PCP_TEST_CHECK(TRUE == sample_window_get(window, 3, &stats));
+            check_stats(&history[2][num_fed[2] - 1], 1, &stats);
+            break;
+        }
+    }
+
+    PCP_TEST_CHECK(num_fed[1] / TEST_TUMBLE_LEN == num_closed);
+
+    // a reconfigured window starts empty
+    struct sample_window_stats_t stats;
+
+    PCP_TEST_CHECK(TRUE == sample_window_set(window, 1, SAMPLE_WINDOW_TUMBLING, 10));
+    PCP_TEST_CHECK(FALSE == sample_window_get(window, 1, &stats));
+    PCP_TEST_CHECK(FALSE == sample_window_set(window, 1, SAMPLE_WINDOW_SLIDING, 0));
+
+    sample_window_destroy(window);
+
+    p_libsys_shutdown();
+
+    return (TRUE == pcp_test_failed) ? 1 : 0;
+}